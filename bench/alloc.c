@@ -0,0 +1,72 @@
+#include "bench.h"
+
+#include <stdlib.h>
+
+#include "da.h"
+
+/*
+ * Per-request churn: every request creates a handful of small arrays, fills
+ * them and throws them away. The arena is reset at the end of each request.
+ *
+ * The ns/op column is per request.
+ */
+
+#define ARRAYS 8
+#define ELEMS 64
+#define REPEAT 5
+
+static void request(const da_allocator* allocator) {
+	int* arrs[ARRAYS];
+
+	for (int a = 0; a < ARRAYS; ++a) {
+		arrs[a] = da_init_with(sizeof(int), allocator);
+		for (int i = 0; i < ELEMS * (a + 1); ++i) {
+			da_append(arrs[a], i);
+		}
+	}
+	bench_clobber(arrs);
+	for (int a = 0; a < ARRAYS; ++a) {
+		da_free(arrs[a]);
+	}
+}
+
+static double run(const da_allocator* allocator, da_arena* arena, size_t n) {
+	double best = 0.0;
+
+	for (int r = 0; r < REPEAT; ++r) {
+		double start = bench_now();
+		double t;
+		for (size_t i = 0; i < n; ++i) {
+			request(allocator);
+			if (arena != NULL) {
+				da_arena_reset(arena);
+			}
+		}
+		t = bench_now() - start;
+		if (r == 0 || t < best) { best = t; }
+	}
+
+	return best;
+}
+
+int main(int argc, char** argv) {
+	size_t count = 100 * 1000;
+	da_arena arena;
+
+	if (argc > 1) {
+		count = strtoul(argv[1], NULL, 10);
+	}
+
+	da_arena_init(&arena, 64 * 1024);
+
+	bench_header();
+	bench_row("churn", "default", sizeof(int), count, run(NULL, NULL, count));
+	bench_row("churn", "malloc_allocator", sizeof(int), count,
+		run(&da_malloc_allocator, NULL, count));
+	bench_row("churn", "arena", sizeof(int), count,
+		run(&arena.allocator, &arena, count));
+
+	da_arena_release(&arena);
+
+	return 0;
+}
@@ -0,0 +1,65 @@
+#include "bench.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "da.h"
+
+/*
+ * Compares the inline `da_append` fast path against calling `da_append_`
+ * for every element (which is what `da_append` used to expand to).
+ */
+
+struct blob {
+	char bytes[64];
+};
+
+#define REPEAT 5
+
+#define bench_append(type, count)                                             \
+do {                                                                          \
+	double best_inline = 0.0;                                             \
+	double best_call = 0.0;                                               \
+	for (int r = 0; r < REPEAT; ++r) {                                    \
+		type* arr = NULL;                                             \
+		type val;                                                     \
+		double start;                                                 \
+		double t;                                                     \
+		memset(&val, 0x5a, sizeof(val));                              \
+                                                                              \
+		start = bench_now();                                          \
+		for (size_t i = 0; i < (count); ++i) {                        \
+			da_append(arr, val);                                  \
+		}                                                             \
+		bench_clobber(arr);                                           \
+		t = bench_now() - start;                                      \
+		if (r == 0 || t < best_inline) { best_inline = t; }           \
+		da_free(arr);                                                 \
+                                                                              \
+		start = bench_now();                                          \
+		for (size_t i = 0; i < (count); ++i) {                        \
+			da_append_((void**)&arr, &val, sizeof(val));          \
+		}                                                             \
+		bench_clobber(arr);                                           \
+		t = bench_now() - start;                                      \
+		if (r == 0 || t < best_call) { best_call = t; }               \
+		da_free(arr);                                                 \
+	}                                                                     \
+	bench_row("append", "inline", sizeof(type), count, best_inline);      \
+	bench_row("append", "call", sizeof(type), count, best_call);          \
+} while (0)
+
+int main(int argc, char** argv) {
+	size_t count = 10 * 1000 * 1000;
+
+	if (argc > 1) {
+		count = strtoul(argv[1], NULL, 10);
+	}
+
+	bench_header();
+	bench_append(char, count);
+	bench_append(int, count);
+	bench_append(struct blob, count / 10);
+
+	return 0;
+}
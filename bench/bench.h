@@ -0,0 +1,161 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+/* must be included before any system header */
+#define _POSIX_C_SOURCE 200809L
+
+#include <malloc.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "da.h"
+
+/**
+ * @file
+ *
+ * Shared helpers for the benchmarks.
+ *
+ * Every benchmark prints CSV to `stdout`, one row per measurement, so that
+ * results can be collected and compared between versions. Setting
+ * `bench_json` switches to JSON, one object per line.
+ */
+
+/* stops the compiler from optimising away the work being measured */
+#define bench_clobber(p) __asm__ volatile("" : : "g"(p) : "memory")
+
+/**
+ * Returns a monotonic timestamp in nanoseconds.
+ */
+static inline double bench_now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/**
+ * Allocator activity, see `bench_allocator`.
+ */
+struct bench_counts {
+	/** calls to `alloc` and `resize` */
+	size_t allocs;
+	/** calls to `resize` */
+	size_t reallocs;
+	/** bytes copied by `resize` when the block moved */
+	size_t bytes_copied;
+};
+
+static struct bench_counts bench_counts;
+
+/* non-zero to print JSON lines rather than CSV */
+static int bench_json;
+
+static inline void* bench_alloc(const da_allocator* self, size_t bytes) {
+	(void)self;
+	++bench_counts.allocs;
+	return malloc(bytes);
+}
+
+static inline void* bench_resize(
+	const da_allocator* self, void* ptr, size_t old_bytes, size_t new_bytes
+) {
+	void* tmp;
+	(void)self;
+
+	++bench_counts.allocs;
+	++bench_counts.reallocs;
+	tmp = realloc(ptr, new_bytes);
+	if (tmp != NULL && tmp != ptr) {
+		bench_counts.bytes_copied +=
+			old_bytes < new_bytes ? old_bytes : new_bytes;
+	}
+	return tmp;
+}
+
+static inline void bench_release(
+	const da_allocator* self, void* ptr, size_t bytes
+) {
+	(void)self;
+	(void)bytes;
+	free(ptr);
+}
+
+static inline size_t bench_usable(
+	const da_allocator* self, void* ptr, size_t bytes
+) {
+	(void)self;
+	(void)bytes;
+	return malloc_usable_size(ptr);
+}
+
+/**
+ * `malloc` based allocator which records its activity in `bench_counts`.
+ */
+static const da_allocator bench_allocator = {
+	bench_alloc, bench_resize, bench_release, NULL, bench_usable
+};
+
+/**
+ * Prints the CSV column names, unless `BENCH_NO_HEADER` is set in the
+ * environment (so that several benchmarks can be joined into one document).
+ */
+static inline void bench_header(void) {
+	const char* skip = getenv("BENCH_NO_HEADER");
+	if (bench_json || (skip != NULL && *skip != '\0')) {
+		return;
+	}
+	printf("benchmark,variant,elem_size,count,ns_per_op,"
+		"allocs,reallocs,bytes_copied\n");
+}
+
+/**
+ * Prints a single CSV row, including allocator activity.
+ *
+ * @param	name	the name of the benchmark
+ * @param	variant	the implementation / configuration being measured
+ * @param	sz	width of an element in bytes
+ * @param	cnt	number of operations measured
+ * @param	ns	total time taken in nanoseconds
+ * @param	counts	allocator activity (MAY be `NULL` if not measured)
+ */
+static inline void bench_row_counts(
+	const char* name, const char* variant, size_t sz, size_t cnt, double ns,
+	const struct bench_counts* counts
+) {
+	if (bench_json) {
+		printf("{\"benchmark\":\"%s\",\"variant\":\"%s\","
+			"\"elem_size\":%zu,\"count\":%zu,\"ns_per_op\":%.3f",
+			name, variant, sz, cnt, ns / cnt);
+		if (counts != NULL) {
+			printf(",\"allocs\":%zu,\"reallocs\":%zu,"
+				"\"bytes_copied\":%zu",
+				counts->allocs, counts->reallocs,
+				counts->bytes_copied);
+		}
+		printf("}\n");
+		return;
+	}
+
+	printf("%s,%s,%zu,%zu,%.3f,", name, variant, sz, cnt, ns / cnt);
+	if (counts != NULL) {
+		printf("%zu,%zu,%zu\n",
+			counts->allocs, counts->reallocs, counts->bytes_copied);
+	} else {
+		printf(",,\n");
+	}
+}
+
+/**
+ * Prints a single CSV row.
+ *
+ * @see	`bench_row_counts()`
+ */
+static inline void bench_row(
+	const char* name, const char* variant, size_t sz, size_t cnt, double ns
+) {
+	bench_row_counts(name, variant, sz, cnt, ns, NULL);
+}
+
+#endif /* BENCH_H */
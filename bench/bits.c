@@ -0,0 +1,150 @@
+#include "bench.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "da.h"
+
+/*
+ * `max` flags (one in 64 set, at random) stored as a bit array versus a `da`
+ * array of `char`: appending them, counting the set ones (`da_bits_popcount()`
+ * at every instruction set versus `da_count()`, itself vectorised), finding
+ * each set one in turn (`da_bits_find()` versus `memchr`), and combining two
+ * of them (`da_bits_and()` versus a byte loop). Counts are flags; The
+ * variants name the bytes each array takes.
+ */
+
+#define REPEAT 5
+
+#define best_of(best, r, t) do { if ((r) == 0 || (t) < (best)) (best) = (t); } \
+	while (0)
+
+static uint64_t next_random(uint64_t* state) {
+	*state ^= *state << 13;
+	*state ^= *state >> 7;
+	*state ^= *state << 17;
+	return *state;
+}
+
+int main(int argc, char** argv) {
+	size_t max = (size_t)256 * 1024 * 1024;
+	enum da_simd best_level = da_simd_level();
+	uint64_t* bits = NULL;
+	uint64_t* other = NULL;
+	char* flags = NULL;
+	char* other_flags = NULL;
+	double best[8] = {0};
+	double best_count[4] = {0};
+	char variant[64];
+
+	if (argc > 1) {
+		max = strtoul(argv[1], NULL, 10);
+	}
+
+	bench_header();
+	for (int r = 0; r < REPEAT; ++r) {
+		uint64_t state = 88172645463325252ull;
+		double start;
+		double t;
+		size_t n;
+
+		da_free(bits);
+		da_free(flags);
+		bits = NULL;
+		flags = NULL;
+
+		start = bench_now();
+		for (size_t i = 0; i < max; ++i) {
+			da_bits_append(bits, next_random(&state) % 64 == 0);
+		}
+		t = bench_now() - start;
+		best_of(best[0], r, t);
+
+		state = 88172645463325252ull;
+		start = bench_now();
+		for (size_t i = 0; i < max; ++i) {
+			da_append(flags, (char)(next_random(&state) % 64 == 0));
+		}
+		t = bench_now() - start;
+		best_of(best[1], r, t);
+
+		for (int l = DA_SIMD_NONE; l <= (int)best_level; ++l) {
+			da_set_simd_level(l);
+			start = bench_now();
+			n = da_bits_popcount(bits);
+			t = bench_now() - start;
+			bench_clobber((void*)n);
+			best_of(best_count[l], r, t);
+		}
+
+		start = bench_now();
+		n = da_count(flags, (char)1);
+		t = bench_now() - start;
+		bench_clobber((void*)n);
+		best_of(best[2], r, t);
+
+		n = 0;
+		start = bench_now();
+		for (size_t i = da_bits_find(bits, 0); i < max;
+				i = da_bits_find(bits, i + 1)) {
+			++n;
+		}
+		t = bench_now() - start;
+		bench_clobber((void*)n);
+		best_of(best[3], r, t);
+
+		n = 0;
+		start = bench_now();
+		for (char* p = memchr(flags, 1, max); p != NULL;
+				p = memchr(p + 1, 1, flags + max - p - 1)) {
+			++n;
+		}
+		t = bench_now() - start;
+		bench_clobber((void*)n);
+		best_of(best[4], r, t);
+
+		if (r == 0) {
+			da_bits_resize(other, max);
+			da_bits_set_range(other, 0, max / 2, 1);
+			da_assign(other_flags, flags, max);
+			memset(other_flags, 1, max / 2);
+		}
+
+		start = bench_now();
+		da_bits_and(bits, other);
+		t = bench_now() - start;
+		bench_clobber(bits);
+		best_of(best[5], r, t);
+
+		start = bench_now();
+		for (size_t i = 0; i < max; ++i) {
+			flags[i] &= other_flags[i];
+		}
+		t = bench_now() - start;
+		bench_clobber(flags);
+		best_of(best[6], r, t);
+	}
+	da_set_simd_level(best_level);
+
+	snprintf(variant, sizeof(variant), "bits/append/bytes=%zu",
+		da_capacity(bits) * sizeof(*bits));
+	bench_row("bits", variant, 1, max, best[0]);
+	snprintf(variant, sizeof(variant), "char/append/bytes=%zu",
+		da_capacity(flags));
+	bench_row("bits", variant, 1, max, best[1]);
+	for (int l = DA_SIMD_NONE; l <= (int)best_level; ++l) {
+		snprintf(variant, sizeof(variant), "bits/popcount/simd=%d", l);
+		bench_row("bits", variant, 1, max, best_count[l]);
+	}
+	bench_row("bits", "char/da_count", 1, max, best[2]);
+	bench_row("bits", "bits/find", 1, max, best[3]);
+	bench_row("bits", "char/memchr", 1, max, best[4]);
+	bench_row("bits", "bits/and", 1, max, best[5]);
+	bench_row("bits", "char/and", 1, max, best[6]);
+
+	da_free(bits);
+	da_free(other);
+	da_free(flags);
+	da_free(other_flags);
+	return 0;
+}
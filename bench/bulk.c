@@ -0,0 +1,107 @@
+#include "bench.h"
+
+#include <stdlib.h>
+
+#include "da.h"
+
+/*
+ * Single element operations in a loop against their bulk equivalents.
+ *
+ * Inserting / erasing at the front is quadratic when done one element at a
+ * time, so those use a tenth of the element count.
+ */
+
+#define REPEAT 3
+
+static double best(double a, double b, int first) {
+	return first || b < a ? b : a;
+}
+
+int main(int argc, char** argv) {
+	size_t count = 1000 * 1000;
+	size_t small;
+	int* src;
+	double t_single = 0.0;
+	double t_bulk = 0.0;
+
+	if (argc > 1) {
+		count = strtoul(argv[1], NULL, 10);
+	}
+	small = count / 10;
+
+	src = malloc(count * sizeof(*src));
+	for (size_t i = 0; i < count; ++i) {
+		src[i] = (int)i;
+	}
+
+	bench_header();
+
+	for (int r = 0; r < REPEAT; ++r) {
+		int* arr = NULL;
+		double start = bench_now();
+		for (size_t i = 0; i < count; ++i) {
+			da_append(arr, src[i]);
+		}
+		bench_clobber(arr);
+		t_single = best(t_single, bench_now() - start, r == 0);
+		da_free(arr);
+
+		start = bench_now();
+		da_append_n(arr, src, count);
+		bench_clobber(arr);
+		t_bulk = best(t_bulk, bench_now() - start, r == 0);
+		da_free(arr);
+	}
+	bench_row("append", "single", sizeof(int), count, t_single);
+	bench_row("append", "bulk", sizeof(int), count, t_bulk);
+
+	for (int r = 0; r < REPEAT; ++r) {
+		int* arr = NULL;
+		double start;
+		da_append_n(arr, src, small);
+
+		start = bench_now();
+		for (size_t i = 0; i < small; ++i) {
+			da_insert(arr, 0, src[i]);
+		}
+		bench_clobber(arr);
+		t_single = best(t_single, bench_now() - start, r == 0);
+		da_free(arr);
+
+		da_append_n(arr, src, small);
+		start = bench_now();
+		da_insert_n(arr, 0, src, small);
+		bench_clobber(arr);
+		t_bulk = best(t_bulk, bench_now() - start, r == 0);
+		da_free(arr);
+	}
+	bench_row("insert_front", "single", sizeof(int), small, t_single);
+	bench_row("insert_front", "bulk", sizeof(int), small, t_bulk);
+
+	for (int r = 0; r < REPEAT; ++r) {
+		int* arr = NULL;
+		double start;
+		da_append_n(arr, src, 2 * small);
+
+		start = bench_now();
+		for (size_t i = 0; i < small; ++i) {
+			da_erase(arr, 0);
+		}
+		bench_clobber(arr);
+		t_single = best(t_single, bench_now() - start, r == 0);
+		da_free(arr);
+
+		da_append_n(arr, src, 2 * small);
+		start = bench_now();
+		da_erase_range(arr, 0, small);
+		bench_clobber(arr);
+		t_bulk = best(t_bulk, bench_now() - start, r == 0);
+		da_free(arr);
+	}
+	bench_row("erase_front", "single", sizeof(int), small, t_single);
+	bench_row("erase_front", "bulk", sizeof(int), small, t_bulk);
+
+	free(src);
+
+	return 0;
+}
@@ -0,0 +1,151 @@
+#include "bench.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+
+#include "da.h"
+
+/*
+ * Multithreaded per-request churn: every thread serves requests which create
+ * a handful of small arrays, fill them and free them, with and without the
+ * thread cache (`da_set_thread_cache()`).
+ *
+ * For each thread count there is a row with the mean and one with the 99th
+ * percentile latency of a request. The allocs / reallocs columns count calls
+ * to `malloc` / `realloc` from every thread, per run.
+ */
+
+#define ARRAYS 8
+#define ELEMS 16
+#define REPEAT 3
+#define THREADS_MAX 8
+
+#ifdef __GLIBC__
+/* count the calls made through the default allocator, any thread */
+extern void* __libc_malloc(size_t bytes);
+extern void* __libc_realloc(void* ptr, size_t bytes);
+
+static size_t malloc_calls;
+static size_t realloc_calls;
+
+void* malloc(size_t bytes) {
+	__atomic_fetch_add(&malloc_calls, 1, __ATOMIC_RELAXED);
+	return __libc_malloc(bytes);
+}
+
+void* realloc(void* ptr, size_t bytes) {
+	__atomic_fetch_add(&realloc_calls, 1, __ATOMIC_RELAXED);
+	return __libc_realloc(ptr, bytes);
+}
+#endif
+
+struct worker {
+	pthread_t thread;
+	size_t requests;
+	double* latency; /* of each request */
+};
+
+static void request(void) {
+	int* arrs[ARRAYS];
+
+	for (int a = 0; a < ARRAYS; ++a) {
+		arrs[a] = NULL;
+		for (int i = 0; i < ELEMS << (a % 4); ++i) {
+			da_append(arrs[a], i);
+		}
+	}
+	bench_clobber(arrs);
+	for (int a = 0; a < ARRAYS; ++a) {
+		da_free(arrs[a]);
+	}
+}
+
+static void* serve(void* arg) {
+	struct worker* w = arg;
+
+	for (size_t i = 0; i < w->requests; ++i) {
+		double start = bench_now();
+		request();
+		w->latency[i] = bench_now() - start;
+	}
+
+	return NULL;
+}
+
+static int cmp_double(const void* a, const void* b) {
+	double x = *(const double*)a;
+	double y = *(const double*)b;
+	return (x > y) - (x < y);
+}
+
+static void run(const char* variant, int threads, size_t n) {
+	struct worker workers[THREADS_MAX];
+	size_t per = n / threads;
+	double* all = calloc(per * threads, sizeof(*all));
+	double best_mean = 0.0;
+	double best_p99 = 0.0;
+	struct bench_counts counts = {0, 0, 0};
+
+	for (int t = 0; t < threads; ++t) {
+		workers[t].requests = per;
+		workers[t].latency = all + per * t;
+	}
+
+	for (int r = 0; r < REPEAT; ++r) {
+		double mean = 0.0;
+		double p99;
+
+#ifdef __GLIBC__
+		size_t mallocs = malloc_calls;
+		size_t reallocs = realloc_calls;
+#endif
+		for (int t = 0; t < threads; ++t) {
+			pthread_create(&workers[t].thread, NULL, serve, &workers[t]);
+		}
+		for (int t = 0; t < threads; ++t) {
+			pthread_join(workers[t].thread, NULL);
+		}
+#ifdef __GLIBC__
+		counts.allocs = malloc_calls - mallocs + realloc_calls - reallocs;
+		counts.reallocs = realloc_calls - reallocs;
+#endif
+
+		for (size_t i = 0; i < per * threads; ++i) {
+			mean += all[i];
+		}
+		qsort(all, per * threads, sizeof(*all), cmp_double);
+		p99 = all[per * threads * 99 / 100];
+
+		if (r == 0 || mean < best_mean) { best_mean = mean; }
+		if (r == 0 || p99 < best_p99) { best_p99 = p99; }
+	}
+
+	{
+		char name[32];
+		snprintf(name, sizeof(name), "%s/t=%d", variant, threads);
+		bench_row_counts("churn_mt_mean", name, sizeof(int),
+			per * threads, best_mean, &counts);
+		bench_row_counts("churn_mt_p99", name, sizeof(int),
+			per * threads, best_p99 * (per * threads), &counts);
+	}
+
+	free(all);
+}
+
+int main(int argc, char** argv) {
+	size_t count = 100 * 1000;
+
+	if (argc > 1) {
+		count = strtoul(argv[1], NULL, 10);
+	}
+
+	bench_header();
+	for (int threads = 1; threads <= THREADS_MAX; threads *= 2) {
+		da_set_thread_cache(0);
+		run("malloc", threads, count);
+		da_set_thread_cache(256 * 1024);
+		run("cache", threads, count);
+	}
+
+	return 0;
+}
@@ -0,0 +1,138 @@
+#include "bench.h"
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "da.h"
+
+/*
+ * Multi-producer ingestion: 1 to 64 threads append `count` values in total
+ * to one `da_conc`, with and without reserving the whole count up front,
+ * versus the usual alternative of one private array per thread merged into a
+ * single array at the end.
+ *
+ * The ns/op column is per element, including starting the threads and (for
+ * the merge) the final copy.
+ */
+
+#define REPEAT 3
+#define THREADS_MAX 64
+#define BATCH 64
+
+struct producer {
+	pthread_t thread;
+	da_conc* conc;
+	uint64_t* own;
+	size_t count;
+};
+
+static void* produce_conc(void* arg) {
+	struct producer* p = arg;
+
+	for (uint64_t i = 0; i < p->count; ++i) {
+		da_conc_append(p->conc, &i);
+	}
+
+	return NULL;
+}
+
+static void* produce_batch(void* arg) {
+	struct producer* p = arg;
+	uint64_t batch[BATCH];
+	size_t n = 0;
+
+	for (uint64_t i = 0; i < p->count; ++i) {
+		batch[n++] = i;
+		if (n == BATCH) {
+			da_conc_append_n(p->conc, batch, n);
+			n = 0;
+		}
+	}
+	da_conc_append_n(p->conc, batch, n);
+
+	return NULL;
+}
+
+static void* produce_own(void* arg) {
+	struct producer* p = arg;
+
+	for (uint64_t i = 0; i < p->count; ++i) {
+		da_append(p->own, i);
+	}
+
+	return NULL;
+}
+
+static double run(
+	int threads, size_t n, size_t reserve, void* (*produce)(void*)
+) {
+	struct producer producers[THREADS_MAX];
+	double best = 0.0;
+
+	for (int r = 0; r < REPEAT; ++r) {
+		da_conc conc;
+		uint64_t* all = NULL;
+		double start = bench_now();
+		double t;
+
+		int merge = produce == produce_own;
+
+		if (!merge) { da_conc_init(&conc, sizeof(uint64_t), reserve); }
+		for (int i = 0; i < threads; ++i) {
+			producers[i].conc = &conc;
+			producers[i].own = NULL;
+			producers[i].count = n / threads;
+			pthread_create(&producers[i].thread, NULL, produce,
+				&producers[i]);
+		}
+		for (int i = 0; i < threads; ++i) {
+			pthread_join(producers[i].thread, NULL);
+		}
+		if (merge) {
+			for (int i = 0; i < threads; ++i) {
+				da_append_n(all, producers[i].own,
+					da_size(producers[i].own));
+				da_free(producers[i].own);
+			}
+		} else {
+			all = da_conc_to_da(&conc);
+		}
+		bench_clobber(all);
+		t = bench_now() - start;
+
+		da_free(all);
+		if (r == 0 || t < best) { best = t; }
+	}
+
+	return best;
+}
+
+int main(int argc, char** argv) {
+	size_t count = 4 * 1000 * 1000;
+
+	if (argc > 1) {
+		count = strtoul(argv[1], NULL, 10);
+	}
+
+	bench_header();
+	for (int threads = 1; threads <= THREADS_MAX; threads *= 2) {
+		size_t n = count / threads * threads;
+		char variant[32];
+
+		snprintf(variant, sizeof(variant), "conc/t=%d", threads);
+		bench_row("ingest", variant, sizeof(uint64_t), n,
+			run(threads, n, 0, produce_conc));
+		snprintf(variant, sizeof(variant), "conc_reserved/t=%d", threads);
+		bench_row("ingest", variant, sizeof(uint64_t), n,
+			run(threads, n, n, produce_conc));
+		snprintf(variant, sizeof(variant), "conc_batch/t=%d", threads);
+		bench_row("ingest", variant, sizeof(uint64_t), n,
+			run(threads, n, 0, produce_batch));
+		snprintf(variant, sizeof(variant), "private_merge/t=%d", threads);
+		bench_row("ingest", variant, sizeof(uint64_t), n,
+			run(threads, n, 0, produce_own));
+	}
+
+	return 0;
+}
@@ -0,0 +1,136 @@
+#include "bench.h"
+
+#include <stdlib.h>
+
+#include "da.h"
+
+/*
+ * Work queues: a queue of `len` elements in a steady state, each operation
+ * pushing one element at one end and popping one from the other. The deque
+ * functions against the plain array, which shifts every element to insert or
+ * erase at index 0.
+ *
+ * The plain array is O(len) per operation, so it runs fewer operations.
+ */
+
+#define REPEAT 3
+
+static double fifo_deque(size_t len, size_t n) {
+	double best = 0.0;
+
+	for (int r = 0; r < REPEAT; ++r) {
+		int* q = NULL;
+		double start;
+		double t;
+
+		for (size_t i = 0; i < len; ++i) { da_deque_push_back(q, i); }
+		start = bench_now();
+		for (size_t i = 0; i < n; ++i) {
+			da_deque_push_back(q, i);
+			da_deque_pop_front(q);
+		}
+		bench_clobber(q);
+		t = bench_now() - start;
+		da_free(q);
+		if (r == 0 || t < best) { best = t; }
+	}
+
+	return best;
+}
+
+static double fifo_plain(size_t len, size_t n) {
+	double best = 0.0;
+
+	for (int r = 0; r < REPEAT; ++r) {
+		int* q = NULL;
+		double start;
+		double t;
+
+		for (size_t i = 0; i < len; ++i) { da_append(q, i); }
+		start = bench_now();
+		for (size_t i = 0; i < n; ++i) {
+			da_append(q, i);
+			da_erase(q, 0);
+		}
+		bench_clobber(q);
+		t = bench_now() - start;
+		da_free(q);
+		if (r == 0 || t < best) { best = t; }
+	}
+
+	return best;
+}
+
+static double lifo_front_deque(size_t len, size_t n) {
+	double best = 0.0;
+
+	for (int r = 0; r < REPEAT; ++r) {
+		int* q = NULL;
+		double start;
+		double t;
+
+		for (size_t i = 0; i < len; ++i) { da_deque_push_back(q, i); }
+		start = bench_now();
+		for (size_t i = 0; i < n; ++i) {
+			da_deque_push_front(q, i);
+			da_deque_pop_back(q);
+		}
+		bench_clobber(q);
+		t = bench_now() - start;
+		da_free(q);
+		if (r == 0 || t < best) { best = t; }
+	}
+
+	return best;
+}
+
+static double lifo_front_plain(size_t len, size_t n) {
+	double best = 0.0;
+
+	for (int r = 0; r < REPEAT; ++r) {
+		int* q = NULL;
+		double start;
+		double t;
+
+		for (size_t i = 0; i < len; ++i) { da_append(q, i); }
+		start = bench_now();
+		for (size_t i = 0; i < n; ++i) {
+			da_insert(q, 0, i);
+			da_erase(q, da_size(q) - 1);
+		}
+		bench_clobber(q);
+		t = bench_now() - start;
+		da_free(q);
+		if (r == 0 || t < best) { best = t; }
+	}
+
+	return best;
+}
+
+int main(int argc, char** argv) {
+	size_t count = 1000 * 1000;
+
+	if (argc > 1) {
+		count = strtoul(argv[1], NULL, 10);
+	}
+
+	bench_header();
+	for (size_t len = 16; len <= 64 * 1024; len *= 16) {
+		/* keep the O(len) runs to roughly the same total time */
+		size_t slow = count * 16 / len < 1000 ? 1000 : count * 16 / len;
+		char variant[32];
+
+		snprintf(variant, sizeof(variant), "deque/len=%zu", len);
+		bench_row("fifo", variant, sizeof(int), count,
+			fifo_deque(len, count));
+		bench_row("push_front", variant, sizeof(int), count,
+			lifo_front_deque(len, count));
+		snprintf(variant, sizeof(variant), "shift/len=%zu", len);
+		bench_row("fifo", variant, sizeof(int), slow,
+			fifo_plain(len, slow));
+		bench_row("push_front", variant, sizeof(int), slow,
+			lifo_front_plain(len, slow));
+	}
+
+	return 0;
+}
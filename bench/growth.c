@@ -0,0 +1,71 @@
+#include "bench.h"
+
+#include "da.h"
+
+/*
+ * Appends `count` elements one at a time under each growth policy, counting
+ * reallocations and the bytes the allocator had to copy.
+ */
+
+#define REPEAT 3
+
+struct policy {
+	const char* name;
+	da_growth growth;
+};
+
+static const struct policy policies[] = {
+	{ "default", { 2, 3, 2, 8, DA_ROUND_NONE, 0, 0 } },
+	{ "double", { 2, 2, 1, 0, DA_ROUND_NONE, 0, 0 } },
+	{ "initial_1024", { 1024, 3, 2, 8, DA_ROUND_NONE, 0, 0 } },
+	{ "page", { 2, 3, 2, 8, DA_ROUND_PAGE, 0, 0 } },
+	{ "size_class", { 2, 3, 2, 8, DA_ROUND_SIZE_CLASS, 0, 0 } },
+	{ "usable_size", { 2, 3, 2, 8, DA_ROUND_NONE, 1, 0 } },
+	{ "double_page_usable", { 2, 2, 1, 0, DA_ROUND_PAGE, 1, 0 } },
+};
+
+static void run(const struct policy* p, size_t count) {
+	struct bench_counts counts = {0};
+	double best = 0.0;
+
+	da_set_default_growth(&p->growth);
+	for (int r = 0; r < REPEAT; ++r) {
+		int* arr;
+		double start;
+		double t;
+
+		memset(&bench_counts, 0, sizeof(bench_counts));
+		start = bench_now();
+		arr = da_init_with(sizeof(*arr), &bench_allocator);
+		for (size_t i = 0; i < count; ++i) {
+			da_append(arr, (int)i);
+		}
+		bench_clobber(arr);
+		t = bench_now() - start;
+		if (r == 0 || t < best) { best = t; }
+		counts = bench_counts;
+		da_free(arr);
+	}
+	da_set_default_growth(NULL);
+
+	bench_row_counts("growth", p->name, sizeof(int), count, best, &counts);
+}
+
+int main(int argc, char** argv) {
+	size_t counts[] = { 100 * 1000, 10 * 1000 * 1000 };
+	size_t n = sizeof(counts) / sizeof(*counts);
+
+	if (argc > 1) {
+		counts[0] = strtoul(argv[1], NULL, 10);
+		n = 1;
+	}
+
+	bench_header();
+	for (size_t c = 0; c < n; ++c) {
+		for (size_t i = 0; i < sizeof(policies) / sizeof(*policies); ++i) {
+			run(&policies[i], counts[c]);
+		}
+	}
+
+	return 0;
+}
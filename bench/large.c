@@ -0,0 +1,57 @@
+#include "bench.h"
+
+#include <stdint.h>
+
+#include "da.h"
+
+/*
+ * Grows a single array of 8-byte elements to `bytes` (default 1 GiB, give a
+ * size in MiB as the first argument) one append at a time.
+ *
+ * `grow_large` is the whole loop, `grow_large_growth` only the appends that
+ * had to reallocate; Both are reported per element appended.
+ */
+
+static void run(const char* name, size_t threshold, int huge, size_t count) {
+	uint64_t* arr = NULL;
+	double growth = 0.0;
+	double start;
+	double total;
+
+	da_set_mmap_threshold(threshold, huge);
+
+	da_reserve(arr, 1);
+	start = bench_now();
+	for (size_t i = 0; i < count; ++i) {
+		if (da_var_size(arr) == da_var_capacity(arr)) {
+			double t = bench_now();
+			da_append(arr, i);
+			growth += bench_now() - t;
+		} else {
+			da_append(arr, i);
+		}
+	}
+	bench_clobber(arr);
+	total = bench_now() - start;
+	da_free(arr);
+
+	bench_row("grow_large", name, sizeof(*arr), count, total);
+	bench_row("grow_large_growth", name, sizeof(*arr), count, growth);
+}
+
+int main(int argc, char** argv) {
+	size_t mib = 1024;
+	size_t count;
+
+	if (argc > 1) {
+		mib = strtoul(argv[1], NULL, 10);
+	}
+	count = mib * 1024 * 1024 / sizeof(uint64_t);
+
+	bench_header();
+	run("malloc", 0, 0, count);
+	run("mmap", 64 * 1024 * 1024, 0, count);
+	run("mmap_huge", 64 * 1024 * 1024, 1, count);
+
+	return 0;
+}
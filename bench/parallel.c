@@ -0,0 +1,103 @@
+#include "bench.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "da.h"
+
+/*
+ * Scaling of the parallel algorithms from 1 thread to `max` (by default
+ * twice the online CPUs): a sum with `da_parallel_reduce()`, a fill with
+ * `da_parallel_for()` and a copy with `da_assign()`, over `n` `int`s, next
+ * to the serial loops they replace. Counts are elements.
+ */
+
+#define REPEAT 5
+
+static void fill(void* first, size_t cnt, void* ctx) {
+	int* p = first;
+	(void)ctx;
+	for (size_t i = 0; i < cnt; ++i) { p[i] = (int)i; }
+}
+
+static void sum(const void* first, size_t cnt, void* acc, void* ctx) {
+	const int* p = first;
+	int64_t total = 0;
+	(void)ctx;
+	for (size_t i = 0; i < cnt; ++i) { total += p[i]; }
+	*(int64_t*)acc += total;
+}
+
+static void combine(void* acc, const void* partial, void* ctx) {
+	(void)ctx;
+	*(int64_t*)acc += *(const int64_t*)partial;
+}
+
+#define BEST_OF(t, ...)                                                       \
+do {                                                                          \
+	for (int r = 0; r < REPEAT; ++r) {                                    \
+		double start = bench_now();                                   \
+		double elapsed;                                               \
+		__VA_ARGS__;                                                  \
+		elapsed = bench_now() - start;                                \
+		if (r == 0 || elapsed < (t)) { (t) = elapsed; }               \
+	}                                                                     \
+} while (0)
+
+int main(int argc, char** argv) {
+	size_t n = 40 * 1000 * 1000;
+	size_t max = 2 * (size_t)sysconf(_SC_NPROCESSORS_ONLN);
+	int* arr = NULL;
+	int* copy = NULL;
+	char variant[64];
+	double t = 0;
+
+	if (argc > 1) {
+		n = strtoul(argv[1], NULL, 10);
+	}
+	if (argc > 2) {
+		max = strtoul(argv[2], NULL, 10);
+	}
+
+	bench_header();
+	da_reserve(arr, n);
+	for (size_t i = 0; i < n; ++i) { da_append(arr, (int)i); }
+
+	BEST_OF(t, {
+		int64_t total = 0;
+		sum(arr, n, &total, NULL);
+		bench_clobber(&total);
+	});
+	bench_row("sum", "serial", sizeof(int), n, t);
+	BEST_OF(t, { fill(arr, n, NULL); bench_clobber(arr); });
+	bench_row("fill", "serial", sizeof(int), n, t);
+	da_parallel_set_threads(1);
+	BEST_OF(t, { da_assign(copy, arr, n); bench_clobber(copy); });
+	bench_row("assign", "serial", sizeof(int), n, t);
+
+	for (size_t threads = 1; threads <= max; threads *= 2) {
+		da_parallel_set_threads(threads);
+		snprintf(variant, sizeof(variant), "t=%zu",
+			da_parallel_threads());
+		BEST_OF(t, {
+			int64_t total = 0;
+			da_parallel_reduce(arr, &total, sum, combine, NULL);
+			bench_clobber(&total);
+		});
+		bench_row("sum", variant, sizeof(int), n, t);
+		BEST_OF(t, {
+			da_parallel_for(arr, fill, NULL);
+			bench_clobber(arr);
+		});
+		bench_row("fill", variant, sizeof(int), n, t);
+		BEST_OF(t, { da_assign(copy, arr, n); bench_clobber(copy); });
+		bench_row("assign", variant, sizeof(int), n, t);
+	}
+	da_parallel_set_threads(1);
+
+	da_free(copy);
+	da_free(arr);
+
+	return 0;
+}
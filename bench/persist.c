@@ -0,0 +1,112 @@
+#include "bench.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "da.h"
+
+/*
+ * Reloading a saved `int64_t` array of 1 thousand to `max` elements:
+ * `da_mmap()` versus reading the file and `da_assign()`ing it (the copy it
+ * replaces), both alone and followed by a pass over every element (`da_sum()`),
+ * which faults the mapped pages in. The file is in the page cache, as for a
+ * table reloaded at startup. Counts are elements.
+ */
+
+#define REPEAT 5
+#define PATH "/tmp/da_bench_persist.bin"
+
+/* the way to load a table without `da_mmap()` */
+static int64_t* read_assign(size_t n) {
+	int64_t* buf = malloc(n * sizeof(*buf) + 1);
+	int64_t* arr = NULL;
+	FILE* file = fopen(PATH, "rb");
+
+	if (file == NULL || buf == NULL) {
+		exit(1);
+	}
+	fseek(file, 4096, SEEK_SET); /* past the header, a page */
+	if (fread(buf, sizeof(*buf), n, file) != n) {
+		exit(1);
+	}
+	fclose(file);
+
+	da_assign(arr, buf, n);
+	free(buf);
+	return arr;
+}
+
+static void bench_load(size_t n) {
+	int64_t* arr = NULL;
+	double best[5] = {0};
+	char variant[64];
+	static const char* names[] = {
+		"save", "mmap", "mmap+sum", "read+assign", "read+assign+sum"
+	};
+
+	da_reserve(arr, n);
+	for (size_t i = 0; i < n; ++i) {
+		da_append(arr, (int64_t)i);
+	}
+
+	for (int r = 0; r < REPEAT; ++r) {
+		double t[5];
+		double start = bench_now();
+		int64_t* tmp;
+
+		if (da_save(arr, PATH) != 0) {
+			exit(1);
+		}
+		t[0] = bench_now() - start;
+
+		start = bench_now();
+		tmp = da_mmap(PATH, sizeof(*tmp));
+		t[1] = bench_now() - start;
+		bench_clobber(tmp);
+		da_free(tmp);
+
+		start = bench_now();
+		tmp = da_mmap(PATH, sizeof(*tmp));
+		bench_clobber((void*)(intptr_t)da_sum(tmp));
+		t[2] = bench_now() - start;
+		da_free(tmp);
+
+		start = bench_now();
+		tmp = read_assign(n);
+		t[3] = bench_now() - start;
+		bench_clobber(tmp);
+		da_free(tmp);
+
+		start = bench_now();
+		tmp = read_assign(n);
+		bench_clobber((void*)(intptr_t)da_sum(tmp));
+		t[4] = bench_now() - start;
+		da_free(tmp);
+
+		for (int i = 0; i < 5; ++i) {
+			if (r == 0 || t[i] < best[i]) { best[i] = t[i]; }
+		}
+	}
+
+	for (int i = 0; i < 5; ++i) {
+		snprintf(variant, sizeof(variant), "%s/n=%zu", names[i], n);
+		bench_row("persist", variant, sizeof(*arr), n, best[i]);
+	}
+	da_free(arr);
+}
+
+int main(int argc, char** argv) {
+	size_t max = 100 * 1000 * 1000;
+
+	if (argc > 1) {
+		max = strtoul(argv[1], NULL, 10);
+	}
+
+	bench_header();
+	for (size_t n = 1000; n <= max; n *= 10) {
+		bench_load(n);
+	}
+
+	remove(PATH);
+	return 0;
+}
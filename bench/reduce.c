@@ -0,0 +1,102 @@
+#include "bench.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "da.h"
+
+/*
+ * `da_sum()`, `da_minmax()`, `da_scale()`, `da_add_scalar()` and `da_map()`
+ * at every SIMD level, next to the hand written loop they replace, for the
+ * element types of the alignment tests. Counts are elements.
+ */
+
+#define REPEAT 5
+
+static const char* level_names[] = { "scalar", "sse2", "avx2", "avx512" };
+
+#define BEST_OF(t, ...)                                                       \
+do {                                                                          \
+	for (int r = 0; r < REPEAT; ++r) {                                    \
+		double start = bench_now();                                   \
+		double elapsed;                                               \
+		__VA_ARGS__;                                                  \
+		elapsed = bench_now() - start;                                \
+		if (r == 0 || elapsed < (t)) { (t) = elapsed; }               \
+	}                                                                     \
+} while (0)
+
+#define BENCH_TYPE(type, wide, name, n)                                       \
+do {                                                                          \
+	type* arr = NULL;                                                     \
+	char variant[64];                                                     \
+	double t = 0;                                                         \
+	da_reserve(arr, n);                                                   \
+	for (size_t i = 0; i < (n); ++i) { da_append(arr, (type)(i % 100)); } \
+	BEST_OF(t, {                                                          \
+		wide sum = 0;                                                 \
+		for (size_t i = 0; i < (n); ++i) { sum += arr[i]; }           \
+		bench_clobber(&sum);                                          \
+	});                                                                   \
+	snprintf(variant, sizeof(variant), "loop/%s/n=%zu", name, n);         \
+	bench_row("sum", variant, sizeof(type), n, t);                        \
+	for (int l = 0; l <= (int)best; ++l) {                                \
+		type lo, hi;                                                  \
+		da_set_simd_level(l);                                         \
+		snprintf(variant, sizeof(variant), "%s/%s/n=%zu",             \
+			level_names[l], name, n);                             \
+		BEST_OF(t, {                                                  \
+			wide sum = da_sum(arr);                               \
+			bench_clobber(&sum);                                  \
+		});                                                           \
+		bench_row("sum", variant, sizeof(type), n, t);                \
+		BEST_OF(t, {                                                  \
+			da_minmax(arr, &lo, &hi);                             \
+			bench_clobber(&lo);                                   \
+		});                                                           \
+		bench_row("minmax", variant, sizeof(type), n, t);             \
+		BEST_OF(t, { da_scale(arr, 1); bench_clobber(arr); });        \
+		bench_row("scale", variant, sizeof(type), n, t);              \
+		BEST_OF(t, { da_add_scalar(arr, 0); bench_clobber(arr); });   \
+		bench_row("add_scalar", variant, sizeof(type), n, t);         \
+	}                                                                     \
+	da_free(arr);                                                         \
+} while (0)
+
+static void negate_int(void* elem, void* ctx) {
+	(void)ctx;
+	*(int*)elem = -*(int*)elem;
+}
+
+int main(int argc, char** argv) {
+	size_t n = 1000 * 1000;
+	enum da_simd best = da_simd_level();
+
+	if (argc > 1) {
+		n = strtoul(argv[1], NULL, 10);
+	}
+
+	bench_header();
+	BENCH_TYPE(char, int64_t, "char", n);
+	BENCH_TYPE(short, int64_t, "short", n);
+	BENCH_TYPE(int, int64_t, "int", n);
+	BENCH_TYPE(long, int64_t, "long", n);
+	BENCH_TYPE(long long, int64_t, "long long", n);
+	BENCH_TYPE(float, double, "float", n);
+	BENCH_TYPE(double, double, "double", n);
+	BENCH_TYPE(long double, long double, "long double", n);
+	da_set_simd_level(best);
+
+	{
+		int* arr = NULL;
+		char variant[64];
+		double t = 0;
+		for (size_t i = 0; i < n; ++i) { da_append(arr, (int)i); }
+		BEST_OF(t, { da_map(arr, negate_int, NULL); bench_clobber(arr); });
+		snprintf(variant, sizeof(variant), "int/n=%zu", n);
+		bench_row("map", variant, sizeof(int), n, t);
+		da_free(arr);
+	}
+
+	return 0;
+}
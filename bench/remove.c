@@ -0,0 +1,97 @@
+#include "bench.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "da.h"
+
+/*
+ * An expiry sweep: remove every entry whose deadline has passed (about a
+ * quarter of them, spread throughout the array).
+ *
+ * The `da_erase` loop is quadratic, so it is run on a hundredth of the
+ * entries; The ns/op column is per element visited.
+ */
+
+struct entry {
+	uint64_t expiry;
+	uint64_t id;
+};
+
+#define REPEAT 3
+#define NOW 250
+
+static int expired(const void* elem, void* ctx) {
+	return ((const struct entry*)elem)->expiry < *(uint64_t*)ctx;
+}
+
+static double best(double a, double b, int first) {
+	return first || b < a ? b : a;
+}
+
+int main(int argc, char** argv) {
+	size_t count = 10 * 1000 * 1000;
+	size_t small;
+	uint64_t now = NOW;
+	struct entry* src = NULL;
+	struct entry* arr = NULL;
+	double t_erase = 0.0;
+	double t_swap = 0.0;
+	double t_remove_if = 0.0;
+
+	if (argc > 1) {
+		count = strtoul(argv[1], NULL, 10);
+	}
+	small = count / 100;
+
+	srand(42);
+	for (size_t i = 0; i < count; ++i) {
+		struct entry e = { (uint64_t)(rand() % 1000), i };
+		da_append(src, e);
+	}
+
+	bench_header();
+
+	for (int r = 0; r < REPEAT; ++r) {
+		double start;
+
+		da_assign(arr, src, small);
+		start = bench_now();
+		for (size_t i = 0; i < da_size(arr); /**/) {
+			if (arr[i].expiry < now) {
+				da_erase(arr, i);
+			} else {
+				++i;
+			}
+		}
+		bench_clobber(arr);
+		t_erase = best(t_erase, bench_now() - start, r == 0);
+
+		da_assign(arr, src, count);
+		start = bench_now();
+		for (size_t i = 0; i < da_size(arr); /**/) {
+			if (arr[i].expiry < now) {
+				da_swap_remove(arr, i);
+			} else {
+				++i;
+			}
+		}
+		bench_clobber(arr);
+		t_swap = best(t_swap, bench_now() - start, r == 0);
+
+		da_assign(arr, src, count);
+		start = bench_now();
+		da_remove_if(arr, expired, &now);
+		bench_clobber(arr);
+		t_remove_if = best(t_remove_if, bench_now() - start, r == 0);
+	}
+
+	bench_row("expiry_sweep", "erase_loop", sizeof(*arr), small, t_erase);
+	bench_row("expiry_sweep", "swap_remove", sizeof(*arr), count, t_swap);
+	bench_row("expiry_sweep", "remove_if", sizeof(*arr), count, t_remove_if);
+
+	da_free(arr);
+	da_free(src);
+
+	return 0;
+}
@@ -0,0 +1,156 @@
+#include "bench.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "da.h"
+
+/*
+ * Cost of the bookkeeping around allocation.
+ *
+ * First the arithmetic on its own, without any allocation: the size of the
+ * header for an element size, and one growth step. `double` is the floating
+ * point version `da.c` used to have (`ceil` and a factor of 1.5), `integer`
+ * is the one it uses now (with a 32-bit division, as the operands are below
+ * twice the header size); both are copied here, as they are static in `da.c`,
+ * with the size of the library's header (checked against a real array).
+ *
+ * Then the calls around it: `da_reserve` to the current capacity (no growth,
+ * the allocator returns the same block) and `da_append_` through the
+ * out-of-line path, which includes every growth step.
+ */
+
+#define REPEAT 5
+
+#define best_of(best, r, t) do { if ((r) == 0 || (t) < (best)) (best) = (t); } \
+	while (0)
+
+/* hides `x` from the optimiser, so that every iteration computes the result */
+#define opaque(x) __asm__ volatile("" : "+r"(x))
+
+/* `sizeof(struct da_header)` in `da.c`, see `main()` */
+#define HEADER_MIN DA_INLINE_HEADER
+
+static size_t header_size_double(size_t sz) {
+	size_t min_head = HEADER_MIN;
+
+	if (min_head <= sz) { return sz; }
+
+	return ceil(min_head / (double)sz) * sz;
+}
+
+static size_t header_size_integer(size_t sz) {
+	if (HEADER_MIN <= sz) { return sz; }
+
+	return (unsigned)(HEADER_MIN + sz - 1) / (unsigned)sz * sz;
+}
+
+static size_t grow_double(size_t cap) {
+	return cap * 1.5 + 8;
+}
+
+static size_t grow_integer(size_t cap) {
+	size_t whole = cap / 2;
+	size_t part = cap % 2;
+
+	if (whole > ((size_t)-1 - 8 - 3) / 3) {
+		return (size_t)-1;
+	}
+
+	return whole * 3 + part * 3 / 2 + 8;
+}
+
+/* best time of `count` evaluations of `expr`, with `x` an opaque `init` */
+#define bench_arith(best, count, init, expr)                                  \
+do {                                                                          \
+	for (int r = 0; r < REPEAT; ++r) {                                    \
+		size_t acc = 0;                                               \
+		double start = bench_now();                                   \
+		double t;                                                     \
+		for (size_t i = 0; i < (count); ++i) {                        \
+			size_t x = (init);                                    \
+			opaque(x);                                            \
+			acc += (expr);                                        \
+		}                                                             \
+		t = bench_now() - start;                                      \
+		bench_clobber(acc);                                           \
+		best_of(best, r, t);                                          \
+	}                                                                     \
+} while (0)
+
+#define bench_reserve(type, count)                                            \
+do {                                                                          \
+	double best_reserve = 0.0;                                            \
+	double best_append = 0.0;                                             \
+	for (int r = 0; r < REPEAT; ++r) {                                    \
+		type* arr = NULL;                                             \
+		type val = 0;                                                 \
+		double start;                                                 \
+		double t;                                                     \
+                                                                              \
+		da_reserve(arr, 64);                                          \
+		start = bench_now();                                          \
+		for (size_t i = 0; i < (count); ++i) {                        \
+			da_reserve(arr, 64);                                  \
+		}                                                             \
+		bench_clobber(arr);                                           \
+		t = bench_now() - start;                                      \
+		best_of(best_reserve, r, t);                                  \
+		da_free(arr);                                                 \
+                                                                              \
+		start = bench_now();                                          \
+		for (size_t i = 0; i < (count); ++i) {                        \
+			da_append_((void**)&arr, &val, sizeof(val));          \
+		}                                                             \
+		bench_clobber(arr);                                           \
+		t = bench_now() - start;                                      \
+		best_of(best_append, r, t);                                   \
+		da_free(arr);                                                 \
+	}                                                                     \
+	bench_row("reserve", "same_capacity", sizeof(type), count,            \
+		best_reserve);                                                \
+	bench_row("append", "call", sizeof(type), count, best_append);        \
+} while (0)
+
+int main(int argc, char** argv) {
+	size_t count = 10 * 1000 * 1000;
+	static const size_t sizes[] = { 1, 2, 4, 8, 16, 32, HEADER_MIN };
+	DA_INLINE_STORAGE(char, 1) buf;
+	char* arr = da_init_inline(&buf, sizeof(buf), 1);
+	double best = 0.0;
+
+	if (argc > 1) {
+		count = strtoul(argv[1], NULL, 10);
+	}
+
+	/* the data of a `char` array starts right after the header */
+	if (arr == NULL || (size_t)(arr - (char*)&buf) != HEADER_MIN) {
+		fprintf(stderr, "reserve: header is not %d bytes\n", HEADER_MIN);
+		return 1;
+	}
+	da_free(arr);
+
+	bench_header();
+
+	for (size_t s = 0; s < sizeof(sizes) / sizeof(*sizes); ++s) {
+		size_t sz = sizes[s];
+
+		bench_arith(best, count, sz, header_size_double(x));
+		bench_row("header_size", "double", sz, count, best);
+		bench_arith(best, count, sz, header_size_integer(x));
+		bench_row("header_size", "integer", sz, count, best);
+	}
+
+	/* capacities below 2^53, where `double` still holds them exactly */
+	bench_arith(best, count, i, grow_double(x));
+	bench_row("grow", "double", 0, count, best);
+	bench_arith(best, count, i, grow_integer(x));
+	bench_row("grow", "integer", 0, count, best);
+
+	bench_reserve(char, count);
+	bench_reserve(short, count);
+	bench_reserve(int, count);
+	bench_reserve(double, count);
+
+	return 0;
+}
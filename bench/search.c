@@ -0,0 +1,80 @@
+#include "bench.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "da.h"
+
+/*
+ * `da_find()` (needle absent, so the whole array is scanned) and
+ * `da_count()` over arrays of 1 KiB to 1 GiB, at every SIMD level the CPU
+ * supports. Counts are in bytes: `ns_per_op` is nanoseconds per byte, so the
+ * throughput in GB/s is `1 / ns_per_op`.
+ */
+
+/* total bytes scanned per measurement, small arrays are scanned repeatedly */
+#define VOLUME ((size_t)1 << 30)
+#define REPEAT 3
+
+static const char* level_names[] = { "scalar", "sse2", "avx2", "avx512" };
+
+#define BENCH_TYPE(type, name, bytes, fill)                                   \
+do {                                                                          \
+	type* arr = NULL;                                                     \
+	size_t n = (bytes) / sizeof(type);                                    \
+	size_t rounds = VOLUME / (bytes);                                     \
+	da_reserve(arr, n);                                                   \
+	for (size_t i = 0; i < n; ++i) { da_append(arr, (type)(fill)); }      \
+	for (int l = 0; l <= (int)best; ++l) {                                \
+		double t_find = 0;                                            \
+		double t_count = 0;                                           \
+		char variant[64];                                             \
+		da_set_simd_level(l);                                         \
+		for (int r = 0; r < REPEAT; ++r) {                            \
+			double start = bench_now();                           \
+			double t;                                             \
+			for (size_t k = 0; k < rounds; ++k) {                 \
+				type* p = da_find(arr, (type)-1);             \
+				bench_clobber(p);                             \
+			}                                                     \
+			t = bench_now() - start;                              \
+			if (r == 0 || t < t_find) { t_find = t; }             \
+			start = bench_now();                                  \
+			for (size_t k = 0; k < rounds; ++k) {                 \
+				size_t c = da_count(arr, (type)1);            \
+				bench_clobber(c);                             \
+			}                                                     \
+			t = bench_now() - start;                              \
+			if (r == 0 || t < t_count) { t_count = t; }           \
+		}                                                             \
+		snprintf(variant, sizeof(variant), "%s/%s/bytes=%zu",         \
+			level_names[l], name, (size_t)(bytes));               \
+		bench_row("find", variant, sizeof(type), rounds * (bytes),    \
+			t_find);                                              \
+		bench_row("count", variant, sizeof(type), rounds * (bytes),   \
+			t_count);                                             \
+	}                                                                     \
+	da_free(arr);                                                         \
+} while (0)
+
+int main(int argc, char** argv) {
+	size_t max_bytes = (size_t)1 << 30;
+	enum da_simd best = da_simd_level();
+
+	if (argc > 1) {
+		max_bytes = strtoul(argv[1], NULL, 10);
+	}
+
+	bench_header();
+	for (size_t bytes = 1024; bytes <= max_bytes; bytes *= 32) {
+		BENCH_TYPE(uint8_t, "u8", bytes, i % 7);
+		BENCH_TYPE(uint16_t, "u16", bytes, i % 7);
+		BENCH_TYPE(uint32_t, "u32", bytes, i % 7);
+		BENCH_TYPE(uint64_t, "u64", bytes, i % 7);
+		BENCH_TYPE(float, "f32", bytes, i % 7);
+		BENCH_TYPE(double, "f64", bytes, i % 7);
+	}
+	da_set_simd_level(best);
+
+	return 0;
+}
@@ -0,0 +1,112 @@
+#include "bench.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "da.h"
+
+/*
+ * Segmented versus contiguous arrays: appending `n` elements (the segmented
+ * array never copies), then random reads through the index lookup, a
+ * sequential scan, and exporting the segmented array to a contiguous one.
+ */
+
+#define REPEAT 5
+
+/* random indices below `n`, generated up front */
+static size_t* random_indices(size_t n, size_t count) {
+	size_t* idx = malloc(count * sizeof(*idx));
+	uint64_t x = 88172645463325252ull;
+
+	for (size_t i = 0; i < count; ++i) {
+		x ^= x << 13;
+		x ^= x >> 7;
+		x ^= x << 17;
+		idx[i] = x % n;
+	}
+
+	return idx;
+}
+
+static void bench_size(size_t n) {
+	size_t* idx = random_indices(n, n);
+	double best[7] = {0};
+	char variant[64];
+
+	for (int r = 0; r < REPEAT; ++r) {
+		uint64_t* arr = NULL;
+		uint64_t** seg = NULL;
+		uint64_t* flat;
+		uint64_t sum = 0;
+		double t[7];
+		double start;
+
+		start = bench_now();
+		for (size_t i = 0; i < n; ++i) { da_append(arr, i); }
+		bench_clobber(arr);
+		t[0] = bench_now() - start;
+
+		start = bench_now();
+		for (size_t i = 0; i < n; ++i) { da_seg_append(seg, i); }
+		bench_clobber(seg);
+		t[1] = bench_now() - start;
+
+		start = bench_now();
+		for (size_t i = 0; i < n; ++i) { sum += arr[idx[i]]; }
+		bench_clobber(&sum);
+		t[2] = bench_now() - start;
+
+		start = bench_now();
+		for (size_t i = 0; i < n; ++i) { sum += da_seg_get(seg, idx[i]); }
+		bench_clobber(&sum);
+		t[3] = bench_now() - start;
+
+		start = bench_now();
+		for (size_t i = 0; i < n; ++i) { sum += arr[i]; }
+		bench_clobber(&sum);
+		t[4] = bench_now() - start;
+
+		start = bench_now();
+		for (size_t i = 0; i < n; ++i) { sum += da_seg_get(seg, i); }
+		bench_clobber(&sum);
+		t[5] = bench_now() - start;
+
+		start = bench_now();
+		flat = da_seg_to_da(seg);
+		bench_clobber(flat);
+		t[6] = bench_now() - start;
+
+		for (int i = 0; i < 7; ++i) {
+			if (r == 0 || t[i] < best[i]) { best[i] = t[i]; }
+		}
+		da_free(flat);
+		da_free(arr);
+		da_seg_free(seg);
+	}
+	free(idx);
+
+	snprintf(variant, sizeof(variant), "da/n=%zu", n);
+	bench_row("append", variant, sizeof(uint64_t), n, best[0]);
+	bench_row("random_read", variant, sizeof(uint64_t), n, best[2]);
+	bench_row("scan", variant, sizeof(uint64_t), n, best[4]);
+	snprintf(variant, sizeof(variant), "da_seg/n=%zu", n);
+	bench_row("append", variant, sizeof(uint64_t), n, best[1]);
+	bench_row("random_read", variant, sizeof(uint64_t), n, best[3]);
+	bench_row("scan", variant, sizeof(uint64_t), n, best[5]);
+	bench_row("to_da", variant, sizeof(uint64_t), n, best[6]);
+}
+
+int main(int argc, char** argv) {
+	size_t count = 10 * 1000 * 1000;
+
+	if (argc > 1) {
+		count = strtoul(argv[1], NULL, 10);
+	}
+
+	bench_header();
+	for (size_t n = 1000; n <= count; n *= 100) {
+		bench_size(n);
+	}
+
+	return 0;
+}
@@ -0,0 +1,98 @@
+#include "bench.h"
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "da.h"
+
+/*
+ * Handing a snapshot of a 1M `int64_t` array to 1 to 32 reader threads:
+ * `da_share()` versus a `da_assign()` copy per reader. Rows are the cost of
+ * taking the snapshots (per snapshot), then of the readers summing theirs
+ * concurrently while the writer appends (per element read). The snapshots'
+ * memory is the bytes copied, plus one 16 byte count for the first share.
+ */
+
+#define REPEAT 5
+#define COUNT ((size_t)1000 * 1000)
+
+static void* read_snapshot(void* arg) {
+	int64_t* snap = arg;
+	int64_t sum = 0;
+
+	for (size_t i = 0; i < da_size(snap); ++i) {
+		sum += snap[i];
+	}
+	bench_clobber((void*)(intptr_t)sum);
+	da_free(snap);
+	return NULL;
+}
+
+static void bench_readers(size_t readers, int copy) {
+	pthread_t threads[32];
+	int64_t* snaps[32];
+	struct bench_counts counts = {0};
+	double best_snap = 0;
+	double best_read = 0;
+	char variant[64];
+
+	for (int r = 0; r < REPEAT; ++r) {
+		int64_t* arr = NULL;
+		double start;
+		double t;
+
+		for (size_t i = 0; i < COUNT; ++i) {
+			da_append(arr, (int64_t)i);
+		}
+
+		start = bench_now();
+		for (size_t i = 0; i < readers; ++i) {
+			snaps[i] = NULL;
+			if (copy) {
+				da_assign(snaps[i], arr, da_size(arr));
+			} else {
+				snaps[i] = da_share(arr);
+			}
+		}
+		t = bench_now() - start;
+		if (r == 0 || t < best_snap) { best_snap = t; }
+
+		start = bench_now();
+		for (size_t i = 0; i < readers; ++i) {
+			pthread_create(&threads[i], NULL, read_snapshot, snaps[i]);
+		}
+		/* the writer carries on, copying the array if still shared */
+		for (int i = 0; i < 1000; ++i) {
+			da_append(arr, i);
+		}
+		for (size_t i = 0; i < readers; ++i) {
+			pthread_join(threads[i], NULL);
+		}
+		t = bench_now() - start;
+		if (r == 0 || t < best_read) { best_read = t; }
+
+		da_free(arr);
+	}
+
+	counts.allocs = copy ? readers : 1;
+	counts.bytes_copied = copy ? readers * COUNT * sizeof(int64_t) : 0;
+	snprintf(variant, sizeof(variant), "%s/snapshot/readers=%zu",
+		copy ? "assign" : "share", readers);
+	bench_row_counts("share", variant, sizeof(int64_t), readers, best_snap,
+		&counts);
+	snprintf(variant, sizeof(variant), "%s/read/readers=%zu",
+		copy ? "assign" : "share", readers);
+	bench_row("share", variant, sizeof(int64_t), readers * COUNT,
+		best_read);
+}
+
+int main(void) {
+	bench_header();
+	for (size_t readers = 1; readers <= 32; readers *= 2) {
+		bench_readers(readers, 0);
+		bench_readers(readers, 1);
+	}
+
+	return 0;
+}
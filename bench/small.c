@@ -0,0 +1,92 @@
+#include "bench.h"
+
+#include <stdlib.h>
+
+#include "da.h"
+
+/*
+ * Short-lived small arrays in a hot function: each call collects up to
+ * ELEMS values into a fresh array, uses them and throws the array away.
+ *
+ * The ns/op column is per call.
+ */
+
+#define ELEMS 16
+#define REPEAT 5
+
+/* keeps the calls from being merged into the loop */
+static volatile int bench_len = ELEMS;
+
+static long hot_heap(int seed) {
+	int* arr = NULL;
+	long sum = 0;
+
+	for (int i = 0; i < bench_len; ++i) {
+		da_append(arr, seed + i);
+	}
+	bench_clobber(arr);
+	for (size_t i = 0; i < da_size(arr); ++i) {
+		sum += arr[i];
+	}
+	da_free(arr);
+
+	return sum;
+}
+
+static long hot_inline(int seed) {
+	DA_INLINE_STORAGE(int, ELEMS) buf;
+	int* arr = da_init_inline(&buf, sizeof(buf), sizeof(*arr));
+	long sum = 0;
+
+	for (int i = 0; i < bench_len; ++i) {
+		da_append(arr, seed + i);
+	}
+	bench_clobber(arr);
+	for (size_t i = 0; i < da_size(arr); ++i) {
+		sum += arr[i];
+	}
+	da_free(arr);
+
+	return sum;
+}
+
+static double run(long (*hot)(int), size_t n) {
+	double best = 0.0;
+	long sink = 0;
+
+	for (int r = 0; r < REPEAT; ++r) {
+		double start = bench_now();
+		double t;
+		for (size_t i = 0; i < n; ++i) {
+			sink += hot((int)i);
+		}
+		t = bench_now() - start;
+		if (r == 0 || t < best) { best = t; }
+	}
+	bench_clobber(&sink);
+
+	return best;
+}
+
+int main(int argc, char** argv) {
+	size_t count = 1000 * 1000;
+
+	if (argc > 1) {
+		count = strtoul(argv[1], NULL, 10);
+	}
+
+	bench_header();
+	for (int len = 4; len <= ELEMS * 2; len *= 2) {
+		char heap[32];
+		char inl[32];
+
+		/* twice ELEMS shows the cost of moving to the heap */
+		bench_len = len;
+		snprintf(heap, sizeof(heap), "heap/n=%d", len);
+		snprintf(inl, sizeof(inl), "inline/n=%d", len);
+		bench_row("small", heap, sizeof(int), count, run(hot_heap, count));
+		bench_row("small", inl, sizeof(int), count, run(hot_inline, count));
+	}
+
+	return 0;
+}
@@ -0,0 +1,111 @@
+#include "bench.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "da.h"
+
+/*
+ * A scan of one field (summing a `float` or an `int64_t`) over `max` records
+ * of 40 bytes, stored as a `da` array of structs versus a `DA_SOA_DEFINE()`
+ * container; The columns only pull in the field being read. Also appending
+ * the records. Counts are records.
+ */
+
+#define REPEAT 5
+
+#define RECORD_FIELDS(X)                                                      \
+	X(double, x) X(double, y) X(double, z) X(float, mass) X(int32_t, id)  \
+	X(int64_t, stamp)
+DA_SOA_DEFINE(records, RECORD_FIELDS)
+
+#define best_of(best, r, t) do { if ((r) == 0 || (t) < (best)) (best) = (t); } \
+	while (0)
+
+int main(int argc, char** argv) {
+	size_t max = 10 * 1000 * 1000;
+	records_row* aos = NULL;
+	records soa = {0};
+	double best[6] = {0};
+	static const char* names[] = {
+		"aos/append", "soa/append", "aos/sum_mass", "soa/sum_mass",
+		"aos/sum_stamp", "soa/sum_stamp"
+	};
+
+	if (argc > 1) {
+		max = strtoul(argv[1], NULL, 10);
+	}
+
+	bench_header();
+	for (int r = 0; r < REPEAT; ++r) {
+		double start;
+		double t;
+		float mass;
+		int64_t stamp;
+
+		records_free(&soa);
+		da_free(aos);
+
+		start = bench_now();
+		for (size_t i = 0; i < max; ++i) {
+			records_row row = { i, -(double)i, 0.5, (float)(i % 7),
+				(int32_t)i, (int64_t)i * 3 };
+			da_append(aos, row);
+		}
+		t = bench_now() - start;
+		best_of(best[0], r, t);
+
+		start = bench_now();
+		for (size_t i = 0; i < max; ++i) {
+			records_row row = { i, -(double)i, 0.5, (float)(i % 7),
+				(int32_t)i, (int64_t)i * 3 };
+			records_append(&soa, row);
+		}
+		t = bench_now() - start;
+		best_of(best[1], r, t);
+
+		start = bench_now();
+		mass = 0;
+		for (size_t i = 0; i < da_size(aos); ++i) {
+			mass += aos[i].mass;
+		}
+		t = bench_now() - start;
+		bench_clobber(&mass);
+		best_of(best[2], r, t);
+
+		start = bench_now();
+		mass = 0;
+		for (size_t i = 0; i < soa.size; ++i) {
+			mass += soa.mass[i];
+		}
+		t = bench_now() - start;
+		bench_clobber(&mass);
+		best_of(best[3], r, t);
+
+		start = bench_now();
+		stamp = 0;
+		for (size_t i = 0; i < da_size(aos); ++i) {
+			stamp += aos[i].stamp;
+		}
+		t = bench_now() - start;
+		bench_clobber(&stamp);
+		best_of(best[4], r, t);
+
+		start = bench_now();
+		stamp = 0;
+		for (size_t i = 0; i < soa.size; ++i) {
+			stamp += soa.stamp[i];
+		}
+		t = bench_now() - start;
+		bench_clobber(&stamp);
+		best_of(best[5], r, t);
+	}
+
+	for (int i = 0; i < 6; ++i) {
+		bench_row("soa", names[i], sizeof(records_row), max, best[i]);
+	}
+
+	records_free(&soa);
+	da_free(aos);
+	return 0;
+}
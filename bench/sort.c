@@ -0,0 +1,111 @@
+#include "bench.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "da.h"
+
+/*
+ * `da_sort()` (radix) and a `DA_DEFINE_SORT()` introsort versus `qsort`, for
+ * `int`, `int64_t` and `double` keys from 1 thousand to `max` elements, with
+ * keys that are random, drawn from 16 values, sorted and reversed. Counts are
+ * elements sorted; each measurement sorts a fresh copy.
+ */
+
+#define REPEAT 3
+
+enum shape { RANDOM, FEW, SORTED, REVERSED, SHAPES };
+static const char* shape_names[] = { "random", "few", "sorted", "reversed" };
+
+static uint64_t next_random(uint64_t* x) {
+	*x ^= *x << 13;
+	*x ^= *x >> 7;
+	*x ^= *x << 17;
+	return *x;
+}
+
+#define less_than(x, y) ((x) < (y))
+DA_DEFINE_SORT(intro_int, int, less_than)
+DA_DEFINE_SORT(intro_i64, int64_t, less_than)
+DA_DEFINE_SORT(intro_f64, double, less_than)
+
+#define define_compare(name, type)                                            \
+static int name(const void* a, const void* b) {                               \
+	type x = *(const type*)a;                                             \
+	type y = *(const type*)b;                                             \
+	return (x > y) - (x < y);                                             \
+}
+
+define_compare(compare_int, int)
+define_compare(compare_i64, int64_t)
+define_compare(compare_f64, double)
+
+#define BENCH_SORT(type, name, intro, compare, n, shape)                      \
+do {                                                                          \
+	type* keys = NULL;                                                    \
+	type* work = NULL;                                                    \
+	uint64_t x = 88172645463325252ull;                                    \
+	double best[3] = {0};                                                 \
+	char variant[64];                                                     \
+	da_reserve(keys, n);                                                  \
+	for (size_t i = 0; i < (n); ++i) {                                    \
+		int64_t r = (int64_t)(next_random(&x) >> 1);                  \
+		type k = (shape) == RANDOM ? (type)(r - INT64_MAX / 2)        \
+			: (shape) == FEW ? (type)(r % 16)                     \
+			: (shape) == SORTED ? (type)i : (type)((n) - i);      \
+		da_append(keys, k);                                           \
+	}                                                                     \
+	for (int r = 0; r < REPEAT; ++r) {                                    \
+		double t[3];                                                  \
+		double start;                                                 \
+		da_assign(work, keys, n);                                     \
+		start = bench_now();                                          \
+		da_sort(work);                                                \
+		t[0] = bench_now() - start;                                   \
+		da_assign(work, keys, n);                                     \
+		start = bench_now();                                          \
+		intro(work);                                                  \
+		t[1] = bench_now() - start;                                   \
+		da_assign(work, keys, n);                                     \
+		start = bench_now();                                          \
+		qsort(work, n, sizeof(type), compare);                        \
+		t[2] = bench_now() - start;                                   \
+		bench_clobber(work);                                          \
+		for (int i = 0; i < 3; ++i) {                                 \
+			if (r == 0 || t[i] < best[i]) { best[i] = t[i]; }     \
+		}                                                             \
+	}                                                                     \
+	snprintf(variant, sizeof(variant), "radix/%s/%s/n=%zu",               \
+		name, shape_names[shape], (size_t)(n));                       \
+	bench_row("sort", variant, sizeof(type), n, best[0]);                 \
+	snprintf(variant, sizeof(variant), "introsort/%s/%s/n=%zu",           \
+		name, shape_names[shape], (size_t)(n));                       \
+	bench_row("sort", variant, sizeof(type), n, best[1]);                 \
+	snprintf(variant, sizeof(variant), "qsort/%s/%s/n=%zu",               \
+		name, shape_names[shape], (size_t)(n));                       \
+	bench_row("sort", variant, sizeof(type), n, best[2]);                 \
+	da_free(work);                                                        \
+	da_free(keys);                                                        \
+} while (0)
+
+int main(int argc, char** argv) {
+	size_t max = 1000 * 1000;
+
+	if (argc > 1) {
+		max = strtoul(argv[1], NULL, 10);
+	}
+
+	bench_header();
+	for (size_t n = 1000; n <= max; n *= 10) {
+		for (int shape = 0; shape < SHAPES; ++shape) {
+			BENCH_SORT(int, "int", intro_int, compare_int, n,
+				shape);
+			BENCH_SORT(int64_t, "int64", intro_i64, compare_i64,
+				n, shape);
+			BENCH_SORT(double, "double", intro_f64, compare_f64,
+				n, shape);
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,157 @@
+#include "bench.h"
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "da.h"
+
+/*
+ * Loading `uint64_t`s from a local file (in the page cache) and from a pipe
+ * fed by a child process: `da_read_fd()` straight into the spare capacity,
+ * until the end or sized up front from `fstat`, versus `read()` into a
+ * scratch buffer followed by `da_append_n()` or `da_assign()`. Counts are
+ * elements; `max` is the number of bytes transferred.
+ */
+
+#define REPEAT 5
+#define PATH "/tmp/da_bench_stream.bin"
+#define SCRATCH ((size_t)1024 * 1024)
+
+enum variant { READ_ALL, READ_SIZED, APPEND_N, ASSIGN, VARIANTS };
+static const char* variant_names[] = {
+	"da_read_fd/all", "da_read_fd/sized", "read+append_n", "read+assign"
+};
+
+static uint64_t* load(int fd, enum variant v) {
+	uint64_t* arr = NULL;
+	char* buf = NULL;
+	size_t used = 0;
+	struct stat st;
+	ssize_t n;
+
+	switch (v) {
+	case READ_ALL:
+		if (da_read_fd(arr, fd, DA_READ_ALL) < 0) { exit(1); }
+		return arr;
+	case READ_SIZED:
+		fstat(fd, &st);
+		if (da_read_fd(arr, fd, st.st_size / sizeof(*arr)) < 0) {
+			exit(1);
+		}
+		return arr;
+	case APPEND_N:
+		buf = malloc(SCRATCH);
+		while ((n = read(fd, buf, SCRATCH)) > 0) {
+			/* assumes whole elements, which holds for these sources */
+			da_append_n(arr, (uint64_t*)buf, n / sizeof(*arr));
+		}
+		free(buf);
+		return arr;
+	case ASSIGN:
+		/* the whole file in a buffer, grown like the array would be */
+		buf = malloc(SCRATCH);
+		for (size_t cap = SCRATCH;
+				(n = read(fd, buf + used, cap - used)) > 0; ) {
+			used += n;
+			if (used == cap) {
+				cap *= 2;
+				buf = realloc(buf, cap);
+			}
+		}
+		da_assign(arr, (uint64_t*)buf, used / sizeof(*arr));
+		free(buf);
+		return arr;
+	default:
+		return NULL;
+	}
+}
+
+/* the read end of a pipe, written by a child process */
+static int spawn_writer(const uint64_t* data, size_t bytes) {
+	int fds[2];
+
+	if (pipe(fds) != 0) { exit(1); }
+	if (fork() == 0) {
+		close(fds[0]);
+		for (size_t off = 0; off < bytes; ) {
+			size_t chunk = bytes - off < 65536 ? bytes - off : 65536;
+			ssize_t n = write(fds[1], (const char*)data + off, chunk);
+			if (n <= 0) { _exit(1); }
+			off += n;
+		}
+		_exit(0);
+	}
+
+	close(fds[1]);
+	return fds[0];
+}
+
+int main(int argc, char** argv) {
+	size_t max = (size_t)256 * 1024 * 1024;
+	uint64_t* data = NULL;
+	char variant[64];
+	int fd;
+
+	if (argc > 1) {
+		max = strtoul(argv[1], NULL, 10);
+	}
+
+	bench_header();
+	for (size_t bytes = 64 * 1024; bytes <= max; bytes *= 16) {
+		size_t n = bytes / sizeof(*data);
+
+		for (size_t i = da_size(data); i < n; ++i) {
+			da_append(data, i * 0x9e3779b97f4a7c15ull);
+		}
+		fd = open(PATH, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		write(fd, data, bytes);
+		close(fd);
+
+		for (int v = 0; v < VARIANTS; ++v) {
+			double best_file = 0;
+			double best_pipe = 0;
+			for (int r = 0; r < REPEAT; ++r) {
+				double start = bench_now();
+				uint64_t* arr;
+				double t;
+
+				fd = open(PATH, O_RDONLY);
+				arr = load(fd, v);
+				t = bench_now() - start;
+				close(fd);
+				if (da_size(arr) != n) { exit(1); }
+				bench_clobber(arr);
+				da_free(arr);
+				if (r == 0 || t < best_file) { best_file = t; }
+
+				/* no size up front from a pipe */
+				if (v == READ_SIZED) { continue; }
+				fd = spawn_writer(data, bytes);
+				start = bench_now();
+				arr = load(fd, v);
+				t = bench_now() - start;
+				close(fd);
+				wait(NULL);
+				if (da_size(arr) != n) { exit(1); }
+				da_free(arr);
+				if (r == 0 || t < best_pipe) { best_pipe = t; }
+			}
+
+			snprintf(variant, sizeof(variant), "file/%s/bytes=%zu",
+				variant_names[v], bytes);
+			bench_row("stream", variant, sizeof(*data), n, best_file);
+			if (v == READ_SIZED) { continue; }
+			snprintf(variant, sizeof(variant), "pipe/%s/bytes=%zu",
+				variant_names[v], bytes);
+			bench_row("stream", variant, sizeof(*data), n, best_pipe);
+		}
+	}
+
+	da_free(data);
+	remove(PATH);
+	return 0;
+}
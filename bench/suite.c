@@ -0,0 +1,226 @@
+#include "bench.h"
+
+#include <stdint.h>
+
+#include "da.h"
+
+/*
+ * The core operations across element sizes (1, 4, 8, 64 and 256 bytes) and
+ * array sizes (1e2 to 1e8 elements).
+ *
+ * The `variant` column holds the array size, `count` the number of operations
+ * timed and `ns_per_op` the (best of `REPEAT`) time per operation. Allocator
+ * activity is recorded through `bench_allocator`.
+ *
+ * - `append`: `da_append` from empty to n elements
+ * - `insert_*` / `erase_*`: single element inserts / erases at the front,
+ *   middle or back of an array of n elements
+ * - `assign`: `da_assign` of n elements, per element
+ * - `reserve`: `da_reserve` of a new array to n elements
+ * - `at`: `da_at` over an array of n elements, per access
+ *
+ * Options:
+ * - `--json`: print JSON lines instead of CSV
+ * - `--max-bytes N`: skip arrays larger than N bytes (default 512 MiB)
+ * - `--max-count N`: skip arrays of more than N elements (default 1e8)
+ */
+
+#define REPEAT 3
+
+/* minimum number of elements processed per measurement */
+#define MIN_WORK 1000000
+
+/* bytes moved per measurement of the quadratic operations */
+#define MOVE_BUDGET ((size_t)256 * 1024 * 1024)
+
+static size_t max_bytes = (size_t)512 * 1024 * 1024;
+static size_t max_count = 100 * 1000 * 1000;
+
+/* timing state, see `measure_*` */
+static double best_ns;
+static struct bench_counts best_counts;
+
+static void measure_begin(void) {
+	memset(&bench_counts, 0, sizeof(bench_counts));
+}
+
+static void measure_end(int r, double ns) {
+	if (r == 0 || ns < best_ns) {
+		best_ns = ns;
+		best_counts = bench_counts;
+	}
+}
+
+static void report(const char* name, size_t sz, size_t n, size_t ops) {
+	char variant[32];
+	snprintf(variant, sizeof(variant), "n=%zu", n);
+	bench_row_counts(name, variant, sz, ops, best_ns, &best_counts);
+}
+
+#define DEFINE_SUITE(N)                                                       \
+struct elem##N {                                                              \
+	unsigned char b[N];                                                   \
+};                                                                            \
+                                                                              \
+static void fill##N(struct elem##N** arr, size_t n) {                         \
+	struct elem##N e;                                                     \
+	memset(&e, 0x5a, sizeof(e));                                          \
+	*arr = da_init_with(sizeof(e), &bench_allocator);                     \
+	da_reserve(*arr, n);                                                  \
+	for (size_t i = 0; i < n; ++i) {                                      \
+		da_append(*arr, e);                                           \
+	}                                                                     \
+}                                                                             \
+                                                                              \
+static void shift##N(const char* name, size_t n, int insert, int where) {     \
+	size_t k = MOVE_BUDGET / (n * N);                                     \
+	struct elem##N e;                                                     \
+	memset(&e, 0xa5, sizeof(e));                                          \
+	if (k < 1) { k = 1; }                                                 \
+	if (k > 1000) { k = 1000; }                                           \
+	if (k > n) { k = n; }                                                 \
+	for (int r = 0; r < REPEAT; ++r) {                                    \
+		struct elem##N* arr;                                          \
+		double start;                                                 \
+		fill##N(&arr, n);                                             \
+		measure_begin();                                              \
+		start = bench_now();                                          \
+		for (size_t i = 0; i < k; ++i) {                              \
+			size_t size = da_var_size(arr);                       \
+			size_t idx = where == 0 ? 0                           \
+				: where == 1 ? size / 2                       \
+				: insert ? size : size - 1;                   \
+			if (insert) {                                         \
+				da_insert(arr, idx, e);                       \
+			} else {                                              \
+				da_erase(arr, idx);                           \
+			}                                                     \
+		}                                                             \
+		bench_clobber(arr);                                           \
+		measure_end(r, bench_now() - start);                          \
+		da_free(arr);                                                 \
+	}                                                                     \
+	report(name, N, n, k);                                                \
+}                                                                             \
+                                                                              \
+static void run##N(size_t n) {                                                \
+	size_t reps = n < MIN_WORK ? MIN_WORK / n : 1;                        \
+	struct elem##N e;                                                     \
+	struct elem##N* src;                                                  \
+	memset(&e, 0x5a, sizeof(e));                                          \
+                                                                              \
+	for (int r = 0; r < REPEAT; ++r) {                                    \
+		double start;                                                 \
+		measure_begin();                                              \
+		start = bench_now();                                          \
+		for (size_t j = 0; j < reps; ++j) {                           \
+			struct elem##N* arr =                                 \
+				da_init_with(sizeof(e), &bench_allocator);    \
+			for (size_t i = 0; i < n; ++i) {                      \
+				da_append(arr, e);                            \
+			}                                                     \
+			bench_clobber(arr);                                   \
+			da_free(arr);                                         \
+		}                                                             \
+		measure_end(r, bench_now() - start);                          \
+	}                                                                     \
+	report("append", N, n, n * reps);                                     \
+                                                                              \
+	shift##N("insert_front", n, 1, 0);                                    \
+	shift##N("insert_middle", n, 1, 1);                                   \
+	shift##N("insert_back", n, 1, 2);                                     \
+	shift##N("erase_front", n, 0, 0);                                     \
+	shift##N("erase_middle", n, 0, 1);                                    \
+	shift##N("erase_back", n, 0, 2);                                      \
+                                                                              \
+	/* the source counts against the memory budget too */                 \
+	if (n * N <= max_bytes / 2) {                                         \
+		fill##N(&src, n);                                             \
+		for (int r = 0; r < REPEAT; ++r) {                            \
+			double start;                                         \
+			measure_begin();                                      \
+			start = bench_now();                                  \
+			for (size_t j = 0; j < reps; ++j) {                   \
+				struct elem##N* arr = da_init_with(           \
+					sizeof(e), &bench_allocator           \
+				);                                            \
+				da_assign(arr, src, n);                       \
+				bench_clobber(arr);                           \
+				da_free(arr);                                 \
+			}                                                     \
+			measure_end(r, bench_now() - start);                  \
+		}                                                             \
+		report("assign", N, n, n * reps);                             \
+		da_free(src);                                                 \
+	}                                                                     \
+                                                                              \
+	for (int r = 0; r < REPEAT; ++r) {                                    \
+		double start;                                                 \
+		measure_begin();                                              \
+		start = bench_now();                                          \
+		for (size_t j = 0; j < reps; ++j) {                           \
+			struct elem##N* arr =                                 \
+				da_init_with(sizeof(e), &bench_allocator);    \
+			da_reserve(arr, n);                                   \
+			bench_clobber(arr);                                   \
+			da_free(arr);                                         \
+		}                                                             \
+		measure_end(r, bench_now() - start);                          \
+	}                                                                     \
+	report("reserve", N, n, reps);                                        \
+                                                                              \
+	fill##N(&src, n);                                                     \
+	for (int r = 0; r < REPEAT; ++r) {                                    \
+		/* a stride co-prime with n, so every element is visited */   \
+		size_t stride = n > 7 && n % 7 != 0 ? 7 : 1;                  \
+		size_t idx = 0;                                               \
+		unsigned sum = 0;                                             \
+		double start;                                                 \
+		measure_begin();                                              \
+		start = bench_now();                                          \
+		for (size_t j = 0; j < reps; ++j) {                           \
+			for (size_t i = 0; i < n; ++i) {                      \
+				sum += da_at(src, idx)->b[0];                 \
+				idx += stride;                                \
+				if (idx >= n) { idx -= n; }                   \
+			}                                                     \
+		}                                                             \
+		bench_clobber(sum);                                           \
+		measure_end(r, bench_now() - start);                          \
+	}                                                                     \
+	report("at", N, n, n * reps);                                         \
+	da_free(src);                                                         \
+}
+
+DEFINE_SUITE(1)
+DEFINE_SUITE(4)
+DEFINE_SUITE(8)
+DEFINE_SUITE(64)
+DEFINE_SUITE(256)
+
+int main(int argc, char** argv) {
+	for (int i = 1; i < argc; ++i) {
+		if (strcmp(argv[i], "--json") == 0) {
+			bench_json = 1;
+		} else if (strcmp(argv[i], "--max-bytes") == 0 && i + 1 < argc) {
+			max_bytes = strtoull(argv[++i], NULL, 10);
+		} else if (strcmp(argv[i], "--max-count") == 0 && i + 1 < argc) {
+			max_count = strtoull(argv[++i], NULL, 10);
+		} else {
+			fprintf(stderr, "usage: %s [--json] [--max-bytes N] "
+				"[--max-count N]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	bench_header();
+	for (size_t n = 100; n <= max_count; n *= 10) {
+		if (n * 1 <= max_bytes) { run1(n); }
+		if (n * 4 <= max_bytes) { run4(n); }
+		if (n * 8 <= max_bytes) { run8(n); }
+		if (n * 64 <= max_bytes) { run64(n); }
+		if (n * 256 <= max_bytes) { run256(n); }
+	}
+
+	return 0;
+}
@@ -1,13 +1,49 @@
+/* mremap, MAP_ANONYMOUS, MADV_HUGEPAGE */
+#define _GNU_SOURCE
+
 #include "da.h"
 
+#include <errno.h>
+#include <pthread.h>
 #include <string.h>
 #include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define DA_SIMD_X86
+#include <immintrin.h>
+#endif
+
 #include <math.h>
+#include <stdint.h>
 
+/* new capacity = capacity * DA_SCALE_NUM / DA_SCALE_DEN + DA_BIAS */
 #define DA_INITIAL_CAP 2
-#define DA_SCALE_FACTOR 1.5
+#define DA_SCALE_NUM 3
+#define DA_SCALE_DEN 2
 #define DA_BIAS 8
 
+#define DA_SIZE_MAX ((size_t)-1)
+
+#define DA_PAGE_SIZE 4096
+
+/* size classes of the thread cache: 32 bytes to 64 KiB */
+#define DA_CACHE_MIN_SHIFT 5
+#define DA_CACHE_CLASSES 12
+
+/* default for `da_set_mmap_threshold()` */
+#define DA_MMAP_THRESHOLD ((size_t)64 * 1024 * 1024)
+
 /*///////////////////////////////////////////////////////////////////////////*/
 /* Header / metadata stuff (internal)                                        */
 /*///////////////////////////////////////////////////////////////////////////*/
@@ -15,200 +51,4006 @@
 /* will probably work in the vast majority of cases */
 /* #define header_size(sz) ((void)sz, 16) */
 
-/* ensure natural alignment, may be overkill */
-static size_t header_size(size_t sz) {
-	/* minimum space for size + capacity */
-	size_t min_head = (2 * sizeof(size_t));
+/* reference count of a shared array, see `da_share()` */
+struct da_shared {
+	size_t refs;     /* holders of the data pointer, updated atomically */
+	size_t capacity; /* of the allocation; `capacity` is frozen at the size */
+};
 
-	/* header is smaller than natural alignment, avoid maths? */
-	if (min_head <= sz) { return sz; }
+/* `size` and `capacity` must stay last, see `da_var_size` in da.h */
+struct da_header {
+	const da_allocator* allocator;
+	const da_growth* growth; /* `NULL` for the process-wide default */
+	size_t align;  /* requested alignment, 0 for natural alignment */
+	size_t offset; /* from the start of the allocation to the data */
+#ifdef DA_STATS
+	da_stats* stats; /* per-array counters, MAY be `NULL` */
+#endif
+	struct da_shared* shared; /* `NULL` until `da_share()`d */
+	size_t first; /* deques: position of the front element, see da.h */
+	size_t capacity;
+	size_t size;
+};
 
-	/* minimum multiple greater than the header */
-	return ceil(min_head / (double)sz) * sz;
-}
+/* minimum space for the header */
+#define DA_HEADER_MIN sizeof(struct da_header)
 
-#define da_var_size(da) ((size_t*)(da))[-1]
-#define da_var_capacity(da) ((size_t*)(da))[-2]
+/* `DA_INLINE_STORAGE` leaves room for the header, fails to compile if not */
+typedef char da_inline_header_fits[DA_HEADER_MIN <= DA_INLINE_HEADER ? 1 : -1];
 
-#define da_head_to_data(p, sz) ((char*)(p) + header_size(sz))
-#define da_data_to_head(p, sz) ((char*)(p) - header_size(sz))
+#define da_header(da) ((struct da_header*)(da) - 1)
 
 /*///////////////////////////////////////////////////////////////////////////*/
-/* DynamicArray                                                              */
+/* Instrumentation                                                           */
 /*///////////////////////////////////////////////////////////////////////////*/
 
-void* da_init(size_t sz) {
-	void* tmp = NULL;
+#ifdef DA_STATS
 
-	if (sz == 0) {
-		return NULL;
-	}
+static da_stats da_global_stats;
 
-	tmp = malloc(header_size(sz) + DA_INITIAL_CAP * sz);
-	if (tmp == NULL) {
-		return NULL;
+static void stat_max(size_t* field, size_t value) {
+	size_t old = __atomic_load_n(field, __ATOMIC_RELAXED);
+
+	while (old < value && !__atomic_compare_exchange_n(
+		field, &old, value, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED
+	)) {
+		/* `old` is updated by a failed exchange */
 	}
+}
 
-	tmp = da_head_to_data(tmp, sz);
-	da_var_size(tmp) = 0;
-	da_var_capacity(tmp) = DA_INITIAL_CAP;
+/* `da` MAY be `NULL`, in which case only the process-wide counter changes */
+#define da_stat_add(da, field, n)                                             \
+do {                                                                          \
+	size_t n_ = (n);                                                      \
+	__atomic_fetch_add(&da_global_stats.field, n_, __ATOMIC_RELAXED);     \
+	if ((da) != NULL && da_header(da)->stats != NULL) {                   \
+		__atomic_fetch_add(                                           \
+			&da_header(da)->stats->field, n_, __ATOMIC_RELAXED    \
+		);                                                            \
+	}                                                                     \
+} while (0)
 
-	return tmp;
+#define da_stat_max(da, field, n)                                             \
+do {                                                                          \
+	size_t n_ = (n);                                                      \
+	stat_max(&da_global_stats.field, n_);                                 \
+	if ((da) != NULL && da_header(da)->stats != NULL) {                   \
+		stat_max(&da_header(da)->stats->field, n_);                   \
+	}                                                                     \
+} while (0)
+
+#define da_stat_load(out, field)                                              \
+	((out)->field = __atomic_load_n(&da_global_stats.field, __ATOMIC_RELAXED))
+
+void da_stats_snapshot(da_stats* out) {
+	da_stat_load(out, allocs);
+	da_stat_load(out, grows);
+	da_stat_load(out, shrinks);
+	da_stat_load(out, failed);
+	da_stat_load(out, bytes_allocated);
+	da_stat_load(out, bytes_copied);
+	da_stat_load(out, bytes_moved);
+	da_stat_load(out, peak_capacity_bytes);
+	da_stat_load(out, cache_hits);
 }
 
-void da_free_(void* da, size_t sz) {
+void da_stats_reset(void) {
+	memset(&da_global_stats, 0, sizeof(da_global_stats));
+}
+
+void da_set_stats_(void* da, da_stats* stats) {
 	if (da == NULL) {
 		return;
 	}
 
-	free(da_data_to_head(da, sz));
+	da_header(da)->stats = stats;
 }
 
-void da_assign_(void** da, void* src, size_t cnt, size_t sz) {
-	if (*da == NULL) {
-		*da = da_init(sz);
-	}
+#else /* DA_STATS */
 
-	if (cnt >= da_capacity(*da)) {
-		da_reserve_(da, cnt, sz);
-	}
+#define da_stat_add(da, field, n) ((void)0)
+#define da_stat_max(da, field, n) ((void)0)
 
-	memcpy(*da, src, cnt * sz);
-	da_var_size(*da) = cnt;
+void da_stats_snapshot(da_stats* out) {
+	memset(out, 0, sizeof(*out));
+}
+
+void da_stats_reset(void) {
+}
+
+void da_set_stats_(void* da, da_stats* stats) {
+	(void)da;
+	(void)stats;
+}
+
+#endif /* DA_STATS */
+
+/* ensure natural alignment, may be overkill */
+/* (this is only the offset of the data, use `da_data_to_head` to find the */
+/* start of an allocation) */
+static size_t header_size(size_t sz) {
+	/* header is smaller than natural alignment, avoid maths */
+	if (DA_HEADER_MIN <= sz) { return sz; }
+
+	/* minimum multiple greater than the header, both below twice its size */
+	/* so a 32-bit division will do (a 64-bit one is slower than `ceil`) */
+	return (unsigned)(DA_HEADER_MIN + sz - 1) / (unsigned)sz * sz;
 }
 
 /*///////////////////////////////////////////////////////////////////////////*/
-/* Element Access                                                            */
+/* Growth policy                                                             */
 /*///////////////////////////////////////////////////////////////////////////*/
 
-void* da_at_(void* da, size_t idx, size_t sz) {
-	if (da == NULL) {
-		return NULL;
+static const da_growth da_builtin_growth = {
+	DA_INITIAL_CAP, DA_SCALE_NUM, DA_SCALE_DEN, DA_BIAS, DA_ROUND_NONE, 0, 0
+};
+
+static const da_growth* da_default_growth = &da_builtin_growth;
+
+void da_set_default_growth(const da_growth* growth) {
+	da_default_growth = growth != NULL ? growth : &da_builtin_growth;
+}
+
+/* next capacity in the growth sequence, saturates instead of overflowing */
+static size_t grow_capacity(const da_growth* g, size_t cap) {
+	size_t whole = cap / g->den;
+	size_t part = cap % g->den;
+
+	if (whole > (DA_SIZE_MAX - g->bias - g->num) / g->num) {
+		return DA_SIZE_MAX;
 	}
 
-	if (idx >= da_size(da)) {
-		return NULL;
+	return whole * g->num + part * g->num / g->den + g->bias;
+}
+
+/* rounds an allocation size up to the policy's boundary, `0` on overflow */
+static size_t round_bytes(const da_growth* g, size_t bytes) {
+	size_t step;
+
+	switch (g->round) {
+	case DA_ROUND_PAGE:
+		step = DA_PAGE_SIZE;
+		break;
+	case DA_ROUND_SIZE_CLASS:
+		/* four classes per power of two: 1, 1.25, 1.5, 1.75 */
+		step = 16;
+		while (step * 8 < bytes) { step *= 2; }
+		break;
+	default:
+		return bytes;
 	}
 
-	return (char*)da + (idx * sz);
+	if (bytes > DA_SIZE_MAX - step) {
+		return 0;
+	}
+
+	return (bytes + step - 1) / step * step;
+}
+
+#define da_data_to_head(p) ((char*)(p) - da_header(p)->offset)
+
+/*
+ * bytes to allocate in front of the data
+ *
+ * The allocation may move on growth, so over-aligned arrays keep enough room
+ * to align the data wherever the allocator places it.
+ */
+static size_t head_room(size_t sz, size_t align) {
+	if (align == 0) { return header_size(sz); }
+	return DA_HEADER_MIN + align - 1;
 }
 
+/* offset of the data from the start of the allocation at `head` */
+static size_t data_offset(void* head, size_t sz, size_t align) {
+	size_t addr = (size_t)head + DA_HEADER_MIN;
+
+	if (align == 0) { return header_size(sz); }
+	return (addr + align - 1) / align * align - (size_t)head;
+}
+
+#define da_head_room(da, sz) head_room(sz, da_header(da)->align)
+
+#define da_growth_of(da)                                                      \
+	(da_header(da)->growth != NULL ? da_header(da)->growth                \
+		: da_default_growth)
+
+/* size of the whole allocation for an array */
+#define da_block_size(da, sz) (da_head_room(da, sz) + da_capacity(da) * (sz))
+
 /*///////////////////////////////////////////////////////////////////////////*/
-/* Capacity                                                                  */
+/* Allocators                                                                */
 /*///////////////////////////////////////////////////////////////////////////*/
 
-size_t da_size_(void* da) {
-	if (da == NULL) {
-		return 0;
+/*
+ * Thread cache of default allocated blocks, one singly linked list per size
+ * class (the link is stored in the block itself). While the cache is enabled
+ * blocks are allocated at the size of their class, so they come back to the
+ * same list when freed.
+ */
+struct da_cache {
+	void* free[DA_CACHE_CLASSES];
+	size_t bytes; /* held in all the lists */
+	int state;    /* 0 until registered for draining, -1 once drained */
+};
+
+#define da_cache_class_size(c) ((size_t)1 << ((c) + DA_CACHE_MIN_SHIFT))
+
+static size_t da_cache_limit = 0;
+static __thread struct da_cache da_cache;
+static pthread_key_t da_cache_key;
+static pthread_once_t da_cache_once = PTHREAD_ONCE_INIT;
+
+static void cache_drain(struct da_cache* cache) {
+	size_t c;
+
+	for (c = 0; c < DA_CACHE_CLASSES; ++c) {
+		while (cache->free[c] != NULL) {
+			void* next = *(void**)cache->free[c];
+			free(cache->free[c]);
+			cache->free[c] = next;
+		}
 	}
+	cache->bytes = 0;
+}
 
-	return da_var_size(da);
+/* runs at thread exit */
+static void cache_destroy(void* cache) {
+	cache_drain(cache);
+	((struct da_cache*)cache)->state = -1;
 }
 
-size_t da_capacity_(void* da) {
-	if (da == NULL) {
-		return 0;
+static void cache_key_create(void) {
+	if (pthread_key_create(&da_cache_key, cache_destroy) != 0) {
+		da_cache_limit = 0;
 	}
+}
 
-	return da_var_capacity(da);
+/* smallest class of at least `bytes`, `DA_CACHE_CLASSES` if too large */
+static size_t cache_class(size_t bytes) {
+	size_t c = 0;
+
+	while (c < DA_CACHE_CLASSES && da_cache_class_size(c) < bytes) { ++c; }
+	return c;
 }
 
-void da_reserve_(void** da, size_t cnt, size_t sz) {
+/* `malloc` size of a block, rounded up to its class if it can be cached */
+static size_t cache_alloc_size(size_t bytes) {
+	size_t c = cache_class(bytes);
+
+	return c == DA_CACHE_CLASSES ? bytes : da_cache_class_size(c);
+}
+
+/* real size of a block of (at least) `bytes` */
+static size_t cache_block_size(void* ptr, size_t bytes) {
+#ifdef __GLIBC__
+	size_t usable = malloc_usable_size(ptr);
+	if (usable > bytes) { return usable; }
+#else
+	(void)ptr;
+#endif
+	return bytes;
+}
+
+/* a cached block of at least `bytes`, or `NULL` */
+static void* cache_take(size_t bytes) {
+	size_t c = cache_class(bytes);
+	void* ptr;
+
+	if (c == DA_CACHE_CLASSES || da_cache.free[c] == NULL) {
+		return NULL;
+	}
+
+	ptr = da_cache.free[c];
+	da_cache.free[c] = *(void**)ptr;
+	da_cache.bytes -= da_cache_class_size(c);
+	da_stat_add(NULL, cache_hits, 1);
+
+	return ptr;
+}
+
+/* caches (or frees) a block of `bytes` */
+static void cache_give(void* ptr, size_t bytes) {
+	size_t c;
+
+	/* largest class that fits in the block */
+	bytes = cache_block_size(ptr, bytes);
+	c = cache_class(bytes);
+	if (c < DA_CACHE_CLASSES && da_cache_class_size(c) > bytes) {
+		c = c == 0 ? DA_CACHE_CLASSES : c - 1;
+	}
+
+	if (c == DA_CACHE_CLASSES || da_cache.state < 0 || da_cache.bytes
+			+ da_cache_class_size(c) > da_cache_limit) {
+		free(ptr);
+		return;
+	}
+
+	/* first block cached by this thread, make sure it gets drained */
+	if (da_cache.state == 0) {
+		pthread_once(&da_cache_once, cache_key_create);
+		if (da_cache_limit == 0 || pthread_setspecific(
+			da_cache_key, &da_cache
+		) != 0) {
+			free(ptr);
+			return;
+		}
+		da_cache.state = 1;
+	}
+
+	*(void**)ptr = da_cache.free[c];
+	da_cache.free[c] = ptr;
+	da_cache.bytes += da_cache_class_size(c);
+}
+
+void da_set_thread_cache(size_t max_bytes) {
+	da_cache_limit = max_bytes;
+}
+
+void da_thread_cache_drain(void) {
+	cache_drain(&da_cache);
+}
+
+/* `NULL` is the default allocator, which avoids the indirect calls */
+
+static void* block_alloc(const da_allocator* a, size_t bytes) {
+	void* ptr;
+
+	if (a != NULL) { return a->alloc(a, bytes); }
+	if (da_cache_limit == 0) { return malloc(bytes); }
+
+	ptr = cache_take(bytes);
+	return ptr != NULL ? ptr : malloc(cache_alloc_size(bytes));
+}
+
+static void* block_resize(
+	const da_allocator* a, void* ptr, size_t old_bytes, size_t new_bytes
+) {
+	size_t real;
 	void* tmp;
-	size_t new_size;
 
-	if (*da == NULL) {
-		*da = da_init(sz);
+	if (a != NULL) { return a->resize(a, ptr, old_bytes, new_bytes); }
+	if (da_cache_limit == 0) { return realloc(ptr, new_bytes); }
+
+	/* still fits, and would not move to a smaller class */
+	real = cache_block_size(ptr, old_bytes);
+	if (new_bytes <= real && new_bytes > real / 2) {
+		return ptr;
 	}
 
-	new_size = cnt * sz + header_size(sz);
-	tmp = realloc(da_data_to_head(*da, sz), new_size);
+	tmp = cache_take(new_bytes);
 	if (tmp == NULL) {
-		return;
+		return realloc(ptr, cache_alloc_size(new_bytes));
 	}
-	*da = da_head_to_data(tmp, sz);
-	da_var_capacity(*da) = cnt;
+
+	memcpy(tmp, ptr, old_bytes < new_bytes ? old_bytes : new_bytes);
+	cache_give(ptr, old_bytes);
+	return tmp;
 }
 
-/*///////////////////////////////////////////////////////////////////////////*/
-/* Modifiers                                                                 */
-/*///////////////////////////////////////////////////////////////////////////*/
+static void block_release(const da_allocator* a, void* ptr, size_t bytes) {
+	if (a != NULL) { a->release(a, ptr, bytes); return; }
+	if (da_cache_limit == 0) { free(ptr); return; }
+	cache_give(ptr, bytes);
+}
 
-void da_clear_(void* da) {
-	if (da == NULL) {
-		return;
+/* bytes actually available in the block, at least `bytes` */
+static size_t block_usable(const da_allocator* a, void* ptr, size_t bytes) {
+	size_t usable = bytes;
+
+	if (a == NULL) {
+#ifdef __GLIBC__
+		usable = malloc_usable_size(ptr);
+#endif
+	} else if (a->usable != NULL) {
+		usable = a->usable(a, ptr, bytes);
 	}
 
-	da_var_size(da) = 0;
+	return usable > bytes ? usable : bytes;
 }
 
-void da_insert_(void** da, size_t idx, void* val, size_t sz) {
-	void* dst;
-	void* src;
+static void* malloc_alloc(const da_allocator* self, size_t bytes) {
+	(void)self;
+	return malloc(bytes);
+}
 
-	if (*da == NULL) {
-		*da = da_init(sz);
+static void* malloc_resize(
+	const da_allocator* self, void* ptr, size_t old_bytes, size_t new_bytes
+) {
+	(void)self;
+	(void)old_bytes;
+	return realloc(ptr, new_bytes);
+}
+
+static void malloc_release(const da_allocator* self, void* ptr, size_t bytes) {
+	(void)self;
+	(void)bytes;
+	free(ptr);
+}
+
+static size_t malloc_usable(const da_allocator* self, void* ptr, size_t bytes) {
+	(void)self;
+	return block_usable(NULL, ptr, bytes);
+}
+
+const da_allocator da_malloc_allocator = {
+	malloc_alloc, malloc_resize, malloc_release, NULL, malloc_usable
+};
+
+/* anonymous mappings, grown with `mremap` so that the pages are moved */
+/* rather than copied; `ctx` is non-NULL to request transparent huge pages */
+
+#define da_page_round(n)                                                      \
+	(((n) + DA_PAGE_SIZE - 1) / DA_PAGE_SIZE * DA_PAGE_SIZE)
+
+#ifdef __linux__
+
+static void mmap_advise(const da_allocator* self, void* ptr, size_t bytes) {
+#ifdef MADV_HUGEPAGE
+	if (self->ctx != NULL) {
+		/* only a hint, failure is not an error */
+		madvise(ptr, da_page_round(bytes), MADV_HUGEPAGE);
 	}
+#else
+	(void)self;
+	(void)ptr;
+	(void)bytes;
+#endif
+}
 
-	if (idx >= da_capacity(*da)) {
-		return;
+static void* mmap_alloc(const da_allocator* self, size_t bytes) {
+	void* ptr = mmap(
+		NULL, bytes, PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS, -1, 0
+	);
+
+	if (ptr == MAP_FAILED) {
+		return NULL;
 	}
 
-	if (da_size(*da) == da_capacity(*da)) {
-		size_t cnt = da_capacity(*da) * DA_SCALE_FACTOR + DA_BIAS;
-		da_reserve_(da, cnt, sz);
+	mmap_advise(self, ptr, bytes);
+	return ptr;
+}
+
+static void* mmap_resize(
+	const da_allocator* self, void* ptr, size_t old_bytes, size_t new_bytes
+) {
+	void* tmp = mremap(ptr, old_bytes, new_bytes, MREMAP_MAYMOVE);
+
+	if (tmp == MAP_FAILED) {
+		return NULL;
 	}
 
-	/* shift elements */
-	if (idx <= da_size(*da)) {
-		dst = (char*)*da + sz * (idx + 1);
-		src = (char*)*da + sz * idx;
-		memmove(dst, src, (da_size(*da) - idx) * sz);
+	mmap_advise(self, tmp, new_bytes);
+	return tmp;
+}
+
+static void mmap_release(const da_allocator* self, void* ptr, size_t bytes) {
+	(void)self;
+	munmap(ptr, bytes);
+}
+
+#else /* __linux__ */
+
+/* no `mremap`, fall back to the default allocator */
+#define mmap_alloc malloc_alloc
+#define mmap_resize malloc_resize
+#define mmap_release malloc_release
+
+#endif /* __linux__ */
+
+static size_t mmap_usable(const da_allocator* self, void* ptr, size_t bytes) {
+	(void)self;
+	(void)ptr;
+	return da_page_round(bytes);
+}
+
+const da_allocator da_mmap_allocator = {
+	mmap_alloc, mmap_resize, mmap_release, NULL, mmap_usable
+};
+
+/* `ctx` only needs to be non-NULL */
+const da_allocator da_mmap_huge_allocator = {
+	mmap_alloc, mmap_resize, mmap_release,
+	(void*)&da_mmap_huge_allocator, mmap_usable
+};
+
+static size_t da_mmap_threshold = DA_MMAP_THRESHOLD;
+static const da_allocator* da_mmap_auto = &da_mmap_allocator;
+
+void da_set_mmap_threshold(size_t bytes, int huge_pages) {
+	da_mmap_threshold = bytes;
+	da_mmap_auto = huge_pages ? &da_mmap_huge_allocator : &da_mmap_allocator;
+}
+
+/* moves a default allocated block into a mapping, `NULL` on failure */
+static void* block_to_mmap(void* head, size_t old_bytes, size_t new_bytes) {
+	void* tmp = da_mmap_auto->alloc(da_mmap_auto, new_bytes);
+
+	if (tmp == NULL) {
+		return NULL;
 	}
 
-	dst = (char*)*da + sz * idx;
-	memcpy(dst, val, sz);
-	++(da_var_size(*da));
+	memcpy(tmp, head, old_bytes < new_bytes ? old_bytes : new_bytes);
+	free(head);
+	return tmp;
 }
 
-void da_erase_(void** da, size_t idx, size_t sz) {
-	void* dst;
-	void* src;
+/* caller-provided storage (`da_init_inline()`), which is never freed; */
+/* growing moves the block to the heap, after which the array uses `NULL` */
 
-	if (*da == NULL) {
-		return;
+static void* inline_alloc(const da_allocator* self, size_t bytes) {
+	(void)self;
+	(void)bytes;
+	return NULL;
+}
+
+static void* inline_resize(
+	const da_allocator* self, void* ptr, size_t old_bytes, size_t new_bytes
+) {
+	void* tmp;
+
+	(void)self;
+	if (new_bytes <= old_bytes) {
+		return ptr;
 	}
 
-	if (idx >= da_size(*da)) {
-		return;
+	tmp = malloc(new_bytes);
+	if (tmp == NULL) {
+		return NULL;
 	}
 
-	if (da_size(*da) == da_capacity(*da)) {
-		size_t cnt = da_capacity(*da) * DA_SCALE_FACTOR + DA_BIAS;
-		da_reserve_(da, cnt, sz);
+	memcpy(tmp, ptr, old_bytes);
+	return tmp;
+}
+
+static void inline_release(const da_allocator* self, void* ptr, size_t bytes) {
+	(void)self;
+	(void)ptr;
+	(void)bytes;
+}
+
+static const da_allocator da_inline_allocator = {
+	inline_alloc, inline_resize, inline_release, NULL, NULL
+};
+
+/* the page size of the system, for mapping files */
+static size_t page_size(void) {
+	long page = sysconf(_SC_PAGESIZE);
+	return page > 0 ? (size_t)page : DA_PAGE_SIZE;
+}
+
+#ifdef __linux__
+
+/* saved arrays mapped read-only (`da_mmap()`): the header sits on writable */
+/* anonymous pages in front of the file's pages, and the whole region is */
+/* unmapped at once. Any change moves the block to the heap (see `own()`), */
+/* after which the array uses `NULL` */
+
+static void mapped_release(const da_allocator* self, void* ptr, size_t bytes) {
+	/* the region starts on the page holding the header */
+	char* base = (char*)((size_t)ptr / page_size() * page_size());
+
+	(void)self;
+	munmap(base, (size_t)((char*)ptr + bytes - base));
+}
+
+static void* mapped_resize(
+	const da_allocator* self, void* ptr, size_t old_bytes, size_t new_bytes
+) {
+	void* tmp = malloc(new_bytes);
+
+	if (tmp == NULL) {
+		return NULL;
 	}
 
-	/* shift elements */
-	if (idx <= da_size(*da)) {
-		dst = (char*)*da + sz * idx;
-		src = (char*)*da + sz * (idx + 1);
-		memmove(dst, src, (da_size(*da) - (idx + 1)) * sz);
+	memcpy(tmp, ptr, old_bytes < new_bytes ? old_bytes : new_bytes);
+	mapped_release(self, ptr, old_bytes);
+	return tmp;
+}
+
+static const da_allocator da_mapped_allocator = {
+	inline_alloc, mapped_resize, mapped_release, NULL, NULL
+};
+
+#define da_mapped(a) ((a) == &da_mapped_allocator)
+
+#else /* __linux__ */
+
+/* files are always read, see `da_mmap()` */
+#define da_mapped(a) ((void)(a), 0)
+
+#endif /* __linux__ */
+
+#define da_is_mapped(da) da_mapped(da_header(da)->allocator)
+
+/* arena blocks are `malloc`'d, with this header in front of the memory */
+struct da_arena_block {
+	struct da_arena_block* next;
+	size_t size;
+	size_t used;
+	size_t last; /* offset of the most recent allocation */
+};
+
+/* strictest fundamental alignment (as returned by `malloc`) */
+union da_max_align {
+	long l;
+	double d;
+	long double ld;
+	void* p;
+};
+
+#define DA_MALLOC_ALIGN sizeof(union da_max_align)
+#define da_arena_round(n)                                                     \
+	(((n) + DA_MALLOC_ALIGN - 1) / DA_MALLOC_ALIGN * DA_MALLOC_ALIGN)
+#define DA_ARENA_BLOCK_HEAD da_arena_round(sizeof(struct da_arena_block))
+
+#define da_arena_mem(b) ((char*)(b) + DA_ARENA_BLOCK_HEAD)
+
+static void* arena_alloc(const da_allocator* self, size_t bytes) {
+	da_arena* arena = self->ctx;
+	struct da_arena_block* b = arena->head;
+	size_t need;
+
+	if (bytes > DA_SIZE_MAX - DA_ARENA_BLOCK_HEAD - DA_MALLOC_ALIGN) {
+		return NULL;
 	}
+	need = da_arena_round(bytes);
 
-	--(da_var_size(*da));
+	if (b == NULL || b->size - b->used < need) {
+		size_t size = need > arena->block_size ? need : arena->block_size;
+
+		b = malloc(DA_ARENA_BLOCK_HEAD + size);
+		if (b == NULL) {
+			return NULL;
+		}
+		b->next = arena->head;
+		b->size = size;
+		b->used = 0;
+		arena->head = b;
+	}
+
+	b->last = b->used;
+	b->used += need;
+	return da_arena_mem(b) + b->last;
 }
 
-void da_append_(void** da, void* val, size_t sz) {
-	void* dst;
+/* true if `ptr` is the most recent allocation */
+static int arena_is_last(const da_arena* arena, const void* ptr) {
+	const struct da_arena_block* b = arena->head;
+	return b != NULL && b->used != b->last
+		&& (const char*)ptr == da_arena_mem(b) + b->last;
+}
 
-	if (*da == NULL) { *da = da_init(sz); }
+static void* arena_resize(
+	const da_allocator* self, void* ptr, size_t old_bytes, size_t new_bytes
+) {
+	da_arena* arena = self->ctx;
+	struct da_arena_block* b = arena->head;
+	void* tmp;
 
-	if (da_size(*da) == da_capacity(*da)) {
-		size_t cnt = da_capacity(*da) * DA_SCALE_FACTOR + DA_BIAS;
-		da_reserve_(da, cnt, sz);
+	/* grow / shrink in place */
+	if (arena_is_last(arena, ptr) && new_bytes <= b->size - b->last) {
+		b->used = b->last + da_arena_round(new_bytes);
+		return ptr;
 	}
 
-	dst = (char*)*da + sz * da_size(*da);
-	memcpy(dst, val, sz);
-	++(da_var_size(*da));
+	tmp = arena_alloc(self, new_bytes);
+	if (tmp == NULL) {
+		return NULL;
+	}
+
+	memcpy(tmp, ptr, old_bytes < new_bytes ? old_bytes : new_bytes);
+	return tmp;
+}
+
+static void arena_release(const da_allocator* self, void* ptr, size_t bytes) {
+	da_arena* arena = self->ctx;
+	(void)bytes;
+
+	if (arena_is_last(arena, ptr)) {
+		arena->head->used = arena->head->last;
+	}
+}
+
+void da_arena_init(da_arena* arena, size_t block_size) {
+	arena->allocator.alloc = arena_alloc;
+	arena->allocator.resize = arena_resize;
+	arena->allocator.release = arena_release;
+	arena->allocator.ctx = arena;
+	arena->head = NULL;
+	arena->block_size = block_size;
+}
+
+void da_arena_reset(da_arena* arena) {
+	struct da_arena_block* b;
+
+	if (arena->head == NULL) {
+		return;
+	}
+
+	b = arena->head->next;
+	while (b != NULL) {
+		struct da_arena_block* next = b->next;
+		free(b);
+		b = next;
+	}
+
+	arena->head->next = NULL;
+	arena->head->used = 0;
+	arena->head->last = 0;
+}
+
+void da_arena_release(da_arena* arena) {
+	da_arena_reset(arena);
+	free(arena->head);
+	arena->head = NULL;
+}
+
+/* grows the capacity to at least `need`, following the growth policy */
+static void grow(void** da, size_t need, size_t sz) {
+	const da_growth* g = da_growth_of(*da);
+	size_t room = da_head_room(*da, sz);
+	size_t next = grow_capacity(g, da_capacity(*da));
+	size_t bytes;
+
+	if (next < need) { next = need; }
+
+	/* round the whole allocation, and fill it */
+	if (next <= (DA_SIZE_MAX - room) / sz) {
+		bytes = round_bytes(g, room + next * sz);
+		if (bytes != 0) {
+			next = (bytes - room) / sz;
+		}
+	}
+
+	da_reserve_(da, next, sz);
+}
+
+/*
+ * shrinks the capacity, if the policy asks for it, once the array is less
+ * than 1 / `shrink` full
+ *
+ * The new capacity is one growth step above the size, so it takes a further
+ * shrink in size (by a factor of `shrink` / growth) before shrinking again.
+ */
+static void shrink(void** da, size_t sz) {
+	const da_growth* g = da_growth_of(*da);
+	size_t size = da_size(*da);
+	size_t cap = da_capacity(*da);
+	size_t next;
+
+	if (g->shrink == 0 || cap <= g->initial) {
+		return;
+	}
+
+	if (size >= cap / g->shrink) {
+		return;
+	}
+
+	next = grow_capacity(g, size);
+	if (next < g->initial) { next = g->initial; }
+	if (next >= cap) {
+		return;
+	}
+
+	da_reserve_(da, next, sz);
+}
+
+/* makes room for `cnt` more elements with (at most) a single reservation */
+static void reserve_more(void** da, size_t cnt, size_t sz) {
+	size_t need;
+
+	if (cnt > DA_SIZE_MAX - da_size(*da)) {
+		errno = ENOMEM;
+		return;
+	}
+
+	need = da_size(*da) + cnt;
+	if (need <= da_capacity(*da)) {
+		return;
+	}
+
+	grow(da, need, sz);
+}
+
+/*///////////////////////////////////////////////////////////////////////////*/
+/* DynamicArray                                                              */
+/*///////////////////////////////////////////////////////////////////////////*/
+
+static void* init(size_t sz, size_t align, const da_allocator* allocator) {
+	const da_growth* g = da_default_growth;
+	void* tmp = NULL;
+	size_t cap = g->initial;
+	size_t room;
+	size_t bytes;
+	size_t offset;
+
+	if (sz == 0) {
+		return NULL;
+	}
+
+	room = head_room(sz, align);
+
+	if (cap > (DA_SIZE_MAX - room) / sz) {
+		errno = ENOMEM;
+		return NULL;
+	}
+
+	bytes = round_bytes(g, room + cap * sz);
+	if (bytes == 0) {
+		bytes = room + cap * sz;
+	}
+
+	tmp = block_alloc(allocator, bytes);
+	if (tmp == NULL) {
+		da_stat_add(NULL, failed, 1);
+		return NULL;
+	}
+
+	da_stat_add(NULL, allocs, 1);
+	da_stat_add(NULL, bytes_allocated, bytes);
+	da_stat_max(NULL, peak_capacity_bytes, bytes - room);
+
+	if (g->usable_size) {
+		bytes = block_usable(allocator, tmp, bytes);
+	}
+
+	offset = data_offset(tmp, sz, align);
+	tmp = (char*)tmp + offset;
+	da_header(tmp)->allocator = allocator;
+	da_header(tmp)->growth = NULL;
+	da_header(tmp)->shared = NULL;
+	da_header(tmp)->align = align;
+	da_header(tmp)->offset = offset;
+#ifdef DA_STATS
+	da_header(tmp)->stats = NULL;
+#endif
+	da_var_first(tmp) = 0;
+	da_var_size(tmp) = 0;
+	da_var_capacity(tmp) = (bytes - room) / sz;
+
+	return tmp;
+}
+
+/*
+ * Shared arrays (`da_share()`) have their capacity frozen at their size, so
+ * that the inline fast paths never write to them, and every other change goes
+ * through `own()` first. The last holder finds a count of one, and takes the
+ * array back in place.
+ */
+
+/* non-zero if `da` has no other holders, in which case it is unshared */
+static int sole_holder(void* da) {
+	struct da_shared* s = da_header(da)->shared;
+
+	if (s == NULL) {
+		return 1;
+	}
+	if (__atomic_load_n(&s->refs, __ATOMIC_ACQUIRE) != 1) {
+		return 0;
+	}
+
+	da_var_capacity(da) = s->capacity;
+	da_header(da)->shared = NULL;
+	free(s);
+	return 1;
+}
+
+/* drops a reference, non-zero if it was the last one (now unshared) */
+static int release_shared(void* da) {
+	struct da_shared* s = da_header(da)->shared;
+
+	if (__atomic_sub_fetch(&s->refs, 1, __ATOMIC_ACQ_REL) != 0) {
+		return 0;
+	}
+
+	da_var_capacity(da) = s->capacity;
+	da_header(da)->shared = NULL;
+	free(s);
+	return 1;
+}
+
+/* an empty array with the same element alignment, allocator and growth */
+/* policy as `da` (NULL on failure) */
+static void* init_like(void* da, size_t sz) {
+	const da_allocator* allocator = da_header(da)->allocator;
+	void* tmp;
+
+	/* caller-provided storage and files can't be duplicated */
+	if (allocator == &da_inline_allocator || da_mapped(allocator)) {
+		allocator = NULL;
+	}
+
+	tmp = init(sz, da_header(da)->align, allocator);
+	if (tmp != NULL) {
+		da_header(tmp)->growth = da_header(da)->growth;
+	}
+	return tmp;
+}
+
+/* gives `*da` an array of its own, copying it to a new array of `cap` */
+/* elements if it is shared: `0` if copied, `1` if it was the last holder */
+/* (unshared in place, nothing reserved) and `-1` on failure */
+static int detach(void** da, size_t cap, size_t sz) {
+	size_t keep = da_size(*da) < cap ? da_size(*da) : cap;
+	void* tmp;
+
+	if (sole_holder(*da)) {
+		return 1;
+	}
+
+	tmp = init_like(*da, sz);
+	if (tmp == NULL) {
+		return -1;
+	}
+
+	da_reserve_(&tmp, cap, sz);
+	if (da_capacity(tmp) < cap) {
+		da_free_(tmp, sz);
+		return -1;
+	}
+
+	memcpy(tmp, *da, keep * sz);
+	da_stat_add(tmp, bytes_copied, keep * sz);
+	da_var_size(tmp) = keep;
+
+	da_free_(*da, sz);
+	*da = tmp;
+	return 0;
+}
+
+/* copies a shared or mapped array before writing to it, non-zero on */
+/* failure (`*da` is unchanged) */
+static int own(void** da, size_t sz) {
+	if (*da == NULL) {
+		return 0;
+	}
+
+	if (da_header(*da)->shared != NULL && detach(
+		da, da_header(*da)->shared->capacity, sz
+	) < 0) {
+		return -1;
+	}
+	if (!da_is_mapped(*da)) {
+		return 0;
+	}
+
+	da_reserve_(da, da_capacity(*da), sz);
+	return da_is_mapped(*da);
+}
+
+void* da_init(size_t sz) {
+	return init(sz, 0, NULL);
+}
+
+void* da_init_with(size_t sz, const da_allocator* allocator) {
+	return init(sz, 0, allocator);
+}
+
+void* da_init_aligned(size_t sz, size_t align) {
+	/* largest power of two dividing the element size, as a stand-in for */
+	/* the alignment of the element type */
+	size_t natural = sz & (~sz + 1);
+
+	/* must be a power of two */
+	if (align == 0 || (align & (align - 1)) != 0 || align > DA_ALIGN_MAX) {
+		errno = EINVAL;
+		return NULL;
+	}
+
+	if (natural > DA_MALLOC_ALIGN) { natural = DA_MALLOC_ALIGN; }
+	if (align < natural) { align = natural; }
+
+	return init(sz, align, NULL);
+}
+
+void* da_init_inline(void* buf, size_t bytes, size_t sz) {
+	size_t natural = sz & (~sz + 1);
+	size_t room;
+	void* tmp;
+
+	if (sz == 0) {
+		return NULL;
+	}
+
+	if (natural > DA_MALLOC_ALIGN) { natural = DA_MALLOC_ALIGN; }
+	if (natural < sizeof(size_t)) { natural = sizeof(size_t); }
+
+	room = head_room(sz, 0);
+	if ((size_t)buf % natural != 0 || bytes < room || bytes - room < sz) {
+		errno = EINVAL;
+		return NULL;
+	}
+
+	tmp = (char*)buf + room;
+	da_header(tmp)->allocator = &da_inline_allocator;
+	da_header(tmp)->growth = NULL;
+	da_header(tmp)->shared = NULL;
+	da_header(tmp)->align = 0;
+	da_header(tmp)->offset = room;
+#ifdef DA_STATS
+	da_header(tmp)->stats = NULL;
+#endif
+	da_var_first(tmp) = 0;
+	da_var_size(tmp) = 0;
+	da_var_capacity(tmp) = (bytes - room) / sz;
+
+	return tmp;
+}
+
+void da_free_(void* da, size_t sz) {
+	if (da == NULL) {
+		return;
+	}
+
+	if (da_header(da)->shared != NULL && !release_shared(da)) {
+		return;
+	}
+
+	block_release(
+		da_header(da)->allocator,
+		da_data_to_head(da),
+		da_block_size(da, sz)
+	);
+}
+
+/* see "Parallel algorithms" */
+static void parallel_copy(void* dst, const void* src, size_t cnt, size_t sz);
+
+void da_assign_(void** da, void* src, size_t cnt, size_t sz) {
+	if (*da == NULL) {
+		*da = da_init(sz);
+	}
+
+	if (*da == NULL || own(da, sz) != 0) {
+		return;
+	}
+
+	if (cnt >= da_capacity(*da)) {
+		da_reserve_(da, cnt, sz);
+	}
+
+	if (cnt > da_capacity(*da)) {
+		return;
+	}
+
+	parallel_copy(*da, src, cnt, sz);
+	da_var_first(*da) = 0;
+	da_var_size(*da) = cnt;
+}
+
+/*///////////////////////////////////////////////////////////////////////////*/
+/* Element Access                                                            */
+/*///////////////////////////////////////////////////////////////////////////*/
+
+void* da_at_(void* da, size_t idx, size_t sz) {
+	if (da == NULL) {
+		return NULL;
+	}
+
+	if (idx >= da_size(da)) {
+		return NULL;
+	}
+
+	return (char*)da + (idx * sz);
+}
+
+/*///////////////////////////////////////////////////////////////////////////*/
+/* Capacity                                                                  */
+/*///////////////////////////////////////////////////////////////////////////*/
+
+size_t da_size_(void* da) {
+	if (da == NULL) {
+		return 0;
+	}
+
+	return da_var_size(da);
+}
+
+size_t da_capacity_(void* da) {
+	if (da == NULL) {
+		return 0;
+	}
+
+	return da_var_capacity(da);
+}
+
+void da_reserve_(void** da, size_t cnt, size_t sz) {
+	const da_allocator* allocator;
+	void* head;
+	void* tmp;
+	size_t room;
+	size_t align;
+	size_t offset;
+	size_t keep;
+	size_t old_cap;
+	int remap = 0; /* a moved block was remapped rather than copied */
+
+	if (*da == NULL) {
+		*da = da_init(sz);
+	}
+
+	if (*da == NULL) {
+		return;
+	}
+
+	/* never below the size, which is kept */
+	if (cnt < da_size(*da)) {
+		cnt = da_size(*da);
+	}
+
+	/* a shared array is copied straight to the new capacity, unless the */
+	/* other holders are gone by now and it can be reallocated as usual */
+	if (da_header(*da)->shared != NULL) {
+		switch (detach(da, cnt, sz)) {
+		case 1:
+			break;
+		case 0:
+			return;
+		default:
+			da_stat_add(*da, failed, 1);
+			return;
+		}
+	}
+
+	/* deques are reallocated as plain arrays */
+	da_deque_linearize_(*da, sz);
+
+	room = da_head_room(*da, sz);
+	if (cnt > (DA_SIZE_MAX - room) / sz) {
+		da_stat_add(*da, failed, 1);
+		errno = ENOMEM;
+		return;
+	}
+
+	head = da_data_to_head(*da);
+	allocator = da_header(*da)->allocator;
+	align = da_header(*da)->align;
+	offset = da_header(*da)->offset;
+	keep = da_size(*da) < cnt ? da_size(*da) : cnt;
+	old_cap = da_capacity(*da);
+
+	/* large arrays leave `malloc` for a mapping (once) */
+	if (allocator == NULL && da_mmap_threshold != 0
+			&& room + cnt * sz >= da_mmap_threshold) {
+		allocator = da_mmap_auto;
+		tmp = block_to_mmap(
+			head, da_block_size(*da, sz), room + cnt * sz
+		);
+	} else {
+		remap = allocator == &da_mmap_allocator
+			|| allocator == &da_mmap_huge_allocator;
+		tmp = block_resize(
+			allocator, head, da_block_size(*da, sz), room + cnt * sz
+		);
+	}
+	if (tmp == NULL) {
+		da_stat_add(*da, failed, 1);
+		return;
+	}
+
+	/* left the caller's storage, or the file */
+	if ((allocator == &da_inline_allocator || da_mapped(allocator))
+			&& tmp != head) {
+		allocator = NULL;
+	}
+
+	/* the contents moved with the allocation, but may now be misaligned */
+	if (data_offset(tmp, sz, align) != offset) {
+		char* src = (char*)tmp + offset - DA_HEADER_MIN;
+		offset = data_offset(tmp, sz, align);
+		memmove(
+			(char*)tmp + offset - DA_HEADER_MIN,
+			src,
+			DA_HEADER_MIN + keep * sz
+		);
+		da_stat_add((char*)tmp + offset, bytes_copied,
+			DA_HEADER_MIN + keep * sz);
+	}
+
+	/* `*da` is stale, but the header moved along with the data */
+	if (cnt > old_cap) {
+		da_stat_add((char*)tmp + offset, grows, 1);
+	} else {
+		da_stat_add((char*)tmp + offset, shrinks, 1);
+	}
+	da_stat_add((char*)tmp + offset, bytes_allocated, room + cnt * sz);
+	da_stat_max((char*)tmp + offset, peak_capacity_bytes, cnt * sz);
+	if (tmp != head && !remap) {
+		da_stat_add((char*)tmp + offset, bytes_copied,
+			DA_HEADER_MIN + keep * sz);
+	}
+
+	*da = (char*)tmp + offset;
+	da_header(*da)->allocator = allocator;
+	da_header(*da)->offset = offset;
+	da_var_capacity(*da) = cnt;
+
+	if (da_growth_of(*da)->usable_size) {
+		size_t usable = block_usable(allocator, tmp, room + cnt * sz);
+		da_var_capacity(*da) = (usable - room) / sz;
+	}
+}
+
+void da_shrink_to_fit_(void** da, size_t sz) {
+	if (*da == NULL) {
+		return;
+	}
+
+	if (da_size(*da) == da_capacity(*da)) {
+		return;
+	}
+
+	da_reserve_(da, da_size(*da), sz);
+}
+
+void da_set_growth_(void* da, const da_growth* growth) {
+	if (da == NULL) {
+		return;
+	}
+
+	da_header(da)->growth = growth;
+}
+
+/*///////////////////////////////////////////////////////////////////////////*/
+/* Modifiers                                                                 */
+/*///////////////////////////////////////////////////////////////////////////*/
+
+void da_clear_(void** da, size_t sz) {
+	void* tmp;
+
+	if (*da == NULL) {
+		return;
+	}
+
+	if (!da_is_mapped(*da) && sole_holder(*da)) {
+		da_var_first(*da) = 0;
+		da_var_size(*da) = 0;
+		return;
+	}
+
+	/* nothing to copy: drop the reference, or the file, for a new array */
+	tmp = init_like(*da, sz);
+	if (tmp == NULL) {
+		return;
+	}
+
+	da_free_(*da, sz);
+	*da = tmp;
+}
+
+void da_insert_(void** da, size_t idx, void* val, size_t sz) {
+	void* dst;
+	void* src;
+
+	if (*da == NULL) {
+		*da = da_init(sz);
+	}
+
+	if (*da == NULL || own(da, sz) != 0) {
+		return;
+	}
+
+	if (idx >= da_capacity(*da)) {
+		return;
+	}
+
+	if (da_size(*da) == da_capacity(*da)) {
+		grow(da, da_size(*da) + 1, sz);
+	}
+
+	if (da_size(*da) == da_capacity(*da)) {
+		return;
+	}
+
+	/* shift elements */
+	if (idx <= da_size(*da)) {
+		dst = (char*)*da + sz * (idx + 1);
+		src = (char*)*da + sz * idx;
+		memmove(dst, src, (da_size(*da) - idx) * sz);
+		da_stat_add(*da, bytes_moved, (da_size(*da) - idx) * sz);
+	}
+
+	dst = (char*)*da + sz * idx;
+	memcpy(dst, val, sz);
+	++(da_var_size(*da));
+}
+
+void da_insert_n_(
+	void** da, size_t idx, const void* src, size_t cnt, size_t sz
+) {
+	char* at;
+
+	if (*da == NULL) {
+		*da = da_init(sz);
+	}
+
+	if (*da == NULL) {
+		return;
+	}
+
+	if (idx > da_size(*da) || cnt == 0) {
+		return;
+	}
+
+	reserve_more(da, cnt, sz);
+	if (da_capacity(*da) - da_size(*da) < cnt) {
+		return;
+	}
+
+	/* shift elements */
+	at = (char*)*da + sz * idx;
+	memmove(at + sz * cnt, at, (da_size(*da) - idx) * sz);
+	da_stat_add(*da, bytes_moved, (da_size(*da) - idx) * sz);
+
+	memcpy(at, src, cnt * sz);
+	da_var_size(*da) += cnt;
+}
+
+void da_erase_(void** da, size_t idx, size_t sz) {
+	void* dst;
+	void* src;
+
+	if (*da == NULL) {
+		return;
+	}
+
+	if (idx >= da_size(*da) || own(da, sz) != 0) {
+		return;
+	}
+
+	/* shift elements */
+	if (idx <= da_size(*da)) {
+		dst = (char*)*da + sz * idx;
+		src = (char*)*da + sz * (idx + 1);
+		memmove(dst, src, (da_size(*da) - (idx + 1)) * sz);
+		da_stat_add(*da, bytes_moved, (da_size(*da) - (idx + 1)) * sz);
+	}
+
+	--(da_var_size(*da));
+	shrink(da, sz);
+}
+
+void da_erase_range_(void** da, size_t first, size_t last, size_t sz) {
+	char* dst;
+
+	if (*da == NULL) {
+		return;
+	}
+
+	if (last > da_size(*da)) {
+		last = da_size(*da);
+	}
+
+	if (first >= last || own(da, sz) != 0) {
+		return;
+	}
+
+	/* shift elements */
+	dst = (char*)*da + sz * first;
+	memmove(dst, dst + sz * (last - first), (da_size(*da) - last) * sz);
+	da_stat_add(*da, bytes_moved, (da_size(*da) - last) * sz);
+
+	da_var_size(*da) -= last - first;
+	shrink(da, sz);
+}
+
+void da_swap_remove_(void** da, size_t idx, size_t sz) {
+	char* last;
+
+	if (*da == NULL) {
+		return;
+	}
+
+	if (idx >= da_size(*da) || own(da, sz) != 0) {
+		return;
+	}
+
+	last = (char*)*da + sz * (da_size(*da) - 1);
+	if (idx + 1 < da_size(*da)) {
+		memcpy((char*)*da + sz * idx, last, sz);
+	}
+
+	--(da_var_size(*da));
+	shrink(da, sz);
+}
+
+size_t da_remove_if_(void** da, da_predicate pred, void* ctx, size_t sz) {
+	char* base;
+	size_t kept = 0;
+	size_t run = 0; /* start of the current run of survivors */
+	size_t size;
+	size_t i;
+
+	if (*da == NULL || own(da, sz) != 0) {
+		return 0;
+	}
+
+	base = *da;
+	size = da_size(*da);
+
+	/* survivors are moved a run at a time rather than one by one */
+	for (i = 0; i < size; ++i) {
+		if (!pred(base + sz * i, ctx)) {
+			continue;
+		}
+
+		if (run != kept) {
+			memmove(base + sz * kept, base + sz * run, (i - run) * sz);
+			da_stat_add(*da, bytes_moved, (i - run) * sz);
+		}
+		kept += i - run;
+		run = i + 1;
+	}
+
+	if (run != kept) {
+		memmove(base + sz * kept, base + sz * run, (size - run) * sz);
+		da_stat_add(*da, bytes_moved, (size - run) * sz);
+	}
+	kept += size - run;
+
+	da_var_size(*da) = kept;
+	shrink(da, sz);
+	return size - kept;
+}
+
+void da_append_(void** da, void* val, size_t sz) {
+	void* dst;
+
+	if (*da == NULL) { *da = da_init(sz); }
+
+	if (*da == NULL) { return; }
+
+	if (da_size(*da) == da_capacity(*da)) {
+		grow(da, da_size(*da) + 1, sz);
+	}
+
+	if (da_size(*da) == da_capacity(*da)) {
+		return;
+	}
+
+	dst = (char*)*da + sz * da_size(*da);
+	memcpy(dst, val, sz);
+	++(da_var_size(*da));
+}
+
+void da_append_n_(void** da, const void* src, size_t cnt, size_t sz) {
+	if (*da == NULL) { *da = da_init(sz); }
+
+	if (*da == NULL) { return; }
+
+	reserve_more(da, cnt, sz);
+	if (da_capacity(*da) - da_size(*da) < cnt) {
+		return;
+	}
+
+	memcpy((char*)*da + sz * da_size(*da), src, cnt * sz);
+	da_var_size(*da) += cnt;
+}
+
+/*///////////////////////////////////////////////////////////////////////////*/
+/* Deque                                                                     */
+/*///////////////////////////////////////////////////////////////////////////*/
+
+/* reverses the order of `cnt` elements in place */
+static void reverse(char* base, size_t cnt, size_t sz) {
+	char* lo = base;
+	char* hi = base + sz * cnt;
+	size_t i;
+
+	while (cnt-- > 1 && lo < (hi -= sz)) {
+		for (i = 0; i < sz; ++i) {
+			char tmp = lo[i];
+			lo[i] = hi[i];
+			hi[i] = tmp;
+		}
+		lo += sz;
+	}
+}
+
+void* da_deque_at_(void* da, size_t idx, size_t sz) {
+	if (da == NULL) {
+		return NULL;
+	}
+
+	if (idx >= da_size(da)) {
+		return NULL;
+	}
+
+	return (char*)da + sz * da_deque_pos_(da, idx);
+}
+
+void da_deque_push_(void** da, const void* val, int front, size_t sz) {
+	size_t pos;
+
+	if (*da == NULL) { *da = da_init(sz); }
+
+	if (*da == NULL) { return; }
+
+	if (da_size(*da) == da_capacity(*da)) {
+		grow(da, da_size(*da) + 1, sz);
+	}
+
+	if (da_size(*da) == da_capacity(*da)) {
+		return;
+	}
+
+	if (front) {
+		pos = da_var_first(*da);
+		pos = pos == 0 ? da_capacity(*da) - 1 : pos - 1;
+		da_var_first(*da) = pos;
+	} else {
+		pos = da_deque_pos_(*da, da_size(*da));
+	}
+
+	memcpy((char*)*da + sz * pos, val, sz);
+	++(da_var_size(*da));
+}
+
+void da_deque_pop_(void** da, int front, size_t sz) {
+	if (*da == NULL || da_size(*da) == 0) {
+		return;
+	}
+
+	if (own(da, sz) != 0) {
+		return;
+	}
+
+	if (front) {
+		da_var_first(*da) = da_deque_pos_(*da, 1);
+	}
+
+	/* an empty deque is a plain array */
+	if (--(da_var_size(*da)) == 0) {
+		da_var_first(*da) = 0;
+	}
+}
+
+void* da_deque_linearize_(void* da, size_t sz) {
+	char* base = da;
+	size_t first;
+	size_t cap;
+
+	if (da == NULL || da_var_first(da) == 0) {
+		return da;
+	}
+
+	first = da_var_first(da);
+	cap = da_capacity(da);
+
+	if (first + da_size(da) <= cap) {
+		memmove(base, base + sz * first, sz * da_size(da));
+	} else {
+		/* rotate the whole ring left by `first` */
+		reverse(base, first, sz);
+		reverse(base + sz * first, cap - first, sz);
+		reverse(base, cap, sz);
+	}
+
+	da_var_first(da) = 0;
+	return da;
+}
+
+/*///////////////////////////////////////////////////////////////////////////*/
+/* Concurrent append                                                         */
+/*///////////////////////////////////////////////////////////////////////////*/
+
+/* segment 0 is at least this many elements */
+#define DA_CONC_BASE_MIN 16
+
+/* index of the highest set bit, `x` MUST NOT be `0` */
+static size_t log2_floor(size_t x) {
+	return da_seg_log2_(x);
+}
+
+/* segment `k` >= 1 starts at element `base * (2^k - 1)` */
+#define da_conc_seg_len(conc, k) ((conc)->base << (k))
+#define da_conc_seg_start(conc, k) ((conc)->base * (((size_t)1 << (k)) - 1))
+
+/* segment holding element `idx`, and the offset into it */
+static size_t conc_locate(const da_conc* conc, size_t idx, size_t* off) {
+	size_t k;
+
+	if (idx < conc->base) {
+		*off = idx;
+		return 0;
+	}
+
+	/* avoid the division for the default (or any power of two) base */
+	if ((conc->base & (conc->base - 1)) == 0) {
+		k = log2_floor((idx >> log2_floor(conc->base)) + 1);
+	} else {
+		k = log2_floor(idx / conc->base + 1);
+	}
+
+	*off = idx - da_conc_seg_start(conc, k);
+	return k;
+}
+
+/* flags of a segment, `NULL` if it is not allocated yet */
+static unsigned char* conc_ready(da_conc* conc, size_t k) {
+	char* seg;
+
+	if (k == 0) { return conc->ready; }
+
+	seg = __atomic_load_n(&conc->segments[k], __ATOMIC_ACQUIRE);
+	if (seg == NULL) { return NULL; }
+
+	return (unsigned char*)seg + da_conc_seg_len(conc, k) * conc->sz;
+}
+
+/* bytes of segment `k` >= 1: its elements, then a ready flag for each */
+#define da_conc_seg_bytes(conc, k) (da_conc_seg_len(conc, k) * ((conc)->sz + 1))
+
+/* allocates (or finds) segment `k` >= 1, `NULL` if out of memory */
+static void* conc_segment(da_conc* conc, size_t k) {
+	void* expected = NULL;
+	void* seg;
+	size_t len;
+
+	seg = __atomic_load_n(&conc->segments[k], __ATOMIC_ACQUIRE);
+	if (seg != NULL) {
+		return seg;
+	}
+
+	len = da_conc_seg_len(conc, k);
+	if (len >> k != conc->base || len > DA_SIZE_MAX / (conc->sz + 1)) {
+		return NULL;
+	}
+
+	seg = block_alloc(conc->allocator, da_conc_seg_bytes(conc, k));
+	if (seg == NULL) {
+		return NULL;
+	}
+	memset((char*)seg + len * conc->sz, 0, len);
+
+	/* another producer may have got there first */
+	if (!__atomic_compare_exchange_n(
+		&conc->segments[k], &expected, seg, 0,
+		__ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE
+	)) {
+		block_release(conc->allocator, seg, da_conc_seg_bytes(conc, k));
+		return expected;
+	}
+
+	return seg;
+}
+
+/*
+ * allocates every segment holding the slots [`idx`, `idx` + `cnt`), where
+ * `idx` <= `claimed` (so the segments below are allocated), and raises
+ * `allocated` to the end of the last one
+ */
+static int conc_allocate(da_conc* conc, size_t idx, size_t cnt) {
+	size_t off;
+	size_t k;
+	size_t last;
+	size_t end;
+	size_t seen;
+
+	if (idx + cnt < idx) {
+		return -1;
+	}
+
+	last = conc_locate(conc, idx + cnt - 1, &off);
+	if (last >= DA_CONC_SEGMENTS) {
+		return -1;
+	}
+
+	for (k = conc_locate(conc, idx, &off); k <= last; ++k) {
+		if (k != 0 && conc_segment(conc, k) == NULL) {
+			return -1;
+		}
+	}
+
+	end = da_conc_seg_start(conc, last + 1);
+	seen = __atomic_load_n(&conc->allocated, __ATOMIC_RELAXED);
+	while (seen < end && !__atomic_compare_exchange_n(
+		&conc->allocated, &seen, end, 1,
+		__ATOMIC_RELEASE, __ATOMIC_RELAXED
+	)) {
+		/* `seen` is updated by a failed exchange */
+	}
+
+	return 0;
+}
+
+/*
+ * Claims `cnt` (> 0) slots, once the segments holding them exist: A claimed
+ * slot is always written, so the published prefix never stalls behind a
+ * failed allocation. The claim is a compare-and-swap rather than an
+ * increment; Another producer claiming first just moves the range, whose
+ * segments are usually allocated already (below `allocated`).
+ */
+static int conc_claim(da_conc* conc, size_t cnt, size_t* idx) {
+	size_t first = __atomic_load_n(&conc->claimed, __ATOMIC_RELAXED);
+	size_t allocated;
+
+	do {
+		allocated = __atomic_load_n(&conc->allocated, __ATOMIC_ACQUIRE);
+		if ((first > allocated || cnt > allocated - first)
+				&& conc_allocate(conc, first, cnt) != 0) {
+			errno = ENOMEM;
+			return -1;
+		}
+	} while (!__atomic_compare_exchange_n(
+		&conc->claimed, &first, first + cnt, 1,
+		__ATOMIC_RELAXED, __ATOMIC_RELAXED
+	));
+
+	*idx = first;
+	return 0;
+}
+
+int da_conc_init(da_conc* conc, size_t sz, size_t reserve) {
+	return da_conc_init_with(conc, sz, reserve, NULL);
+}
+
+int da_conc_init_with(
+	da_conc* conc, size_t sz, size_t reserve, const da_allocator* allocator
+) {
+	memset(conc, 0, sizeof(*conc));
+	conc->sz = sz;
+	conc->base = reserve < DA_CONC_BASE_MIN ? DA_CONC_BASE_MIN : reserve;
+	conc->allocator = allocator;
+	conc->allocated = conc->base;
+
+	conc->segments[0] = da_init_with(sz, allocator);
+	da_reserve_(&conc->segments[0], conc->base, sz);
+	conc->ready = block_alloc(allocator, conc->base);
+	if (conc->ready == NULL || conc->segments[0] == NULL
+			|| da_capacity(conc->segments[0]) < conc->base) {
+		da_free_(conc->segments[0], sz);
+		if (conc->ready != NULL) {
+			block_release(allocator, conc->ready, conc->base);
+		}
+		memset(conc, 0, sizeof(*conc));
+		errno = ENOMEM;
+		return -1;
+	}
+	memset(conc->ready, 0, conc->base);
+
+	return 0;
+}
+
+int da_conc_append(da_conc* conc, const void* val) {
+	size_t idx;
+	size_t off;
+	size_t k;
+	char* seg;
+
+	if (conc_claim(conc, 1, &idx) != 0) {
+		return -1;
+	}
+
+	k = conc_locate(conc, idx, &off);
+	seg = __atomic_load_n(&conc->segments[k], __ATOMIC_ACQUIRE);
+	memcpy(seg + off * conc->sz, val, conc->sz);
+	__atomic_store_n(&conc_ready(conc, k)[off], 1, __ATOMIC_RELEASE);
+	return 0;
+}
+
+int da_conc_append_n(da_conc* conc, const void* src, size_t cnt) {
+	const char* from = src;
+	size_t idx;
+
+	if (cnt == 0) {
+		return 0;
+	}
+
+	if (conc_claim(conc, cnt, &idx) != 0) {
+		return -1;
+	}
+
+	/* the claimed range may span several segments */
+	while (cnt > 0) {
+		size_t off;
+		size_t k = conc_locate(conc, idx, &off);
+		size_t n = da_conc_seg_len(conc, k) - off;
+		unsigned char* ready;
+		char* seg;
+
+		seg = __atomic_load_n(&conc->segments[k], __ATOMIC_ACQUIRE);
+		if (n > cnt) { n = cnt; }
+		memcpy(seg + off * conc->sz, from, n * conc->sz);
+		ready = conc_ready(conc, k) + off;
+		idx += n;
+		from += n * conc->sz;
+		cnt -= n;
+		while (n-- > 0) {
+			__atomic_store_n(ready++, 1, __ATOMIC_RELEASE);
+		}
+	}
+
+	return 0;
+}
+
+size_t da_conc_size(da_conc* conc) {
+	size_t seen = __atomic_load_n(&conc->published, __ATOMIC_ACQUIRE);
+	size_t claimed = __atomic_load_n(&conc->claimed, __ATOMIC_RELAXED);
+	size_t n = seen;
+
+	/* extend the prefix over every slot written since */
+	while (n < claimed) {
+		size_t off;
+		size_t k = conc_locate(conc, n, &off);
+		size_t start = n - off;
+		size_t end = start + da_conc_seg_len(conc, k);
+		unsigned char* ready;
+
+		if (k >= DA_CONC_SEGMENTS) { break; }
+
+		ready = conc_ready(conc, k);
+		if (ready == NULL) { break; }
+
+		if (end > claimed) { end = claimed; }
+		while (n < end && __atomic_load_n(
+			&ready[n - start], __ATOMIC_ACQUIRE
+		)) {
+			++n;
+		}
+		if (n < end) { break; }
+	}
+
+	/* publish, unless another reader got further */
+	while (n > seen && !__atomic_compare_exchange_n(
+		&conc->published, &seen, n, 1,
+		__ATOMIC_RELEASE, __ATOMIC_ACQUIRE
+	)) {
+		/* `seen` is updated by a failed exchange */
+	}
+
+	return n > seen ? n : seen;
+}
+
+void* da_conc_at(da_conc* conc, size_t idx) {
+	size_t off;
+	size_t k;
+	char* seg;
+
+	if (idx >= __atomic_load_n(&conc->published, __ATOMIC_ACQUIRE)) {
+		return NULL;
+	}
+
+	k = conc_locate(conc, idx, &off);
+	seg = __atomic_load_n(&conc->segments[k], __ATOMIC_ACQUIRE);
+	return seg + off * conc->sz;
+}
+
+void* da_conc_to_da(da_conc* conc) {
+	size_t n = da_conc_size(conc);
+	void* da = conc->segments[0];
+	size_t k;
+
+	da_var_size(da) = n < conc->base ? n : conc->base;
+	for (k = 1; k < DA_CONC_SEGMENTS && da_size(da) < n; ++k) {
+		size_t cnt = n - da_size(da);
+		size_t before = da_size(da);
+
+		if (cnt > da_conc_seg_len(conc, k)) {
+			cnt = da_conc_seg_len(conc, k);
+		}
+
+		da_append_n_(&da, conc->segments[k], cnt, conc->sz);
+		if (da_size(da) == before) {
+			return NULL;
+		}
+		conc->segments[0] = da;
+	}
+
+	conc->segments[0] = NULL;
+	da_conc_free(conc);
+	return da;
+}
+
+void da_conc_free(da_conc* conc) {
+	size_t k;
+
+	da_free_(conc->segments[0], conc->sz);
+	for (k = 1; k < DA_CONC_SEGMENTS; ++k) {
+		if (conc->segments[k] != NULL) {
+			block_release(conc->allocator, conc->segments[k],
+				da_conc_seg_bytes(conc, k));
+		}
+	}
+	if (conc->ready != NULL) {
+		block_release(conc->allocator, conc->ready, conc->base);
+	}
+	memset(conc, 0, sizeof(*conc));
+}
+
+/*///////////////////////////////////////////////////////////////////////////*/
+/* Segmented array                                                           */
+/*///////////////////////////////////////////////////////////////////////////*/
+
+/* `size` and `capacity` must stay last, as for `struct da_header` */
+struct da_seg_header {
+	size_t capacity;
+	size_t size;
+};
+
+#define da_seg_header(seg) ((struct da_seg_header*)(seg) - 1)
+
+/* chunks allocated so far, from the capacity `DA_SEG_FIRST * (2^n - 1)` */
+#define da_seg_chunks(seg) da_seg_chunk_(da_var_capacity(seg))
+
+/* address of an element, without bounds checking */
+#define da_seg_elem(seg, idx, sz)                                             \
+	((char*)((void**)(seg))[da_seg_chunk_(idx)]                           \
+		+ (sz) * da_seg_offset_(idx))
+
+void* da_seg_init(size_t sz) {
+	struct da_seg_header* head;
+
+	if (sz == 0) {
+		return NULL;
+	}
+
+	head = calloc(1, sizeof(*head) + DA_SEG_CHUNKS * sizeof(void*));
+	if (head == NULL) {
+		return NULL;
+	}
+
+	return head + 1;
+}
+
+void da_seg_free_(void* seg) {
+	size_t k;
+
+	if (seg == NULL) {
+		return;
+	}
+
+	for (k = 0; k < da_seg_chunks(seg); ++k) {
+		free(((void**)seg)[k]);
+	}
+	free(da_seg_header(seg));
+}
+
+void* da_seg_at_(void* seg, size_t idx, size_t sz) {
+	if (seg == NULL) {
+		return NULL;
+	}
+
+	if (idx >= da_size(seg)) {
+		return NULL;
+	}
+
+	return da_seg_elem(seg, idx, sz);
+}
+
+void da_seg_reserve_(void** seg, size_t cnt, size_t sz) {
+	if (*seg == NULL) {
+		*seg = da_seg_init(sz);
+	}
+
+	if (*seg == NULL) {
+		return;
+	}
+
+	/* more than every chunk holds */
+	if (cnt > ((size_t)DA_SEG_FIRST << DA_SEG_CHUNKS) - DA_SEG_FIRST) {
+		errno = ENOMEM;
+		return;
+	}
+
+	/* one chunk at a time, nothing already allocated ever moves */
+	while (da_capacity(*seg) < cnt) {
+		size_t k = da_seg_chunks(*seg);
+		size_t len = (size_t)DA_SEG_FIRST << k;
+		void* chunk;
+
+		if (k >= DA_SEG_CHUNKS || len > DA_SIZE_MAX / sz) {
+			errno = ENOMEM;
+			return;
+		}
+
+		chunk = malloc(len * sz);
+		if (chunk == NULL) {
+			return;
+		}
+
+		((void**)*seg)[k] = chunk;
+		da_var_capacity(*seg) += len;
+	}
+}
+
+void da_seg_append_(void** seg, const void* val, size_t sz) {
+	size_t len;
+
+	if (*seg == NULL) { *seg = da_seg_init(sz); }
+
+	if (*seg == NULL) { return; }
+
+	len = da_size(*seg);
+	if (len == da_capacity(*seg)) {
+		da_seg_reserve_(seg, len + 1, sz);
+	}
+
+	if (len == da_capacity(*seg)) {
+		return;
+	}
+
+	memcpy(da_seg_elem(*seg, len, sz), val, sz);
+	++(da_var_size(*seg));
+}
+
+void* da_seg_to_da_(void* seg, size_t sz) {
+	void* da = NULL;
+	size_t left = da_size(seg);
+	size_t k;
+
+	if (left == 0) {
+		return NULL;
+	}
+
+	da_reserve_(&da, left, sz);
+	if (da_capacity(da) < left) {
+		da_free_(da, sz);
+		return NULL;
+	}
+
+	for (k = 0; left > 0; ++k) {
+		size_t cnt = (size_t)DA_SEG_FIRST << k;
+
+		if (cnt > left) { cnt = left; }
+		da_append_n_(&da, ((void**)seg)[k], cnt, sz);
+		left -= cnt;
+	}
+
+	return da;
+}
+
+/*///////////////////////////////////////////////////////////////////////////*/
+/* Search                                                                    */
+/*///////////////////////////////////////////////////////////////////////////*/
+
+/*
+ * One kernel per instruction set and element type, each both finding (the
+ * index of the first match, `n` if none) and counting (`all` != 0).
+ *
+ * Elements before the first aligned vector and after the last whole one are
+ * compared one at a time. The vector loop turns each comparison into a bit
+ * mask, `bits` bits per element.
+ */
+typedef size_t (*da_scan_fn)(const void*, size_t, const void*, int);
+
+#define da_define_scan_scalar(name, type)                                     \
+static size_t name(const void* p_, size_t n, const void* val, int all) {      \
+	const type* p = p_;                                                   \
+	type v = *(const type*)val;                                           \
+	size_t found = 0;                                                     \
+	size_t i;                                                             \
+                                                                              \
+	for (i = 0; i < n; ++i) {                                             \
+		if (p[i] == v) { if (!all) { return i; } ++found; }           \
+	}                                                                     \
+                                                                              \
+	return all ? found : n;                                               \
+}
+
+da_define_scan_scalar(scan_u8, uint8_t)
+da_define_scan_scalar(scan_u16, uint16_t)
+da_define_scan_scalar(scan_u32, uint32_t)
+da_define_scan_scalar(scan_u64, uint64_t)
+da_define_scan_scalar(scan_f32, float)
+da_define_scan_scalar(scan_f64, double)
+
+#ifdef DA_SIMD_X86
+
+#define da_define_scan(name, target, type, vec_bytes, setup, mask, bits)      \
+target static size_t name(const void* p_, size_t n, const void* val, int all) \
+{                                                                             \
+	const type* p = p_;                                                   \
+	type v = *(const type*)val;                                           \
+	size_t found = 0;                                                     \
+	size_t i = 0;                                                         \
+	setup                                                                 \
+                                                                              \
+	for (; i < n && (size_t)(p + i) % (vec_bytes) != 0; ++i) {            \
+		if (p[i] == v) { if (!all) { return i; } ++found; }           \
+	}                                                                     \
+	for (; n - i >= (vec_bytes) / sizeof(type);                           \
+			i += (vec_bytes) / sizeof(type)) {                    \
+		unsigned long m = (mask);                                     \
+		if (m == 0) { continue; }                                     \
+		if (!all) { return i + __builtin_ctzl(m) / (bits); }          \
+		found += __builtin_popcountl(m) / (bits);                     \
+	}                                                                     \
+	for (; i < n; ++i) {                                                  \
+		if (p[i] == v) { if (!all) { return i; } ++found; }           \
+	}                                                                     \
+                                                                              \
+	return all ? found : n;                                               \
+}
+
+/* the loads are aligned: `i` is past the unaligned head */
+#define da_ld(type) ((const type*)(p + i))
+
+#define DA_SCAN_SSE2 __attribute__((target("sse2,popcnt")))
+
+da_define_scan(scan_u8_sse2, DA_SCAN_SSE2, uint8_t, 16,
+	__m128i k = _mm_set1_epi8(v);,
+	(unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(*da_ld(__m128i), k)), 1)
+da_define_scan(scan_u16_sse2, DA_SCAN_SSE2, uint16_t, 16,
+	__m128i k = _mm_set1_epi16(v);,
+	(unsigned)_mm_movemask_epi8(_mm_cmpeq_epi16(*da_ld(__m128i), k)), 2)
+da_define_scan(scan_u32_sse2, DA_SCAN_SSE2, uint32_t, 16,
+	__m128i k = _mm_set1_epi32(v);,
+	(unsigned)_mm_movemask_epi8(_mm_cmpeq_epi32(*da_ld(__m128i), k)), 4)
+/* no 64-bit compare before SSE4.1: both halves must match */
+da_define_scan(scan_u64_sse2, DA_SCAN_SSE2, uint64_t, 16,
+	__m128i k = _mm_set1_epi64x(v); __m128i c;,
+	(c = _mm_cmpeq_epi32(*da_ld(__m128i), k),
+	(unsigned)_mm_movemask_epi8(_mm_and_si128(
+		c, _mm_shuffle_epi32(c, _MM_SHUFFLE(2, 3, 0, 1))
+	))), 8)
+da_define_scan(scan_f32_sse2, DA_SCAN_SSE2, float, 16,
+	__m128 k = _mm_set1_ps(v);,
+	(unsigned)_mm_movemask_ps(_mm_cmpeq_ps(*da_ld(__m128), k)), 1)
+da_define_scan(scan_f64_sse2, DA_SCAN_SSE2, double, 16,
+	__m128d k = _mm_set1_pd(v);,
+	(unsigned)_mm_movemask_pd(_mm_cmpeq_pd(*da_ld(__m128d), k)), 1)
+
+#define DA_SCAN_AVX2 __attribute__((target("avx2,popcnt")))
+
+da_define_scan(scan_u8_avx2, DA_SCAN_AVX2, uint8_t, 32,
+	__m256i k = _mm256_set1_epi8(v);,
+	(unsigned)_mm256_movemask_epi8(
+		_mm256_cmpeq_epi8(*da_ld(__m256i), k)
+	), 1)
+da_define_scan(scan_u16_avx2, DA_SCAN_AVX2, uint16_t, 32,
+	__m256i k = _mm256_set1_epi16(v);,
+	(unsigned)_mm256_movemask_epi8(
+		_mm256_cmpeq_epi16(*da_ld(__m256i), k)
+	), 2)
+da_define_scan(scan_u32_avx2, DA_SCAN_AVX2, uint32_t, 32,
+	__m256i k = _mm256_set1_epi32(v);,
+	(unsigned)_mm256_movemask_epi8(
+		_mm256_cmpeq_epi32(*da_ld(__m256i), k)
+	), 4)
+da_define_scan(scan_u64_avx2, DA_SCAN_AVX2, uint64_t, 32,
+	__m256i k = _mm256_set1_epi64x(v);,
+	(unsigned)_mm256_movemask_epi8(
+		_mm256_cmpeq_epi64(*da_ld(__m256i), k)
+	), 8)
+da_define_scan(scan_f32_avx2, DA_SCAN_AVX2, float, 32,
+	__m256 k = _mm256_set1_ps(v);,
+	(unsigned)_mm256_movemask_ps(
+		_mm256_cmp_ps(*da_ld(__m256), k, _CMP_EQ_OQ)
+	), 1)
+da_define_scan(scan_f64_avx2, DA_SCAN_AVX2, double, 32,
+	__m256d k = _mm256_set1_pd(v);,
+	(unsigned)_mm256_movemask_pd(
+		_mm256_cmp_pd(*da_ld(__m256d), k, _CMP_EQ_OQ)
+	), 1)
+
+#define DA_SCAN_AVX512                                                        \
+	__attribute__((target("avx512f,avx512bw,popcnt")))
+
+da_define_scan(scan_u8_avx512, DA_SCAN_AVX512, uint8_t, 64,
+	__m512i k = _mm512_set1_epi8(v);,
+	_mm512_cmpeq_epi8_mask(*da_ld(__m512i), k), 1)
+da_define_scan(scan_u16_avx512, DA_SCAN_AVX512, uint16_t, 64,
+	__m512i k = _mm512_set1_epi16(v);,
+	_mm512_cmpeq_epi16_mask(*da_ld(__m512i), k), 1)
+da_define_scan(scan_u32_avx512, DA_SCAN_AVX512, uint32_t, 64,
+	__m512i k = _mm512_set1_epi32(v);,
+	_mm512_cmpeq_epi32_mask(*da_ld(__m512i), k), 1)
+da_define_scan(scan_u64_avx512, DA_SCAN_AVX512, uint64_t, 64,
+	__m512i k = _mm512_set1_epi64(v);,
+	_mm512_cmpeq_epi64_mask(*da_ld(__m512i), k), 1)
+da_define_scan(scan_f32_avx512, DA_SCAN_AVX512, float, 64,
+	__m512 k = _mm512_set1_ps(v);,
+	_mm512_cmp_ps_mask(*da_ld(__m512), k, _CMP_EQ_OQ), 1)
+da_define_scan(scan_f64_avx512, DA_SCAN_AVX512, double, 64,
+	__m512d k = _mm512_set1_pd(v);,
+	_mm512_cmp_pd_mask(*da_ld(__m512d), k, _CMP_EQ_OQ), 1)
+
+#endif /* DA_SIMD_X86 */
+
+/* rows by `enum da_simd`, columns: 1, 2, 4, 8 bytes, float, double */
+static const da_scan_fn da_scans[][6] = {
+	{ scan_u8, scan_u16, scan_u32, scan_u64, scan_f32, scan_f64 },
+#ifdef DA_SIMD_X86
+	{
+		scan_u8_sse2, scan_u16_sse2, scan_u32_sse2,
+		scan_u64_sse2, scan_f32_sse2, scan_f64_sse2
+	},
+	{
+		scan_u8_avx2, scan_u16_avx2, scan_u32_avx2,
+		scan_u64_avx2, scan_f32_avx2, scan_f64_avx2
+	},
+	{
+		scan_u8_avx512, scan_u16_avx512, scan_u32_avx512,
+		scan_u64_avx512, scan_f32_avx512, scan_f64_avx512
+	}
+#endif
+};
+
+/* -1 until detected */
+static int da_simd = -1;
+
+static enum da_simd simd_detect(void) {
+#ifdef DA_SIMD_X86
+	/* every kernel counts matches with `popcnt` */
+	if (!__builtin_cpu_supports("popcnt")) { return DA_SIMD_NONE; }
+	if (__builtin_cpu_supports("avx512f")
+			&& __builtin_cpu_supports("avx512bw")) {
+		return DA_SIMD_AVX512;
+	}
+	if (__builtin_cpu_supports("avx2")) { return DA_SIMD_AVX2; }
+	return DA_SIMD_SSE2;
+#else
+	return DA_SIMD_NONE;
+#endif
+}
+
+enum da_simd da_simd_level(void) {
+	int level = __atomic_load_n(&da_simd, __ATOMIC_RELAXED);
+
+	if (level < 0) {
+		level = simd_detect();
+		__atomic_store_n(&da_simd, level, __ATOMIC_RELAXED);
+	}
+
+	return (enum da_simd)level;
+}
+
+enum da_simd da_set_simd_level(enum da_simd level) {
+	enum da_simd best = simd_detect();
+
+	if (level > best) { level = best; }
+	__atomic_store_n(&da_simd, (int)level, __ATOMIC_RELAXED);
+
+	return level;
+}
+
+/* index of the first match (`all` == 0) or number of matches */
+static size_t scan(
+	void* da, const void* val, size_t sz, int kind, int all
+) {
+	size_t n = da_size(da);
+	size_t col;
+	size_t found = 0;
+	size_t i;
+
+	switch (sz) {
+	case 1: col = 0; break;
+	case 2: col = 1; break;
+	case 4: col = kind == DA_KIND_FLOAT ? 4 : 2; break;
+	case 8: col = kind == DA_KIND_FLOAT ? 5 : 3; break;
+	default:
+		/* anything else is compared byte for byte */
+		for (i = 0; i < n; ++i) {
+			if (memcmp((const char*)da + sz * i, val, sz) == 0) {
+				if (!all) { return i; }
+				++found;
+			}
+		}
+		return all ? found : n;
+	}
+
+	if (n == 0) {
+		return 0;
+	}
+
+	return da_scans[da_simd_level()][col](da, n, val, all);
+}
+
+void* da_find_(void* da, const void* val, size_t sz, int kind) {
+	size_t idx;
+
+	if (da == NULL) {
+		return NULL;
+	}
+
+	idx = scan(da, val, sz, kind, 0);
+	return idx < da_size(da) ? (char*)da + sz * idx : NULL;
+}
+
+size_t da_count_(void* da, const void* val, size_t sz, int kind) {
+	if (da == NULL) {
+		return 0;
+	}
+
+	return scan(da, val, sz, kind, 1);
+}
+
+/*///////////////////////////////////////////////////////////////////////////*/
+/* Reductions and transforms                                                 */
+/*///////////////////////////////////////////////////////////////////////////*/
+
+/*
+ * The kernels are plain loops which the compiler vectorises, built once per
+ * instruction set. Reductions keep `DA_LANES` independent accumulators, so
+ * floating point sums can be vectorised without reordering additions
+ * differently at each level: every level gives the same result.
+ */
+#define DA_LANES 16
+
+struct da_kernels {
+	void (*sum)(const void* p, size_t n, void* out);
+	void (*minmax)(const void* p, size_t n, void* min, void* max);
+	void (*scale)(void* p, size_t n, const void* factor);
+	void (*add)(void* p, size_t n, const void* val);
+};
+
+/* folds the lanes `mins` and `maxs`, then elements `i` to `n` */
+#define da_minmax_finish(type, lo, hi)                                        \
+	type lo_ = hi;                                                        \
+	type hi_ = lo;                                                        \
+                                                                              \
+	for (j = 0; j < DA_LANES; ++j) {                                      \
+		lo_ = mins[j] < lo_ ? mins[j] : lo_;                          \
+		hi_ = maxs[j] > hi_ ? maxs[j] : hi_;                          \
+	}                                                                     \
+	for (; i < n; ++i) {                                                  \
+		lo_ = p[i] < lo_ ? p[i] : lo_;                                \
+		hi_ = p[i] > hi_ ? p[i] : hi_;                                \
+	}                                                                     \
+	/* only if every element is NaN */                                    \
+	if (lo_ > hi_) { lo_ = p[0]; hi_ = p[0]; }                            \
+	*(type*)min = lo_;                                                    \
+	*(type*)max = hi_;
+
+/* `lo` and `hi`: the neutral elements of max and min */
+#define da_define_minmax(name, target, type, lo, hi)                          \
+target static void minmax_##name(                                             \
+	const void* p_, size_t n, void* min, void* max                        \
+) {                                                                           \
+	const type* p = p_;                                                   \
+	type mins[DA_LANES];                                                  \
+	type maxs[DA_LANES];                                                  \
+	size_t i, j;                                                          \
+                                                                              \
+	for (j = 0; j < DA_LANES; ++j) { mins[j] = hi; maxs[j] = lo; }        \
+	for (i = 0; n - i >= DA_LANES; i += DA_LANES) {                       \
+		for (j = 0; j < DA_LANES; ++j) {                              \
+			type x = p[i + j];                                    \
+			mins[j] = x < mins[j] ? x : mins[j];                  \
+			maxs[j] = x > maxs[j] ? x : maxs[j];                  \
+		}                                                             \
+	}                                                                     \
+	{                                                                     \
+		da_minmax_finish(type, lo, hi)                                \
+	}                                                                     \
+}
+
+/*
+ * `acc`: type of the sum, `wide`: type in which `scale` and `add` compute
+ * (unsigned for integers, so that overflow wraps)
+ */
+#define da_define_kernels(name, target, type, acc, wide)                      \
+target static void sum_##name(const void* p_, size_t n, void* out) {          \
+	const type* p = p_;                                                   \
+	acc lanes[DA_LANES] = { 0 };                                          \
+	acc total = 0;                                                        \
+	size_t i, j;                                                          \
+                                                                              \
+	for (i = 0; n - i >= DA_LANES; i += DA_LANES) {                       \
+		for (j = 0; j < DA_LANES; ++j) { lanes[j] += p[i + j]; }      \
+	}                                                                     \
+	for (j = 0; j < DA_LANES; ++j) { total += lanes[j]; }                 \
+	for (; i < n; ++i) { total += p[i]; }                                 \
+	*(acc*)out = total;                                                   \
+}                                                                             \
+                                                                              \
+target static void scale_##name(void* p_, size_t n, const void* factor) {     \
+	type* p = p_;                                                         \
+	wide f = *(const type*)factor;                                        \
+	size_t i;                                                             \
+                                                                              \
+	for (i = 0; i < n; ++i) { p[i] = (type)((wide)p[i] * f); }            \
+}                                                                             \
+                                                                              \
+target static void add_##name(void* p_, size_t n, const void* val) {          \
+	type* p = p_;                                                         \
+	wide v = *(const type*)val;                                           \
+	size_t i;                                                             \
+                                                                              \
+	for (i = 0; i < n; ++i) { p[i] = (type)((wide)p[i] + v); }            \
+}
+
+#define da_kernels(name) { sum_##name, minmax_##name, scale_##name, add_##name }
+
+/*
+ * One row of `da_kernel_table`, by element type. The compiler does not
+ * vectorise `x < min ? x : min` for floating point numbers, so `fminmax`
+ * defines min/max for `float` (`ps`) and `double` (`pd`).
+ */
+#define da_define_kernel_row(sfx, target, fminmax)                            \
+da_define_kernels(i8##sfx, target, int8_t, int64_t, unsigned)                 \
+da_define_kernels(i16##sfx, target, int16_t, int64_t, unsigned)               \
+da_define_kernels(i32##sfx, target, int32_t, int64_t, unsigned)               \
+da_define_kernels(i64##sfx, target, int64_t, int64_t, uint64_t)               \
+da_define_kernels(u8##sfx, target, uint8_t, uint64_t, unsigned)               \
+da_define_kernels(u16##sfx, target, uint16_t, uint64_t, unsigned)             \
+da_define_kernels(u32##sfx, target, uint32_t, uint64_t, unsigned)             \
+da_define_kernels(u64##sfx, target, uint64_t, uint64_t, uint64_t)             \
+da_define_kernels(f32##sfx, target, float, double, float)                     \
+da_define_kernels(f64##sfx, target, double, double, double)                   \
+da_define_minmax(i8##sfx, target, int8_t, INT8_MIN, INT8_MAX)                 \
+da_define_minmax(i16##sfx, target, int16_t, INT16_MIN, INT16_MAX)             \
+da_define_minmax(i32##sfx, target, int32_t, INT32_MIN, INT32_MAX)             \
+da_define_minmax(i64##sfx, target, int64_t, INT64_MIN, INT64_MAX)             \
+da_define_minmax(u8##sfx, target, uint8_t, 0, UINT8_MAX)                      \
+da_define_minmax(u16##sfx, target, uint16_t, 0, UINT16_MAX)                   \
+da_define_minmax(u32##sfx, target, uint32_t, 0, UINT32_MAX)                   \
+da_define_minmax(u64##sfx, target, uint64_t, 0, UINT64_MAX)                   \
+fminmax(f32##sfx, target, float, ps, -(float)HUGE_VAL, (float)HUGE_VAL)       \
+fminmax(f64##sfx, target, double, pd, -HUGE_VAL, HUGE_VAL)
+
+#define da_kernel_row(sfx) {                                                  \
+	da_kernels(i8##sfx), da_kernels(i16##sfx),                            \
+	da_kernels(i32##sfx), da_kernels(i64##sfx),                           \
+	da_kernels(u8##sfx), da_kernels(u16##sfx),                            \
+	da_kernels(u32##sfx), da_kernels(u64##sfx),                           \
+	da_kernels(f32##sfx), da_kernels(f64##sfx),                           \
+	da_kernels(f80)                                                       \
+}
+
+#define DA_TARGET_DEFAULT __attribute__(()) /* as compiled */
+
+/* `long double` is never vectorised */
+da_define_kernels(f80, DA_TARGET_DEFAULT, long double, long double,
+	long double)
+da_define_minmax(f80, DA_TARGET_DEFAULT, long double,
+	-(long double)HUGE_VAL, (long double)HUGE_VAL)
+
+#define da_define_fminmax(name, target, type, ps, lo, hi)                     \
+	da_define_minmax(name, target, type, lo, hi)
+
+da_define_kernel_row(_base, DA_TARGET_DEFAULT, da_define_fminmax)
+
+#ifdef DA_SIMD_X86
+
+/*
+ * `DA_LANES` elements in one or more vectors. `min(x, mins)` returns `mins`
+ * if `x` is NaN, exactly as `x < mins ? x : mins`.
+ */
+#define da_define_minmax_vec(name, target, type, vec, set1, loadu, vmin,      \
+	vmax, lo, hi)                                                         \
+target static void minmax_##name(                                             \
+	const void* p_, size_t n, void* min, void* max                        \
+) {                                                                           \
+	const type* p = p_;                                                   \
+	vec vmins[DA_LANES * sizeof(type) / sizeof(vec)];                     \
+	vec vmaxs[DA_LANES * sizeof(type) / sizeof(vec)];                     \
+	type mins[DA_LANES];                                                  \
+	type maxs[DA_LANES];                                                  \
+	size_t step = sizeof(vec) / sizeof(type);                             \
+	size_t i, j;                                                          \
+                                                                              \
+	for (j = 0; j < DA_LANES / step; ++j) {                               \
+		vmins[j] = set1(hi);                                          \
+		vmaxs[j] = set1(lo);                                          \
+	}                                                                     \
+	for (i = 0; n - i >= DA_LANES; i += DA_LANES) {                       \
+		for (j = 0; j < DA_LANES / step; ++j) {                       \
+			vec x = loadu(p + i + j * step);                      \
+			vmins[j] = vmin(x, vmins[j]);                         \
+			vmaxs[j] = vmax(x, vmaxs[j]);                         \
+		}                                                             \
+	}                                                                     \
+	memcpy(mins, vmins, sizeof(mins));                                    \
+	memcpy(maxs, vmaxs, sizeof(maxs));                                    \
+	{                                                                     \
+		da_minmax_finish(type, lo, hi)                                \
+	}                                                                     \
+}
+
+typedef __m128 da_m128_ps;
+typedef __m128d da_m128_pd;
+typedef __m256 da_m256_ps;
+typedef __m256d da_m256_pd;
+typedef __m512 da_m512_ps;
+typedef __m512d da_m512_pd;
+
+#define da_define_fminmax_sse2(name, target, type, ps, lo, hi)                \
+	da_define_minmax_vec(name, target, type, da_m128_##ps,                \
+		_mm_set1_##ps, _mm_loadu_##ps, _mm_min_##ps, _mm_max_##ps,    \
+		lo, hi)
+#define da_define_fminmax_avx2(name, target, type, ps, lo, hi)                \
+	da_define_minmax_vec(name, target, type, da_m256_##ps,                \
+		_mm256_set1_##ps, _mm256_loadu_##ps, _mm256_min_##ps,         \
+		_mm256_max_##ps, lo, hi)
+#define da_define_fminmax_avx512(name, target, type, ps, lo, hi)              \
+	da_define_minmax_vec(name, target, type, da_m512_##ps,                \
+		_mm512_set1_##ps, _mm512_loadu_##ps, _mm512_min_##ps,         \
+		_mm512_max_##ps, lo, hi)
+
+da_define_kernel_row(_sse2, DA_SCAN_SSE2, da_define_fminmax_sse2)
+da_define_kernel_row(_avx2, DA_SCAN_AVX2, da_define_fminmax_avx2)
+da_define_kernel_row(_avx512, DA_SCAN_AVX512, da_define_fminmax_avx512)
+
+#endif /* DA_SIMD_X86 */
+
+/* rows by `enum da_simd` */
+static const struct da_kernels da_kernel_table[][11] = {
+	da_kernel_row(_base),
+#ifdef DA_SIMD_X86
+	da_kernel_row(_sse2),
+	da_kernel_row(_avx2),
+	da_kernel_row(_avx512)
+#endif
+};
+
+/* kernels for the element type, `NULL` if not a number */
+static const struct da_kernels* kernels(size_t sz, int kind) {
+	size_t col;
+
+	if (kind == DA_KIND_FLOAT) {
+		if (sz == sizeof(float)) { col = 8; }
+		else if (sz == sizeof(double)) { col = 9; }
+		else if (sz == sizeof(long double)) { col = 10; }
+		else { return NULL; }
+	} else {
+		switch (sz) {
+		case 1: col = 0; break;
+		case 2: col = 1; break;
+		case 4: col = 2; break;
+		case 8: col = 3; break;
+		default: return NULL;
+		}
+		if (kind != DA_KIND_SIGNED) { col += 4; }
+	}
+
+	return &da_kernel_table[da_simd_level()][col];
+}
+
+int64_t da_sum_i_(void* da, size_t sz) {
+	const struct da_kernels* k = kernels(sz, DA_KIND_SIGNED);
+	int64_t sum = 0;
+
+	if (k == NULL) {
+		errno = EINVAL;
+		return 0;
+	}
+	if (da != NULL) {
+		k->sum(da, da_size(da), &sum);
+	}
+
+	return sum;
+}
+
+uint64_t da_sum_u_(void* da, size_t sz) {
+	const struct da_kernels* k = kernels(sz, DA_KIND_BITS);
+	uint64_t sum = 0;
+
+	if (k == NULL) {
+		errno = EINVAL;
+		return 0;
+	}
+	if (da != NULL) {
+		k->sum(da, da_size(da), &sum);
+	}
+
+	return sum;
+}
+
+double da_sum_f_(void* da, size_t sz) {
+	const struct da_kernels* k = kernels(sz, DA_KIND_FLOAT);
+	long double wide = 0;
+	double sum = 0;
+
+	if (k == NULL) {
+		errno = EINVAL;
+		return 0;
+	}
+	if (da == NULL) {
+		return 0;
+	}
+
+	if (sz == sizeof(long double) && sz != sizeof(double)) {
+		k->sum(da, da_size(da), &wide);
+		sum = (double)wide;
+	} else {
+		k->sum(da, da_size(da), &sum);
+	}
+
+	return sum;
+}
+
+void da_minmax_(void* da, void* min, void* max, size_t sz, int kind) {
+	const struct da_kernels* k = kernels(sz, kind);
+	union { int64_t i; uint64_t u; long double f; } lo, hi;
+
+	if (k == NULL) {
+		errno = EINVAL;
+		return;
+	}
+	if (da_size(da) == 0) {
+		return;
+	}
+
+	k->minmax(da, da_size(da), &lo, &hi);
+	if (min != NULL) { memcpy(min, &lo, sz); }
+	if (max != NULL) { memcpy(max, &hi, sz); }
+}
+
+void da_scale_(void** da, const void* factor, size_t sz, int kind) {
+	const struct da_kernels* k = kernels(sz, kind);
+
+	if (k == NULL) {
+		errno = EINVAL;
+		return;
+	}
+	if (*da != NULL && own(da, sz) == 0) {
+		k->scale(*da, da_size(*da), factor);
+	}
+}
+
+void da_add_scalar_(void** da, const void* val, size_t sz, int kind) {
+	const struct da_kernels* k = kernels(sz, kind);
+
+	if (k == NULL) {
+		errno = EINVAL;
+		return;
+	}
+	if (*da != NULL && own(da, sz) == 0) {
+		k->add(*da, da_size(*da), val);
+	}
+}
+
+void da_map_(void** da, da_mapper fn, void* ctx, size_t sz) {
+	char* it;
+	char* end;
+
+	if (*da == NULL) {
+		return;
+	}
+
+	if (own(da, sz) != 0) {
+		return;
+	}
+
+	end = (char*)*da + da_size(*da) * sz;
+	for (it = *da; it != end; it += sz) {
+		fn(it, ctx);
+	}
+}
+
+/*///////////////////////////////////////////////////////////////////////////*/
+/* Parallel algorithms                                                       */
+/*///////////////////////////////////////////////////////////////////////////*/
+
+/*
+ * A job is split into chunks of `DA_PARALLEL_CHUNK` bytes. Each participant
+ * (the calling thread is participant 0) starts with an equal slice of the
+ * chunks, takes chunks from the front of its own slice, and when that is
+ * empty steals from the back of the others'. A slice is packed into one
+ * word, `next << 32 | end`, so both ends move with a compare-and-swap.
+ */
+#define DA_SLICE_MAX 0xffffffffUL
+
+enum da_job_kind { DA_JOB_FOR, DA_JOB_REDUCE, DA_JOB_COPY };
+
+struct da_job {
+	enum da_job_kind kind;
+	char* data;
+	const char* src; /* DA_JOB_COPY */
+	size_t sz;
+	size_t cnt;
+	size_t per_chunk; /* elements */
+	size_t chunks;
+	da_range_fn range;
+	da_reduce_fn reduce;
+	const void* identity; /* DA_JOB_REDUCE */
+	char* partials; /* DA_JOB_REDUCE, one per chunk */
+	size_t rsz;
+	void* ctx;
+	uint64_t* slices; /* one per participant */
+	size_t participants;
+};
+
+static struct {
+	pthread_mutex_t lock;
+	pthread_cond_t wake;
+	pthread_cond_t idle;
+	pthread_t* threads;
+	size_t count; /* worker threads, not counting the caller */
+	size_t wanted; /* threads, including the caller; 0 for one per CPU */
+	int started;
+	int stop;
+	struct da_job* job;
+	unsigned long round; /* incremented for every job */
+	unsigned long first_round; /* `round` when the workers started */
+	size_t active; /* workers still in the current job */
+} da_pool = {
+	PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER,
+	PTHREAD_COND_INITIALIZER, NULL, 0, 0, 0, 0, NULL, 0, 0, 0
+};
+
+/* jobs run one at a time */
+static pthread_mutex_t da_pool_submit = PTHREAD_MUTEX_INITIALIZER;
+
+/* set inside a job: nested calls run serially instead of waiting for it */
+static __thread int da_in_job;
+
+static size_t da_parallel_min = DA_PARALLEL_THRESHOLD;
+
+static void job_chunk(struct da_job* job, size_t chunk) {
+	size_t first = chunk * job->per_chunk;
+	size_t cnt = job->cnt - first < job->per_chunk
+		? job->cnt - first : job->per_chunk;
+	char* p = job->data + first * job->sz;
+
+	switch (job->kind) {
+	case DA_JOB_FOR:
+		job->range(p, cnt, job->ctx);
+		break;
+	case DA_JOB_REDUCE:
+		p = job->partials + chunk * job->rsz;
+		memcpy(p, job->identity, job->rsz);
+		job->reduce(job->data + first * job->sz, cnt, p, job->ctx);
+		break;
+	case DA_JOB_COPY:
+		memcpy(p, job->src + first * job->sz, cnt * job->sz);
+		break;
+	}
+}
+
+/* takes the front chunk of `slice` (`back` == 0) or the back one */
+static int slice_take(uint64_t* slice, int back, size_t* chunk) {
+	uint64_t v = __atomic_load_n(slice, __ATOMIC_RELAXED);
+	uint64_t next, end;
+
+	do {
+		next = v >> 32;
+		end = v & DA_SLICE_MAX;
+		if (next >= end) {
+			return 0;
+		}
+		*chunk = back ? end - 1 : next;
+	} while (!__atomic_compare_exchange_n(
+		slice, &v, back ? next << 32 | (end - 1) : (next + 1) << 32 | end,
+		1, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED
+	));
+
+	return 1;
+}
+
+static void job_work(struct da_job* job, size_t self) {
+	size_t chunk;
+	size_t k;
+
+	while (slice_take(&job->slices[self], 0, &chunk)) {
+		job_chunk(job, chunk);
+	}
+	for (k = 1; k < job->participants; ++k) {
+		uint64_t* victim = &job->slices[(self + k) % job->participants];
+		while (slice_take(victim, 1, &chunk)) {
+			job_chunk(job, chunk);
+		}
+	}
+}
+
+static void* pool_worker(void* arg) {
+	size_t self = (size_t)arg;
+	unsigned long seen;
+	struct da_job* job;
+
+	da_in_job = 1;
+	pthread_mutex_lock(&da_pool.lock);
+	seen = da_pool.first_round;
+	for (;;) {
+		while (!da_pool.stop && da_pool.round == seen) {
+			pthread_cond_wait(&da_pool.wake, &da_pool.lock);
+		}
+		if (da_pool.stop) {
+			break;
+		}
+		seen = da_pool.round;
+		job = da_pool.job;
+		pthread_mutex_unlock(&da_pool.lock);
+
+		job_work(job, self);
+
+		pthread_mutex_lock(&da_pool.lock);
+		if (--da_pool.active == 0) {
+			pthread_cond_signal(&da_pool.idle);
+		}
+	}
+	pthread_mutex_unlock(&da_pool.lock);
+
+	return NULL;
+}
+
+/* with `da_pool_submit` held */
+static void pool_start(void) {
+	size_t wanted = da_pool.wanted;
+	long cpus;
+	size_t i;
+
+	da_pool.started = 1;
+	da_pool.first_round = da_pool.round;
+	if (wanted == 0) {
+		cpus = sysconf(_SC_NPROCESSORS_ONLN);
+		wanted = cpus > 0 ? (size_t)cpus : 1;
+	}
+	if (wanted <= 1) {
+		return;
+	}
+
+	da_pool.threads = malloc((wanted - 1) * sizeof(*da_pool.threads));
+	if (da_pool.threads == NULL) {
+		return;
+	}
+	for (i = 0; i < wanted - 1; ++i) {
+		if (pthread_create(&da_pool.threads[i], NULL, pool_worker,
+				(void*)(i + 1)) != 0) {
+			break;
+		}
+	}
+	/* with fewer workers if creating one failed */
+	__atomic_store_n(&da_pool.count, i, __ATOMIC_RELAXED);
+}
+
+/* with `da_pool_submit` held */
+static void pool_stop(void) {
+	size_t i;
+
+	pthread_mutex_lock(&da_pool.lock);
+	da_pool.stop = 1;
+	pthread_cond_broadcast(&da_pool.wake);
+	pthread_mutex_unlock(&da_pool.lock);
+
+	for (i = 0; i < da_pool.count; ++i) {
+		pthread_join(da_pool.threads[i], NULL);
+	}
+	free(da_pool.threads);
+	da_pool.threads = NULL;
+	__atomic_store_n(&da_pool.count, 0, __ATOMIC_RELAXED);
+	da_pool.stop = 0;
+	da_pool.started = 0;
+}
+
+/* runs every chunk of `job`, on the pool if it is large enough */
+static void job_run(struct da_job* job) {
+	size_t i;
+
+	job->chunks = (job->cnt + job->per_chunk - 1) / job->per_chunk;
+
+	if (job->cnt * job->sz < da_parallel_min || da_in_job
+			|| job->chunks > DA_SLICE_MAX) {
+		for (i = 0; i < job->chunks; ++i) {
+			job_chunk(job, i);
+		}
+		return;
+	}
+
+	pthread_mutex_lock(&da_pool_submit);
+	if (!da_pool.started) {
+		pool_start();
+	}
+
+	job->participants = da_pool.count + 1;
+	job->slices = job->participants > 1
+		? malloc(job->participants * sizeof(*job->slices)) : NULL;
+	if (job->slices == NULL) {
+		pthread_mutex_unlock(&da_pool_submit);
+		for (i = 0; i < job->chunks; ++i) {
+			job_chunk(job, i);
+		}
+		return;
+	}
+	for (i = 0; i < job->participants; ++i) {
+		uint64_t next = job->chunks * i / job->participants;
+		uint64_t end = job->chunks * (i + 1) / job->participants;
+		job->slices[i] = next << 32 | end;
+	}
+
+	pthread_mutex_lock(&da_pool.lock);
+	da_pool.job = job;
+	da_pool.active = da_pool.count;
+	++da_pool.round;
+	pthread_cond_broadcast(&da_pool.wake);
+	pthread_mutex_unlock(&da_pool.lock);
+
+	da_in_job = 1;
+	job_work(job, 0);
+	da_in_job = 0;
+
+	pthread_mutex_lock(&da_pool.lock);
+	while (da_pool.active > 0) {
+		pthread_cond_wait(&da_pool.idle, &da_pool.lock);
+	}
+	da_pool.job = NULL;
+	pthread_mutex_unlock(&da_pool.lock);
+
+	free(job->slices);
+	pthread_mutex_unlock(&da_pool_submit);
+}
+
+static void job_init(
+	struct da_job* job, enum da_job_kind kind, void* da, size_t sz
+) {
+	memset(job, 0, sizeof(*job));
+	job->kind = kind;
+	job->data = da;
+	job->sz = sz;
+	job->cnt = da_size(da);
+	job->per_chunk = DA_PARALLEL_CHUNK / sz > 0 ? DA_PARALLEL_CHUNK / sz : 1;
+}
+
+void da_parallel_set_threads(size_t threads) {
+	pthread_mutex_lock(&da_pool_submit);
+	if (da_pool.started) {
+		pool_stop();
+	}
+	da_pool.wanted = threads;
+	pthread_mutex_unlock(&da_pool_submit);
+}
+
+size_t da_parallel_threads(void) {
+	size_t threads;
+
+	pthread_mutex_lock(&da_pool_submit);
+	if (!da_pool.started) {
+		pool_start();
+	}
+	threads = da_pool.count + 1;
+	pthread_mutex_unlock(&da_pool_submit);
+
+	return threads;
+}
+
+void da_parallel_set_threshold(size_t bytes) {
+	da_parallel_min = bytes;
+}
+
+void da_parallel_for_(void* da, da_range_fn fn, void* ctx, size_t sz) {
+	struct da_job job;
+
+	if (da_size(da) == 0) {
+		return;
+	}
+
+	job_init(&job, DA_JOB_FOR, da, sz);
+	job.range = fn;
+	job.ctx = ctx;
+	job_run(&job);
+}
+
+void da_parallel_reduce_(
+	void* da, void* acc, size_t rsz, da_reduce_fn fn, da_combine_fn combine,
+	void* ctx, size_t sz
+) {
+	struct da_job job;
+	size_t i;
+
+	if (da_size(da) == 0) {
+		return;
+	}
+
+	job_init(&job, DA_JOB_REDUCE, da, sz);
+	job.reduce = fn;
+	job.ctx = ctx;
+	job.identity = acc;
+	job.rsz = rsz;
+	job.chunks = (job.cnt + job.per_chunk - 1) / job.per_chunk;
+	job.partials = malloc(job.chunks * rsz);
+	if (job.partials == NULL) {
+		errno = ENOMEM;
+		return;
+	}
+
+	job_run(&job);
+	/* in chunk order, whichever thread computed them */
+	for (i = 0; i < job.chunks; ++i) {
+		combine(acc, job.partials + i * rsz, ctx);
+	}
+	free(job.partials);
+}
+
+/* `memcpy()` on the pool, if it is running and `bytes` is large enough */
+static void parallel_copy(void* dst, const void* src, size_t cnt, size_t sz) {
+	struct da_job job;
+
+	if (cnt == 0) {
+		return;
+	}
+	if (__atomic_load_n(&da_pool.count, __ATOMIC_RELAXED) == 0
+			|| cnt * sz < da_parallel_min) {
+		memcpy(dst, src, cnt * sz);
+		return;
+	}
+
+	memset(&job, 0, sizeof(job));
+	job.kind = DA_JOB_COPY;
+	job.data = dst;
+	job.src = src;
+	job.sz = sz;
+	job.cnt = cnt;
+	job.per_chunk = DA_PARALLEL_CHUNK / sz > 0 ? DA_PARALLEL_CHUNK / sz : 1;
+	job_run(&job);
+}
+
+/*///////////////////////////////////////////////////////////////////////////*/
+/* Sorting and binary search                                                 */
+/*///////////////////////////////////////////////////////////////////////////*/
+
+/*
+ * Numbers are sorted by an unsigned key with the same order: Signed integers
+ * have their sign bit flipped, floating point numbers have every bit flipped
+ * if negative and only the sign bit otherwise.
+ *
+ *   key = x ^ ((-(x >> (bits - 1)) & all) | sign)
+ *
+ * with `all` = ~0 for floating point numbers (else 0) and `sign` = the sign
+ * bit for signed types (else 0).
+ */
+#define da_key(x, all, sign, bits)                                            \
+	((x) ^ (((0 - ((x) >> ((bits) - 1))) & (all)) | (sign)))
+
+/* below this, insertion sort */
+#define DA_RADIX_MIN 64
+
+/*
+ * LSD radix sort, one byte per pass, with every histogram counted in a
+ * first pass. Passes where every key has the same byte are skipped.
+ */
+#define da_define_radix(name, type)                                           \
+static int radix_##name(type* a, size_t n, type all, type sign) {             \
+	size_t hist[sizeof(type)][256];                                       \
+	size_t bits = sizeof(type) * 8;                                       \
+	type* tmp;                                                            \
+	type* src = a;                                                        \
+	type* dst;                                                            \
+	type k, x;                                                            \
+	size_t i, d, sum, cnt;                                                \
+                                                                              \
+	if (n < DA_RADIX_MIN) {                                               \
+		for (i = 1; i < n; ++i) {                                     \
+			x = a[i];                                             \
+			k = da_key(x, all, sign, bits);                       \
+			for (d = i; d > 0; --d) {                             \
+				if (da_key(a[d - 1], all, sign, bits) <= k) { \
+					break;                                \
+				}                                             \
+				a[d] = a[d - 1];                              \
+			}                                                     \
+			a[d] = x;                                             \
+		}                                                             \
+		return 0;                                                     \
+	}                                                                     \
+                                                                              \
+	tmp = malloc(n * sizeof(type));                                       \
+	if (tmp == NULL) {                                                    \
+		return -1;                                                    \
+	}                                                                     \
+	dst = tmp;                                                            \
+                                                                              \
+	memset(hist, 0, sizeof(hist));                                        \
+	for (i = 0; i < n; ++i) {                                             \
+		k = da_key(a[i], all, sign, bits);                            \
+		for (d = 0; d < sizeof(type); ++d) {                          \
+			++hist[d][(k >> (d * 8)) & 0xff];                     \
+		}                                                             \
+	}                                                                     \
+                                                                              \
+	for (d = 0; d < sizeof(type); ++d) {                                  \
+		k = da_key(a[0], all, sign, bits);                            \
+		if (hist[d][(k >> (d * 8)) & 0xff] == n) {                    \
+			continue;                                             \
+		}                                                             \
+		for (i = 0, sum = 0; i < 256; ++i) {                          \
+			cnt = hist[d][i];                                     \
+			hist[d][i] = sum;                                     \
+			sum += cnt;                                           \
+		}                                                             \
+		for (i = 0; i < n; ++i) {                                     \
+			k = da_key(src[i], all, sign, bits);                  \
+			dst[hist[d][(k >> (d * 8)) & 0xff]++] = src[i];       \
+		}                                                             \
+		tmp = src;                                                    \
+		src = dst;                                                    \
+		dst = tmp;                                                    \
+	}                                                                     \
+                                                                              \
+	if (src != a) {                                                       \
+		memcpy(a, src, n * sizeof(type));                             \
+		free(src);                                                    \
+	} else {                                                              \
+		free(dst);                                                    \
+	}                                                                     \
+	return 0;                                                             \
+}                                                                             \
+                                                                              \
+/* index of the first element with a key > (`upper`) or >= than `val`'s */    \
+static size_t bound_##name(                                                   \
+	const type* a, size_t n, type val, type all, type sign, int upper     \
+) {                                                                           \
+	size_t bits = sizeof(type) * 8;                                       \
+	type k = da_key(val, all, sign, bits);                                \
+	size_t lo = 0;                                                        \
+	size_t mid;                                                           \
+                                                                              \
+	while (n > 0) {                                                       \
+		type m;                                                       \
+		mid = lo + n / 2;                                             \
+		m = da_key(a[mid], all, sign, bits);                          \
+		if (upper ? m <= k : m < k) {                                 \
+			lo = mid + 1;                                         \
+			n -= n / 2 + 1;                                       \
+		} else {                                                      \
+			n /= 2;                                               \
+		}                                                             \
+	}                                                                     \
+	return lo;                                                            \
+}
+
+da_define_radix(u8, uint8_t)
+da_define_radix(u16, uint16_t)
+da_define_radix(u32, uint32_t)
+da_define_radix(u64, uint64_t)
+
+/* the masks of `da_key()` */
+#define da_key_masks(type, kind, all, sign)                                   \
+do {                                                                          \
+	all = (kind) == DA_KIND_FLOAT ? (type)-1 : 0;                         \
+	sign = (kind) != DA_KIND_BITS                                         \
+		? (type)((type)1 << (sizeof(type) * 8 - 1)) : 0;              \
+} while (0)
+
+void da_sort_(void** da, size_t sz, int kind) {
+	int err = 0;
+
+	if (*da == NULL) {
+		return;
+	}
+
+	if (sz != 1 && sz != 2 && sz != 4 && sz != 8) {
+		errno = EINVAL;
+		return;
+	}
+
+	if (own(da, sz) != 0) {
+		return;
+	}
+
+	switch (sz) {
+	case 1: {
+		uint8_t all, sign;
+		da_key_masks(uint8_t, kind, all, sign);
+		err = radix_u8(*da, da_size(*da), all, sign);
+		break;
+	}
+	case 2: {
+		uint16_t all, sign;
+		da_key_masks(uint16_t, kind, all, sign);
+		err = radix_u16(*da, da_size(*da), all, sign);
+		break;
+	}
+	case 4: {
+		uint32_t all, sign;
+		da_key_masks(uint32_t, kind, all, sign);
+		err = radix_u32(*da, da_size(*da), all, sign);
+		break;
+	}
+	case 8: {
+		uint64_t all, sign;
+		da_key_masks(uint64_t, kind, all, sign);
+		err = radix_u64(*da, da_size(*da), all, sign);
+		break;
+	}
+	default:
+		return;
+	}
+
+	if (err != 0) {
+		errno = ENOMEM;
+	}
+}
+
+size_t da_bound_(void* da, const void* val, size_t sz, int kind, int upper) {
+	if (da == NULL) {
+		return 0;
+	}
+
+	switch (sz) {
+	case 1: {
+		uint8_t all, sign, v;
+		da_key_masks(uint8_t, kind, all, sign);
+		memcpy(&v, val, sz);
+		return bound_u8(da, da_size(da), v, all, sign, upper);
+	}
+	case 2: {
+		uint16_t all, sign, v;
+		da_key_masks(uint16_t, kind, all, sign);
+		memcpy(&v, val, sz);
+		return bound_u16(da, da_size(da), v, all, sign, upper);
+	}
+	case 4: {
+		uint32_t all, sign, v;
+		da_key_masks(uint32_t, kind, all, sign);
+		memcpy(&v, val, sz);
+		return bound_u32(da, da_size(da), v, all, sign, upper);
+	}
+	case 8: {
+		uint64_t all, sign, v;
+		da_key_masks(uint64_t, kind, all, sign);
+		memcpy(&v, val, sz);
+		return bound_u64(da, da_size(da), v, all, sign, upper);
+	}
+	default:
+		errno = EINVAL;
+		return 0;
+	}
+}
+
+void da_insert_sorted_(void** da, void* val, size_t sz, int kind) {
+	size_t idx = da_bound_(*da, val, sz, kind, 1);
+
+	if (sz != 1 && sz != 2 && sz != 4 && sz != 8) {
+		errno = EINVAL;
+		return;
+	}
+
+	/* `da_insert()` cannot insert at the end of a full array */
+	if (*da != NULL && da_size(*da) == da_capacity(*da)) {
+		grow(da, da_size(*da) + 1, sz);
+	}
+	da_insert_(da, idx, val, sz);
+}
+
+/*///////////////////////////////////////////////////////////////////////////*/
+/* Streaming I/O                                                             */
+/*///////////////////////////////////////////////////////////////////////////*/
+
+/* `-1` on failure */
+static int write_all(int fd, const void* buf, size_t bytes) {
+	const char* p = buf;
+	ssize_t n;
+
+	while (bytes > 0) {
+		n = write(fd, p, bytes);
+		if (n < 0 && errno == EINTR) {
+			continue;
+		}
+		if (n <= 0) {
+			return -1;
+		}
+		p += n;
+		bytes -= (size_t)n;
+	}
+
+	return 0;
+}
+
+/* `-1` on failure, EINVAL at the end of the file */
+static int read_all(int fd, void* buf, size_t bytes) {
+	char* p = buf;
+	ssize_t n;
+
+	while (bytes > 0) {
+		n = read(fd, p, bytes);
+		if (n < 0 && errno == EINTR) {
+			continue;
+		}
+		if (n == 0) {
+			errno = EINVAL;
+		}
+		if (n <= 0) {
+			return -1;
+		}
+		p += n;
+		bytes -= (size_t)n;
+	}
+
+	return 0;
+}
+
+void* da_spare_begin_(void** da, size_t cnt, size_t sz) {
+	if (*da == NULL) { *da = da_init(sz); }
+
+	if (*da == NULL) { return NULL; }
+
+	reserve_more(da, cnt, sz);
+	if (da_capacity(*da) - da_size(*da) < cnt) {
+		return NULL;
+	}
+
+	da_deque_linearize_(*da, sz);
+	return (char*)*da + sz * da_size(*da);
+}
+
+void da_commit_(void* da, size_t cnt) {
+	if (cnt == 0) {
+		return;
+	}
+
+	if (da == NULL || cnt > da_capacity(da) - da_size(da)) {
+		errno = EINVAL;
+		return;
+	}
+
+	da_var_size(da) += cnt;
+}
+
+ptrdiff_t da_read_fd_(void** da, int fd, size_t max, size_t sz) {
+	size_t before;
+	size_t got = 0; /* bytes of an incomplete element, past the size */
+	size_t left;
+	ssize_t n;
+
+	if (*da == NULL) { *da = da_init(sz); }
+
+	if (*da == NULL) { return -1; }
+
+	before = da_size(*da);
+	if (max != DA_READ_ALL && da_spare_begin_(da, max, sz) == NULL) {
+		return -1;
+	}
+	da_deque_linearize_(*da, sz);
+
+	for (;;) {
+		/* bytes that fit, or are still wanted */
+		left = (da_capacity(*da) - da_size(*da)) * sz - got;
+		if (max != DA_READ_ALL) {
+			left = (max - (da_size(*da) - before)) * sz - got;
+		}
+
+		/* only when reading everything, and never with `got` != 0 */
+		if (left == 0 && max == DA_READ_ALL) {
+			reserve_more(da, DA_READ_CHUNK / sz + 1, sz);
+			if (da_size(*da) == da_capacity(*da)) {
+				return -1;
+			}
+			continue;
+		}
+		if (left == 0) {
+			break;
+		}
+
+		n = read(fd, (char*)*da + sz * da_size(*da) + got, left);
+		if (n < 0 && errno == EINTR) {
+			continue;
+		}
+		if (n < 0) {
+			return -1;
+		}
+		if (n == 0) {
+			break;
+		}
+
+		got += (size_t)n;
+		da_var_size(*da) += got / sz;
+		got %= sz;
+	}
+
+	if (got != 0) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	return (ptrdiff_t)(da_size(*da) - before);
+}
+
+int da_write_fd_(void* da, int fd, size_t sz) {
+	size_t size = da_size(da);
+	size_t first = 0;
+	size_t run = size; /* elements before a deque wraps around */
+
+	if (da != NULL) {
+		first = da_var_first(da);
+	}
+	if (first + size > da_capacity(da)) {
+		run = da_capacity(da) - first;
+	}
+
+	if (write_all(fd, (char*)da + sz * first, sz * run) != 0) {
+		return -1;
+	}
+	return write_all(fd, da, sz * (size - run));
+}
+
+/*///////////////////////////////////////////////////////////////////////////*/
+/* Persistence                                                               */
+/*///////////////////////////////////////////////////////////////////////////*/
+
+/* start of a saved array, the elements follow at `offset` (a page) */
+struct da_file_header {
+	char magic[8];
+	uint32_t version;
+	uint32_t order; /* `DA_FILE_ORDER` as written, to detect byte order */
+	uint64_t sz;
+	uint64_t align;
+	uint64_t count;
+	uint64_t offset;
+};
+
+/* non-ASCII and a newline, so text mode transfers are caught */
+static const char da_file_magic[8] = "\211DARRAY\n";
+
+#define DA_FILE_ORDER 0x01020304
+
+int da_save_(void* da, const char* path, size_t sz) {
+	struct da_file_header h;
+	size_t page = page_size();
+	char* head;
+	int fd;
+	int err;
+
+	memset(&h, 0, sizeof(h));
+	memcpy(h.magic, da_file_magic, sizeof(h.magic));
+	h.version = DA_FILE_VERSION;
+	h.order = DA_FILE_ORDER;
+	h.sz = sz;
+	h.align = da != NULL ? da_header(da)->align : 0;
+	h.count = da_size(da);
+	h.offset = page;
+
+	/* the header, padded to a page so that the elements can be mapped */
+	head = calloc(1, page);
+	if (head == NULL) {
+		errno = ENOMEM;
+		return -1;
+	}
+	memcpy(head, &h, sizeof(h));
+
+	fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+	if (fd < 0) {
+		free(head);
+		return -1;
+	}
+
+	err = write_all(fd, head, page);
+	if (err == 0) {
+		err = da_write_fd_(da, fd, sz);
+	}
+
+	free(head);
+	if (close(fd) != 0) {
+		err = -1;
+	}
+	return err;
+}
+
+/* non-zero if `h` describes elements of `sz` bytes, in a file of `bytes` */
+static int file_header_ok(
+	const struct da_file_header* h, size_t sz, uint64_t bytes
+) {
+	return memcmp(h->magic, da_file_magic, sizeof(h->magic)) == 0
+		&& h->version == DA_FILE_VERSION
+		&& h->order == DA_FILE_ORDER
+		&& h->sz == sz
+		&& (h->align & (h->align - 1)) == 0
+		&& h->align <= DA_ALIGN_MAX
+		&& h->offset >= sizeof(*h)
+		&& h->offset <= bytes
+		&& h->count <= DA_SIZE_MAX / 2 / sz
+		&& h->count * sz <= bytes - h->offset;
+}
+
+/* copies the elements into a new array */
+static void* read_file(int fd, const struct da_file_header* h, size_t sz) {
+	void* da = init(sz, (size_t)h->align, NULL);
+	size_t cnt = (size_t)h->count;
+
+	if (da == NULL) {
+		return NULL;
+	}
+
+	da_reserve_(&da, cnt, sz);
+	if (da_capacity(da) < cnt
+			|| lseek(fd, (off_t)h->offset, SEEK_SET) < 0
+			|| read_all(fd, da, sz * cnt) != 0) {
+		da_free_(da, sz);
+		return NULL;
+	}
+
+	da_var_size(da) = cnt;
+	return da;
+}
+
+#ifdef __linux__
+
+/* maps the elements behind a header on anonymous pages */
+static void* map_file(int fd, const struct da_file_header* h, size_t sz) {
+	size_t page = page_size();
+	size_t room = head_room(sz, (size_t)h->align);
+	size_t front = (room + page - 1) / page * page;
+	size_t cnt = (size_t)h->count;
+	char* base;
+	void* da;
+
+	base = mmap(
+		NULL, front + sz * cnt, PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS, -1, 0
+	);
+	if (base == MAP_FAILED) {
+		return NULL;
+	}
+
+	/* the file's pages replace the anonymous ones behind the header */
+	if (cnt != 0 && mmap(
+		base + front, sz * cnt, PROT_READ, MAP_PRIVATE | MAP_FIXED,
+		fd, (off_t)h->offset
+	) == MAP_FAILED) {
+		munmap(base, front + sz * cnt);
+		return NULL;
+	}
+
+	/* always full, so that appending copies the array first */
+	da = base + front;
+	da_header(da)->allocator = &da_mapped_allocator;
+	da_header(da)->growth = NULL;
+	da_header(da)->shared = NULL;
+	da_header(da)->align = (size_t)h->align;
+	da_header(da)->offset = room;
+#ifdef DA_STATS
+	da_header(da)->stats = NULL;
+#endif
+	da_var_first(da) = 0;
+	da_var_size(da) = cnt;
+	da_var_capacity(da) = cnt;
+
+	return da;
+}
+
+#else /* __linux__ */
+
+#define map_file read_file
+
+#endif /* __linux__ */
+
+void* da_mmap(const char* path, size_t sz) {
+	struct da_file_header h;
+	struct stat st;
+	void* da = NULL;
+	int fd;
+
+	if (sz == 0) {
+		errno = EINVAL;
+		return NULL;
+	}
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		return NULL;
+	}
+
+	if (read_all(fd, &h, sizeof(h)) == 0 && fstat(fd, &st) == 0) {
+		if (!file_header_ok(&h, sz, (uint64_t)st.st_size)) {
+			errno = EINVAL;
+		} else if (h.offset % page_size() == 0) {
+			da = map_file(fd, &h, sz);
+		} else {
+			/* saved with smaller pages */
+			da = read_file(fd, &h, sz);
+		}
+	}
+
+	close(fd);
+	return da;
+}
+
+/*///////////////////////////////////////////////////////////////////////////*/
+/* Copy-on-write sharing                                                     */
+/*///////////////////////////////////////////////////////////////////////////*/
+
+void* da_share_(void* da, size_t sz) {
+	struct da_shared* s;
+
+	if (da == NULL) {
+		return NULL;
+	}
+
+	s = da_header(da)->shared;
+	if (s == NULL) {
+		s = malloc(sizeof(*s));
+		if (s == NULL) {
+			errno = ENOMEM;
+			return NULL;
+		}
+
+		/* holders only ever see the elements in order */
+		da_deque_linearize_(da, sz);
+		s->refs = 1;
+		s->capacity = da_capacity(da);
+		da_var_capacity(da) = da_size(da);
+		da_header(da)->shared = s;
+	}
+
+	__atomic_add_fetch(&s->refs, 1, __ATOMIC_RELAXED);
+	return da;
+}
+
+void da_unshare_(void** da, size_t sz) {
+	own(da, sz);
+}
+
+/*///////////////////////////////////////////////////////////////////////////*/
+/* Struct of arrays                                                          */
+/*///////////////////////////////////////////////////////////////////////////*/
+
+#define da_soa_round(n)                                                       \
+	(((n) + DA_SOA_ALIGN - 1) / DA_SOA_ALIGN * DA_SOA_ALIGN)
+
+/* bytes of the columns, for `cap` rows */
+static size_t soa_bytes(const size_t* sizes, size_t ncols, size_t cap) {
+	size_t bytes = 0;
+	size_t i;
+
+	for (i = 0; i < ncols; ++i) {
+		bytes += da_soa_round(cap * sizes[i]);
+	}
+	return bytes;
+}
+
+int da_soa_reserve_(
+	void** block, void** cols, const size_t* sizes, size_t ncols,
+	size_t size, size_t* capacity, size_t cnt, int exact
+) {
+	size_t cap = cnt;
+	size_t bytes = DA_SOA_ALIGN - 1; /* to align the first column */
+	size_t skew = 0; /* of the first column in the old block */
+	size_t lead;
+	size_t old_at;
+	size_t new_at;
+	size_t i;
+	char* tmp;
+
+	if (cnt <= *capacity) {
+		return 0;
+	}
+
+	if (!exact) {
+		size_t next = grow_capacity(da_default_growth, *capacity);
+		if (next > cap) { cap = next; }
+	}
+
+	/* every column starts on its own cache line */
+	for (i = 0; i < ncols; ++i) {
+		if (cap > (DA_SIZE_MAX - bytes - DA_SOA_ALIGN) / sizes[i]) {
+			errno = ENOMEM;
+			return -1;
+		}
+		bytes += da_soa_round(cap * sizes[i]);
+	}
+
+	if (*block != NULL) {
+		skew = (size_t)((char*)cols[0] - (char*)*block);
+	}
+
+	/* one `realloc` for every column, which large blocks make a remap */
+	tmp = realloc(*block, bytes);
+	if (tmp == NULL) {
+		errno = ENOMEM;
+		return -1;
+	}
+
+	lead = (DA_SOA_ALIGN - (size_t)tmp % DA_SOA_ALIGN) % DA_SOA_ALIGN;
+	if (*block != NULL && lead != skew) {
+		memmove(tmp + lead, tmp + skew,
+			soa_bytes(sizes, ncols, *capacity));
+	}
+
+	/* each column moves up, so they are moved from the last one */
+	old_at = soa_bytes(sizes, ncols, *capacity);
+	new_at = bytes - (DA_SOA_ALIGN - 1);
+	for (i = ncols; i-- > 0; ) {
+		old_at -= da_soa_round(*capacity * sizes[i]);
+		new_at -= da_soa_round(cap * sizes[i]);
+		if (size != 0) {
+			memmove(tmp + lead + new_at, tmp + lead + old_at,
+				size * sizes[i]);
+		}
+		cols[i] = tmp + lead + new_at;
+	}
+
+	*block = tmp;
+	*capacity = cap;
+	return 0;
+}
+
+void da_soa_free_(void* block) {
+	free(block);
+}
+
+/*///////////////////////////////////////////////////////////////////////////*/
+/* Bit arrays                                                                */
+/*///////////////////////////////////////////////////////////////////////////*/
+
+/* bits `0` to `n % 64` of a word, for a partial last word */
+#define da_bits_low(n) (~(uint64_t)0 >> (64 - (n) % 64))
+
+struct da_bits_kernels {
+	size_t (*popcount)(const uint64_t* p, size_t n);
+	size_t (*find)(const uint64_t* p, size_t n); /* first non-zero word */
+	void (*op[3])(uint64_t* dst, const uint64_t* src, size_t n);
+};
+
+enum { DA_BITS_AND, DA_BITS_OR, DA_BITS_XOR };
+
+/* 4 counts, which the scalar `popcnt` instruction updates in parallel */
+#define da_define_popcount(sfx, target)                                       \
+target static size_t popcount##sfx(const uint64_t* p, size_t n) {             \
+	size_t c0 = 0, c1 = 0, c2 = 0, c3 = 0;                                \
+	size_t i;                                                             \
+                                                                              \
+	for (i = 0; n - i >= 4; i += 4) {                                     \
+		c0 += __builtin_popcountll(p[i]);                             \
+		c1 += __builtin_popcountll(p[i + 1]);                         \
+		c2 += __builtin_popcountll(p[i + 2]);                         \
+		c3 += __builtin_popcountll(p[i + 3]);                         \
+	}                                                                     \
+	for (; i < n; ++i) { c0 += __builtin_popcountll(p[i]); }              \
+	return c0 + c1 + c2 + c3;                                             \
+}
+
+/*
+ * `find` ORs `DA_LANES` words together before testing them, so a run of `0`
+ * words costs a few vector instructions.
+ */
+#define da_define_bits_kernels(sfx, target)                                   \
+target static size_t find##sfx(const uint64_t* p, size_t n) {                 \
+	size_t i, j;                                                          \
+                                                                              \
+	for (i = 0; n - i >= DA_LANES; i += DA_LANES) {                       \
+		uint64_t any = 0;                                             \
+		for (j = 0; j < DA_LANES; ++j) { any |= p[i + j]; }           \
+		if (any != 0) { break; }                                      \
+	}                                                                     \
+	for (; i < n && p[i] == 0; ++i) {}                                    \
+	return i;                                                             \
+}                                                                             \
+                                                                              \
+target static void and##sfx(uint64_t* dst, const uint64_t* src, size_t n) {   \
+	size_t i;                                                             \
+	for (i = 0; i < n; ++i) { dst[i] &= src[i]; }                         \
+}                                                                             \
+                                                                              \
+target static void or##sfx(uint64_t* dst, const uint64_t* src, size_t n) {    \
+	size_t i;                                                             \
+	for (i = 0; i < n; ++i) { dst[i] |= src[i]; }                         \
+}                                                                             \
+                                                                              \
+target static void xor##sfx(uint64_t* dst, const uint64_t* src, size_t n) {   \
+	size_t i;                                                             \
+	for (i = 0; i < n; ++i) { dst[i] ^= src[i]; }                         \
+}
+
+#define da_bits_row(sfx)                                                      \
+	{ popcount##sfx, find##sfx, { and##sfx, or##sfx, xor##sfx } }
+
+da_define_popcount(_base, DA_TARGET_DEFAULT)
+da_define_bits_kernels(_base, DA_TARGET_DEFAULT)
+
+#ifdef DA_SIMD_X86
+
+da_define_popcount(_sse2, DA_SCAN_SSE2)
+da_define_bits_kernels(_sse2, DA_SCAN_SSE2)
+da_define_bits_kernels(_avx2, DA_SCAN_AVX2)
+da_define_bits_kernels(_avx512, DA_SCAN_AVX512)
+
+/* bits set in each nibble, for `pshufb`; repeated for every 16 byte lane */
+static const uint8_t da_nibble_pop[64] = {
+	0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+	0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+	0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+	0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4
+};
+
+/*
+ * Counts the bits of each byte by looking both its nibbles up in
+ * `da_nibble_pop` (a byte shuffle), then sums the bytes of each 64 bit lane
+ * with `psadbw`. Faster than one `popcnt` per word once vectors are 256 bits
+ * or wider (W. Mula's method).
+ */
+#define da_define_popcount_vec(name, target, vec, pfx, sfx)                   \
+target static size_t popcount##name(const uint64_t* p, size_t n) {            \
+	const vec table = pfx##_loadu_##sfx((const vec*)da_nibble_pop);       \
+	const vec low = pfx##_set1_epi8(0x0f);                                \
+	const vec zero = pfx##_setzero_##sfx();                               \
+	vec acc = zero;                                                       \
+	size_t step = sizeof(vec) / sizeof(uint64_t);                         \
+	uint64_t lanes[sizeof(vec) / sizeof(uint64_t)];                       \
+	size_t total = 0;                                                     \
+	size_t i;                                                             \
+                                                                              \
+	for (i = 0; n - i >= step; i += step) {                               \
+		vec x = pfx##_loadu_##sfx((const vec*)(p + i));               \
+		vec lo = pfx##_shuffle_epi8(table, pfx##_and_##sfx(x, low));  \
+		vec hi = pfx##_shuffle_epi8(table,                            \
+			pfx##_and_##sfx(pfx##_srli_epi16(x, 4), low));        \
+		acc = pfx##_add_epi64(acc,                                    \
+			pfx##_sad_epu8(pfx##_add_epi8(lo, hi), zero));        \
+	}                                                                     \
+	memcpy(lanes, &acc, sizeof(lanes));                                   \
+	for (i = 0; i < step; ++i) { total += lanes[i]; }                     \
+	for (i = n - n % step; i < n; ++i) {                                  \
+		total += __builtin_popcountll(p[i]);                          \
+	}                                                                     \
+	return total;                                                         \
+}
+
+da_define_popcount_vec(_avx2, DA_SCAN_AVX2, __m256i, _mm256, si256)
+da_define_popcount_vec(_avx512, DA_SCAN_AVX512, __m512i, _mm512, si512)
+
+#endif /* DA_SIMD_X86 */
+
+/* rows by `enum da_simd` */
+static const struct da_bits_kernels da_bits_table[] = {
+	da_bits_row(_base),
+#ifdef DA_SIMD_X86
+	da_bits_row(_sse2),
+	da_bits_row(_avx2),
+	da_bits_row(_avx512)
+#endif
+};
+
+/* makes room for `words` words: exactly, or by the growth policy */
+static int bits_reserve(uint64_t** bits, size_t words, int exact) {
+	size_t size;
+
+	if (*bits == NULL) {
+		*bits = da_init(sizeof(uint64_t));
+		if (*bits == NULL) {
+			return -1;
+		}
+	}
+
+	if (words <= da_capacity(*bits)) {
+		return 0;
+	}
+
+	/* `da_reserve()` keeps `da_size()` elements, i.e. words meanwhile */
+	size = da_size(*bits);
+	da_var_size(*bits) = DA_BITS_WORDS(size);
+	if (exact) {
+		da_reserve_((void**)bits, words, sizeof(uint64_t));
+	} else {
+		grow((void**)bits, words, sizeof(uint64_t));
+	}
+	da_var_size(*bits) = size;
+
+	return da_capacity(*bits) < words ? -1 : 0;
+}
+
+void da_bits_append_(uint64_t** bits, int val) {
+	size_t len = da_size(*bits);
+
+	if (len % 64 != 0) {
+		(*bits)[len / 64] |= (uint64_t)(val != 0) << len % 64;
+	} else if (bits_reserve(bits, len / 64 + 1, 0) == 0) {
+		/* the word may hold bits from before a `da_clear()` */
+		(*bits)[len / 64] = val != 0;
+	} else {
+		return;
+	}
+
+	da_var_size(*bits) = len + 1;
+}
+
+void da_bits_resize_(uint64_t** bits, size_t cnt) {
+	size_t size;
+	size_t words;
+
+	if (bits_reserve(bits, DA_BITS_WORDS(cnt), 1) != 0) {
+		return;
+	}
+
+	size = da_size(*bits);
+	words = DA_BITS_WORDS(size);
+	if (cnt > size) {
+		/* the rest of the last word is already `0` */
+		memset(*bits + words, 0,
+			(DA_BITS_WORDS(cnt) - words) * sizeof(uint64_t));
+	} else if (cnt % 64 != 0) {
+		(*bits)[cnt / 64] &= da_bits_low(cnt);
+	}
+
+	da_var_size(*bits) = cnt;
+}
+
+void da_bits_set_range(uint64_t* bits, size_t first, size_t last, int val) {
+	uint64_t head;
+	uint64_t tail;
+	size_t w0;
+	size_t w1;
+
+	if (bits == NULL) {
+		return;
+	}
+
+	if (last > da_size(bits)) {
+		last = da_size(bits);
+	}
+
+	if (first >= last) {
+		return;
+	}
+
+	w0 = first / 64;
+	w1 = (last - 1) / 64;
+	head = ~(uint64_t)0 << first % 64;
+	tail = last % 64 != 0 ? da_bits_low(last) : ~(uint64_t)0;
+	if (w0 == w1) {
+		head &= tail;
+	}
+
+	bits[w0] = val ? bits[w0] | head : bits[w0] & ~head;
+	if (w0 == w1) {
+		return;
+	}
+
+	memset(bits + w0 + 1, val ? 0xff : 0, (w1 - w0 - 1) * sizeof(uint64_t));
+	bits[w1] = val ? bits[w1] | tail : bits[w1] & ~tail;
+}
+
+size_t da_bits_popcount(const uint64_t* bits) {
+	size_t words = DA_BITS_WORDS(da_size((void*)bits));
+
+	if (words == 0) {
+		return 0;
+	}
+
+	/* bits past the size are `0` */
+	return da_bits_table[da_simd_level()].popcount(bits, words);
+}
+
+size_t da_bits_find(const uint64_t* bits, size_t from) {
+	size_t size = da_size((void*)bits);
+	size_t words = DA_BITS_WORDS(size);
+	size_t w = from / 64;
+	uint64_t x;
+
+	if (from >= size) {
+		return size;
+	}
+
+	x = bits[w] & ~(uint64_t)0 << from % 64;
+	if (x == 0) {
+		w += 1 + da_bits_table[da_simd_level()].find(
+			bits + w + 1, words - w - 1
+		);
+		if (w == words) {
+			return size;
+		}
+		x = bits[w];
+	}
+
+	/* bits past the size are `0`, so the bit found is within it */
+	return w * 64 + (size_t)__builtin_ctzll(x);
+}
+
+/* `dst` op= `src`, leaving the bits of `dst` past `n` as they are */
+static void bits_op(uint64_t* dst, const uint64_t* src, int op) {
+	size_t n;
+	uint64_t mask;
+	uint64_t s;
+
+	if (dst == NULL || src == NULL) {
+		return;
+	}
+
+	n = da_size(dst) < da_size((void*)src)
+		? da_size(dst) : da_size((void*)src);
+	da_bits_table[da_simd_level()].op[op](dst, src, n / 64);
+	if (n % 64 == 0) {
+		return;
+	}
+
+	mask = da_bits_low(n);
+	s = src[n / 64] & mask;
+	switch (op) {
+	case DA_BITS_AND: dst[n / 64] &= s | ~mask; break;
+	case DA_BITS_OR: dst[n / 64] |= s; break;
+	default: dst[n / 64] ^= s; break;
+	}
+}
+
+void da_bits_and(uint64_t* dst, const uint64_t* src) {
+	bits_op(dst, src, DA_BITS_AND);
+}
+
+void da_bits_or(uint64_t* dst, const uint64_t* src) {
+	bits_op(dst, src, DA_BITS_OR);
+}
+
+void da_bits_xor(uint64_t* dst, const uint64_t* src) {
+	bits_op(dst, src, DA_BITS_XOR);
 }
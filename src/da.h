@@ -2,6 +2,7 @@
 #define DA_H
 
 #include <stddef.h>
+#include <stdint.h>
 
 /**
  * @file
@@ -10,13 +11,18 @@
  * array pointer.
  *
  * ```c
- * +------+------+----------+
- * | cap  | size | array    |
- * +------+------+----------+
- *   ^             ^
- *   header        data pointer
+ * +------+------+------+----------+
+ * | .... | cap  | size | array    |
+ * +------+------+------+----------+
+ *   ^                    ^
+ *   header               data pointer
  * ```
  *
+ * The rest of the header (`....`) holds per-array settings: the allocator,
+ * the growth policy, the alignment, (with `DA_STATS`) a `da_stats` pointer,
+ * the reference count of a shared array and the position of the front
+ * element of a deque.
+ *
  * All functions will take/return the `data pointer`. This pointer can be
  * passed to any function expecting a standard array, as long as the pointer is
  * not `realloc`'d, `free`'d, etc. Memory management _must_ be done with the
@@ -25,6 +31,11 @@
  * Manually calling `da_init()` is not required; As long as the pointer is
  * initialised to `NULL`, calling `da_append` will work fine.
  *
+ * Memory comes from `malloc` and friends unless the array was created with
+ * `da_init_with()`, in which case every allocation for that array goes
+ * through the given `da_allocator`. Small arrays can start out in storage of
+ * the caller's, see `da_init_inline()`.
+ *
  * **Common Parameters**
  *
  * |       |                                         |
@@ -36,6 +47,295 @@
  * | `sz`  | a number of bytes (width of an element) |
  */
 
+/*///////////////////////////////////////////////////////////////////////////*/
+/* Header / metadata stuff (internal)                                        */
+/*///////////////////////////////////////////////////////////////////////////*/
+
+/* raw access to the header, used by the inline fast paths below */
+#define da_var_size(da) ((size_t*)(da))[-1]
+#define da_var_capacity(da) ((size_t*)(da))[-2]
+#define da_var_first(da) ((size_t*)(da))[-3]
+
+/*///////////////////////////////////////////////////////////////////////////*/
+/* Allocators                                                                */
+/*///////////////////////////////////////////////////////////////////////////*/
+
+/**
+ * A source of memory for an array.
+ *
+ * The callbacks receive the allocator itself, so `ctx` (or a larger struct
+ * with the allocator as its first member) can carry any state. Every block is
+ * returned with the size that was requested for it, so allocators do not need
+ * to track sizes themselves.
+ *
+ * Returned memory must be suitably aligned for any type (as with `malloc`).
+ */
+typedef struct da_allocator da_allocator;
+struct da_allocator {
+	/** returns a block of at least `bytes` bytes, or `NULL` */
+	void* (*alloc)(const da_allocator* self, size_t bytes);
+	/** as `realloc`, `ptr` is never `NULL` */
+	void* (*resize)(
+		const da_allocator* self, void* ptr,
+		size_t old_bytes, size_t new_bytes
+	);
+	/** releases a block, `ptr` is never `NULL` */
+	void (*release)(const da_allocator* self, void* ptr, size_t bytes);
+	/** user data */
+	void* ctx;
+	/** (optional) usable size of a block, see `da_growth.usable_size` */
+	size_t (*usable)(const da_allocator* self, void* ptr, size_t bytes);
+};
+
+/**
+ * The default allocator; `malloc`, `realloc` and `free`.
+ */
+extern const da_allocator da_malloc_allocator;
+
+/**
+ * Anonymous `mmap` memory, grown with `mremap` so that the kernel moves the
+ * pages instead of copying the contents (Linux only, elsewhere this is the
+ * default allocator).
+ *
+ * Arrays using the default allocator switch to this automatically once they
+ * grow past a threshold, see `da_set_mmap_threshold()`.
+ */
+extern const da_allocator da_mmap_allocator;
+
+/**
+ * As `da_mmap_allocator`, additionally requesting transparent huge pages
+ * (`MADV_HUGEPAGE`) to reduce TLB misses.
+ */
+extern const da_allocator da_mmap_huge_allocator;
+
+/**
+ * Sets the allocation size (header + capacity) at which arrays using the
+ * default allocator move to `da_mmap_allocator`.
+ *
+ * The move copies the contents once, after which growth is done by `mremap`.
+ * The default threshold is 64 MiB. Not thread safe; Intended to be called at
+ * startup.
+ *
+ * @param	bytes	the threshold (`0` to never switch)
+ * @param	huge_pages	if non-zero, switch to `da_mmap_huge_allocator`
+ *		instead
+ */
+void da_set_mmap_threshold(size_t bytes, int huge_pages);
+
+/**
+ * Enables a per-thread cache of freed blocks for arrays using the default
+ * allocator (disabled by default).
+ *
+ * Blocks of up to 64 KiB are grouped into power of two size classes. Freeing
+ * an array (or growing it out of a block) keeps the block on the calling
+ * thread's list for its class, and `da_init()` and growth take blocks from
+ * there before calling `malloc`. While enabled, these blocks are allocated at
+ * the full size of their class.
+ *
+ * Each thread holds at most `max_bytes` of blocks; Any more are freed. The
+ * cache of a thread is freed when the thread exits (`pthread_exit` or
+ * returning from the start routine), other threads' caches (e.g. the main
+ * thread's) need `da_thread_cache_drain()`. Not thread safe; Intended to be
+ * called at startup.
+ *
+ * @param	max_bytes	bound of each thread's cache (`0` to disable,
+ *		cached blocks are kept until drained)
+ */
+void da_set_thread_cache(size_t max_bytes);
+
+/**
+ * Frees every block held in the calling thread's cache.
+ *
+ * @see	`da_set_thread_cache()`
+ */
+void da_thread_cache_drain(void);
+
+/**
+ * A bump allocator; Arrays are carved out of large blocks and are all
+ * released at once with `da_arena_release()` or `da_arena_reset()`.
+ *
+ * Freeing or growing the most recent allocation is done in place, otherwise
+ * `da_free` is a no-op and growth copies into a new allocation.
+ *
+ * ```c
+ * da_arena arena;
+ * da_arena_init(&arena, 64 * 1024);
+ * int* arr = da_init_with(sizeof(*arr), &arena.allocator);
+ * // ...
+ * da_arena_release(&arena);
+ * ```
+ */
+typedef struct da_arena {
+	/** pass to `da_init_with()` */
+	da_allocator allocator;
+	/** (internal) most recent block */
+	struct da_arena_block* head;
+	/** (internal) minimum size of a block */
+	size_t block_size;
+} da_arena;
+
+/**
+ * Initialises an arena.
+ *
+ * No memory is allocated until the first array is created.
+ *
+ * @param	arena	the arena to initialise
+ * @param	block_size	minimum number of bytes to request from `malloc`
+ */
+void da_arena_init(da_arena* arena, size_t block_size);
+
+/**
+ * Invalidates every array allocated from the arena, keeping the most recent
+ * block for reuse.
+ *
+ * @param	arena	an initialised arena
+ */
+void da_arena_reset(da_arena* arena);
+
+/**
+ * Invalidates every array allocated from the arena and frees all memory.
+ *
+ * @param	arena	an initialised arena
+ */
+void da_arena_release(da_arena* arena);
+
+/*///////////////////////////////////////////////////////////////////////////*/
+/* Growth policy                                                             */
+/*///////////////////////////////////////////////////////////////////////////*/
+
+/**
+ * Rounding applied to the size of an allocation when an array grows.
+ */
+enum da_round {
+	/** allocate exactly what the growth factor asks for */
+	DA_ROUND_NONE,
+	/** round up to a multiple of 4096 bytes */
+	DA_ROUND_PAGE,
+	/** round up to one of four size classes per power of two */
+	DA_ROUND_SIZE_CLASS
+};
+
+/**
+ * How an array grows when it runs out of capacity.
+ *
+ * The new capacity is `capacity * num / den + bias` elements (or whatever is
+ * needed, if that is more), after which the whole allocation is rounded and
+ * the capacity set to fill it.
+ *
+ * Optionally, arrays shrink when elements are removed and the size falls
+ * below `capacity / shrink`. The capacity is then set one growth step above
+ * the size, so an array sitting near a boundary does not alternate between
+ * growing and shrinking. `shrink` must be greater than the growth factor;
+ * Squaring the growth factor (or more) works well.
+ *
+ * The default is `{ 2, 3, 2, 8, DA_ROUND_NONE, 0, 0 }`.
+ */
+typedef struct da_growth {
+	/** capacity of a newly initialised array */
+	size_t initial;
+	/** growth factor numerator (MUST be > `den`) */
+	size_t num;
+	/** growth factor denominator (MUST NOT be `0`) */
+	size_t den;
+	/** elements added on top of the growth factor */
+	size_t bias;
+	/** rounding of the allocation size, see `da_round` */
+	enum da_round round;
+	/**
+	 * if non-zero, after every allocation ask the allocator for the real
+	 * size of the block (`malloc_usable_size` for the default allocator)
+	 * and use any slack as capacity
+	 */
+	int usable_size;
+	/** shrink when less than 1 / `shrink` full (`0` to never shrink) */
+	size_t shrink;
+} da_growth;
+
+/**
+ * Sets the growth policy used by arrays that do not have their own.
+ *
+ * Also decides the initial capacity of new arrays. Not thread safe; Intended
+ * to be called at startup.
+ *
+ * @param	growth	the policy (`NULL` restores the default), MUST outlive
+ *		every array using it
+ */
+void da_set_default_growth(const da_growth* growth);
+
+/**
+ * Sets the growth policy of a single array.
+ *
+ * If `da` == `NULL`, does nothing.
+ *
+ * @param	da	a valid `data pointer` (MAY be `NULL`)
+ * @param	growth	the policy (`NULL` to use the default), MUST outlive
+ *		the array
+ */
+#define da_set_growth(da, growth) da_set_growth_(da, growth)
+void da_set_growth_(void* da, const da_growth* growth);
+
+/*///////////////////////////////////////////////////////////////////////////*/
+/* Instrumentation                                                           */
+/*///////////////////////////////////////////////////////////////////////////*/
+
+/**
+ * Allocation and growth counters.
+ *
+ * Only collected when the library is compiled with `DA_STATS` defined (which
+ * also adds a pointer to the header); Otherwise the functions below are
+ * no-ops and every counter reads as `0`. Counters are updated atomically, so
+ * one struct MAY be shared by arrays on different threads.
+ */
+typedef struct da_stats {
+	/** new arrays */
+	size_t allocs;
+	/** reallocations to a larger capacity */
+	size_t grows;
+	/** reallocations to a smaller capacity */
+	size_t shrinks;
+	/** failed allocations (including sizes that would overflow) */
+	size_t failed;
+	/** total requested by allocations and reallocations */
+	size_t bytes_allocated;
+	/** copied because a reallocation moved the block (estimated) */
+	size_t bytes_copied;
+	/** shifted within an array by insertions and removals */
+	size_t bytes_moved;
+	/** largest capacity (in bytes) any array reached */
+	size_t peak_capacity_bytes;
+	/** blocks taken from a thread cache, see `da_set_thread_cache()` */
+	size_t cache_hits;
+} da_stats;
+
+/**
+ * Copies the process-wide counters into `out`.
+ *
+ * Each counter is read atomically, but not all at once.
+ *
+ * @param	out	where to store the counters (MUST NOT be `NULL`)
+ */
+void da_stats_snapshot(da_stats* out);
+
+/**
+ * Resets the process-wide counters to `0`.
+ *
+ * Not thread safe with respect to arrays being modified concurrently.
+ */
+void da_stats_reset(void);
+
+/**
+ * Additionally counts the events of a single array into `stats`.
+ *
+ * The same struct can be given to several arrays, e.g. every array created at
+ * one call site. Creating the array is counted only process-wide. If `da` ==
+ * `NULL`, does nothing.
+ *
+ * @param	da	a valid `data pointer` (MAY be `NULL`)
+ * @param	stats	the counters (`NULL` to stop), MUST outlive the array
+ */
+#define da_set_stats(da, stats) da_set_stats_(da, stats)
+void da_set_stats_(void* da, da_stats* stats);
+
 /*///////////////////////////////////////////////////////////////////////////*/
 /* DynamicArray                                                              */
 /*///////////////////////////////////////////////////////////////////////////*/
@@ -55,6 +355,109 @@
  */
 void* da_init(size_t sz);
 
+/**
+ * Initialises the array + header, using the given allocator for this array's
+ * memory (for its entire lifetime).
+ *
+ * The allocator must outlive the array.
+ *
+ * @param	allocator	source of memory (`NULL` for the default)
+ *
+ * @returns	on success	a pointer to an array
+ * @returns	on failure	NULL
+ *
+ * **Errors**
+ * - ENOMEM: Out of memory; set via the allocator.
+ *
+ * @see	`da_init()`
+ */
+void* da_init_with(size_t sz, const da_allocator* allocator);
+
+/**
+ * Largest alignment accepted by `da_init_aligned()` (a typical page size).
+ */
+#define DA_ALIGN_MAX 4096
+
+/**
+ * Initialises the array + header, with the data pointer aligned to `align`
+ * bytes (e.g. for SIMD loads or to keep elements on separate cache lines).
+ *
+ * The alignment is kept for the lifetime of the array, including when the
+ * memory is reallocated.
+ *
+ * The data pointer is never less aligned than it would be from `da_init()`.
+ *
+ * @param	align	a power of two, no greater than `DA_ALIGN_MAX`
+ *
+ * @returns	on success	a pointer to an array
+ * @returns	on failure	NULL
+ *
+ * **Errors**
+ * - EINVAL: `align` is not a power of two or is too large.
+ * - ENOMEM: Out of memory; set via `malloc`.
+ *
+ * @see	`da_init()`
+ */
+void* da_init_aligned(size_t sz, size_t align);
+
+/**
+ * Bytes of inline storage taken by the header (at most), on top of one spare
+ * element. The `da_stats` pointer only exists with `DA_STATS`, which MUST
+ * then be defined for the callers too.
+ */
+#ifdef DA_STATS
+#define DA_INLINE_HEADER 72
+#else
+#define DA_INLINE_HEADER 64
+#endif
+
+/**
+ * Type of inline storage for `cnt` elements of `type`, suitably aligned for
+ * `da_init_inline()`.
+ *
+ * ```c
+ * DA_INLINE_STORAGE(int, 16) buf;
+ * int* arr = da_init_inline(&buf, sizeof(buf), sizeof(*arr));
+ * ```
+ */
+#define DA_INLINE_STORAGE(type, cnt)                                          \
+	union {                                                               \
+		long l_;                                                      \
+		double d_;                                                    \
+		long double ld_;                                              \
+		void* p_;                                                     \
+		unsigned char bytes_[                                         \
+			DA_INLINE_HEADER + sizeof(type) * ((cnt) + 1)         \
+		];                                                            \
+	}
+
+/**
+ * Initialises the array + header inside caller-provided storage (e.g. a
+ * local variable or a struct member), without allocating.
+ *
+ * The array behaves like any other. When it outgrows the storage, the
+ * elements move to the heap (`malloc`) and the storage is no longer used.
+ * `da_free()` never frees the storage itself, but MUST still be called in
+ * case the array moved.
+ *
+ * The storage MUST outlive the array, and MUST NOT be reused while the array
+ * is alive.
+ *
+ * @param	buf	the storage, aligned at least like `size_t` and the
+ *		elements (see `DA_INLINE_STORAGE()`)
+ * @param	bytes	size of the storage
+ *
+ * @returns	on success	a pointer to an array
+ * @returns	on failure	NULL
+ *
+ * **Errors**
+ * - EINVAL: `buf` is misaligned, or too small for the header and a single
+ *   element.
+ *
+ * @see	`da_init()`
+ */
+void* da_init_inline(void* buf, size_t bytes, size_t sz);
+
 /**
  * Free's the array (and sets the pointer to `NULL`).
  *
@@ -118,7 +521,7 @@ void da_assign_(void** da, void* src, size_t cnt, size_t sz);
  * @returns	on success	a pointer to an element in the array
  * @returns	on failure	`NULL`
  */
-#define da_at(da, idx) (__typeof__(da))da_at_(da, idx, sizeof(*(da)))
+#define da_at(da, idx) ((__typeof__(da))da_at_(da, idx, sizeof(*(da))))
 void* da_at_(void* da, size_t idx, size_t sz);
 
 /*///////////////////////////////////////////////////////////////////////////*/
@@ -154,6 +557,9 @@ size_t da_capacity_(void* da);
 /**
  * Reserves additional memory for the array.
  *
+ * Sets the capacity to `cnt`, but never below `da_size(da)`: elements are
+ * never dropped.
+ *
  * If `da` == `NULL` the array is initialised.
  *
  * @param	da	a valid `data pointer` (MAY be `NULL`)
@@ -165,6 +571,21 @@ size_t da_capacity_(void* da);
 #define da_reserve(da, cnt) da_reserve_((void**)&(da), cnt, sizeof(*(da)))
 void da_reserve_(void** da, size_t cnt, size_t sz);
 
+/**
+ * Reduces the capacity to the current number of elements.
+ *
+ * If `da` == `NULL`, does nothing.
+ *
+ * @param	da	a valid `data pointer` (MAY be `NULL`)
+ *
+ * **Errors**
+ * - ENOMEM: Out of memory; set via `da_reserve()`, the array is unchanged.
+ *
+ * @see	`da_growth.shrink` for shrinking automatically
+ */
+#define da_shrink_to_fit(da) da_shrink_to_fit_((void**)&(da), sizeof(*(da)))
+void da_shrink_to_fit_(void** da, size_t sz);
+
 /*///////////////////////////////////////////////////////////////////////////*/
 /* Modifiers                                                                 */
 /*///////////////////////////////////////////////////////////////////////////*/
@@ -172,12 +593,22 @@ void da_reserve_(void** da, size_t cnt, size_t sz);
 /**
  * Sets the array size to 0, capacity remains unchanged.
  *
+ * Note: Not affected by `da_growth.shrink`, follow with `da_shrink_to_fit()`
+ * to release the memory.
+ *
+ * A shared or mapped array is not copied: the caller's reference is dropped
+ * for a new empty array (so the pointer changes), see `da_share()` and
+ * `da_mmap()`.
+ *
  * If `da` == `NULL`, does nothing.
  *
  * @param	da	a valid `data pointer` (MAY be `NULL`)
+ *
+ * **Errors**
+ * - ENOMEM: Out of memory for the new array; the array is unchanged.
  */
-#define da_clear(da) da_clear_(da)
-void da_clear_(void* da);
+#define da_clear(da) da_clear_((void**)&(da), sizeof(*(da)))
+void da_clear_(void** da, size_t sz);
 
 /**
  * Copies the value into the array at the given index, allocating additional
@@ -203,6 +634,35 @@ do {                                                                          \
 } while (0)
 void da_insert_(void** da, size_t idx, void* val, size_t sz);
 
+/**
+ * Copies `cnt` elements from the `src` array into the array at the given
+ * index, allocating additional memory if required.
+ *
+ * The existing elements are shifted once, regardless of `cnt`.
+ *
+ * If `da` == `NULL` the array is initialised.
+ * If `idx` > `da_size(da)`, does nothing.
+ *
+ * @param	da	a valid `data pointer` (MAY be `NULL`)
+ * @param	idx	index into the array
+ * @param	src	pointer to an array of at least `cnt` elements (MUST NOT
+ *		point into `da`)
+ * @param	cnt	number of elements in the `src` array
+ *
+ * **Errors**
+ * - ENOMEM: Out of memory; set via `da_reserve()`.
+ *
+ * @see	`da_insert()`
+ */
+#define da_insert_n(da, idx, src, cnt)                                        \
+do {                                                                          \
+	const __typeof__(*(da))* tmp = (src);                                 \
+	da_insert_n_((void**)&(da), idx, tmp, cnt, sizeof(*tmp));             \
+} while (0)
+void da_insert_n_(
+	void** da, size_t idx, const void* src, size_t cnt, size_t sz
+);
+
 /**
  * Removes an element from the array.
  *
@@ -215,11 +675,79 @@ void da_insert_(void** da, size_t idx, void* val, size_t sz);
 #define da_erase(da, idx) da_erase_((void**)&(da), idx, sizeof(*(da)))
 void da_erase_(void** da, size_t idx, size_t sz);
 
+/**
+ * Removes the elements in the range [`first`, `last`) from the array.
+ *
+ * The remaining elements are shifted once, regardless of the size of the
+ * range.
+ *
+ * If `da` == `NULL`, does nothing.
+ * If `first` >= `last` or `first` >= `da_size(da)`, does nothing.
+ * If `last` > `da_size(da)`, the range ends at `da_size(da)`.
+ *
+ * @param	da	a valid `data pointer` (MAY be `NULL`)
+ * @param	first	index of the first element to remove
+ * @param	last	index one past the last element to remove
+ *
+ * @see	`da_erase()`
+ */
+#define da_erase_range(da, first, last)                                       \
+	da_erase_range_((void**)&(da), first, last, sizeof(*(da)))
+void da_erase_range_(void** da, size_t first, size_t last, size_t sz);
+
+/**
+ * Removes an element from the array by moving the last element into its
+ * place; The order of the elements is not preserved.
+ *
+ * If `da` == `NULL`, does nothing.
+ * If `idx` >= `da_size(da)`, does nothing.
+ *
+ * @param	da	a valid `data pointer` (MAY be `NULL`)
+ * @param	idx	index into the array
+ *
+ * @see	`da_erase()`
+ */
+#define da_swap_remove(da, idx)                                               \
+	da_swap_remove_((void**)&(da), idx, sizeof(*(da)))
+void da_swap_remove_(void** da, size_t idx, size_t sz);
+
+/**
+ * Predicate for `da_remove_if()`.
+ *
+ * @param	elem	pointer to an element of the array
+ * @param	ctx	the `ctx` passed to `da_remove_if()`
+ *
+ * @returns	non-zero if the element should be removed
+ */
+typedef int (*da_predicate)(const void* elem, void* ctx);
+
+/**
+ * Removes every element for which `pred` returns non-zero, in a single pass.
+ *
+ * The order of the remaining elements is preserved.
+ *
+ * If `da` == `NULL`, does nothing.
+ *
+ * @param	da	a valid `data pointer` (MAY be `NULL`)
+ * @param	pred	called once per element, in order
+ * @param	ctx	passed through to `pred` (MAY be `NULL`)
+ *
+ * @returns	the number of elements removed
+ *
+ * @see	`da_erase()`
+ */
+#define da_remove_if(da, pred, ctx)                                           \
+	da_remove_if_((void**)&(da), pred, ctx, sizeof(*(da)))
+size_t da_remove_if_(void** da, da_predicate pred, void* ctx, size_t sz);
+
 /**
  * Copies the value to the end of the array, reallocating if required.
  *
  * If `da` == `NULL` the array is initialised.
  *
+ * Note: While there is spare capacity the value is stored directly, without a
+ * function call; Only initialisation and growth go through `da_append_()`.
+ *
  * @param	da	a valid `data pointer` (MAY be `NULL`)
  * @param	val	the value to copy
  *
@@ -231,8 +759,1510 @@ void da_erase_(void** da, size_t idx, size_t sz);
 #define da_append(da, val)                                                    \
 do {                                                                          \
 	__typeof__(*(da)) tmp = (val);                                        \
-	da_append_((void**)&(da), &tmp, sizeof(tmp));                         \
+	if ((da) != NULL && da_var_size(da) < da_var_capacity(da)) {          \
+		size_t len = da_var_size(da);                                 \
+		(da)[len] = tmp;                                              \
+		da_var_size(da) = len + 1;                                    \
+	} else {                                                              \
+		da_append_((void**)&(da), &tmp, sizeof(tmp));                 \
+	}                                                                     \
 } while (0)
 void da_append_(void** da, void* val, size_t sz);
 
+/**
+ * Copies `cnt` elements from the `src` array to the end of the array,
+ * reallocating at most once.
+ *
+ * If `da` == `NULL` the array is initialised.
+ *
+ * @param	da	a valid `data pointer` (MAY be `NULL`)
+ * @param	src	pointer to an array of at least `cnt` elements (MUST NOT
+ *		point into `da`)
+ * @param	cnt	number of elements in the `src` array
+ *
+ * **Errors**
+ * - ENOMEM: Out of memory; set via `da_reserve()`.
+ *
+ * @see	`da_append()`
+ */
+#define da_append_n(da, src, cnt)                                             \
+do {                                                                          \
+	const __typeof__(*(da))* tmp = (src);                                 \
+	da_append_n_((void**)&(da), tmp, cnt, sizeof(*tmp));                  \
+} while (0)
+void da_append_n_(void** da, const void* src, size_t cnt, size_t sz);
+
+/*///////////////////////////////////////////////////////////////////////////*/
+/* Deque                                                                     */
+/*///////////////////////////////////////////////////////////////////////////*/
+
+/*
+ * Any array can be used as a double-ended queue: The elements then occupy a
+ * ring starting at a front position kept in the header, so pushing and
+ * popping at either end is O(1) (amortized when growing).
+ *
+ * While the front is not at position 0, the elements may wrap around the end
+ * of the capacity and the data pointer is NOT a plain array. Only the
+ * functions of this section, `da_size()`, `da_capacity()`, `da_reserve()`,
+ * `da_clear()` and `da_free()` may be used; `da_deque_linearize()` makes it a
+ * plain array again. An array is never turned into a deque except by the
+ * functions below.
+ */
+
+/* (internal) position of the element at index `idx` of a deque */
+#define da_deque_pos_(da, idx)                                                \
+	(da_var_first(da) + (idx) >= da_var_capacity(da)                      \
+		? da_var_first(da) + (idx) - da_var_capacity(da)              \
+		: da_var_first(da) + (idx))
+
+/**
+ * Element at the given index of a deque (lvalue), without bounds checking.
+ *
+ * `idx` is evaluated more than once.
+ *
+ * @param	da	a valid `data pointer` (MUST NOT be `NULL`)
+ * @param	idx	index into the deque (MUST be < `da_size(da)`)
+ */
+#define da_deque_get(da, idx) (da)[da_deque_pos_(da, idx)]
+
+/**
+ * Returns a pointer to the value at the given index of a deque (with bounds
+ * checking).
+ *
+ * If `da` == `NULL`, `NULL` is returned.
+ *
+ * @param	da	a valid `data pointer` (MAY be `NULL`)
+ *
+ * @returns	on success	a pointer to an element in the deque
+ * @returns	on failure	`NULL`
+ */
+#define da_deque_at(da, idx)                                                  \
+	((__typeof__(da))da_deque_at_(da, idx, sizeof(*(da))))
+void* da_deque_at_(void* da, size_t idx, size_t sz);
+
+/**
+ * First element of a deque (lvalue).
+ *
+ * @param	da	a valid `data pointer` (MUST NOT be `NULL` or empty)
+ */
+#define da_deque_front(da) (da)[da_var_first(da)]
+
+/**
+ * Last element of a deque (lvalue).
+ *
+ * @param	da	a valid `data pointer` (MUST NOT be `NULL` or empty)
+ */
+#define da_deque_back(da) da_deque_get(da, da_var_size(da) - 1)
+
+/**
+ * Copies the value to the back of the deque, reallocating if required.
+ *
+ * If `da` == `NULL` the array is initialised.
+ *
+ * @param	da	a valid `data pointer` (MAY be `NULL`)
+ * @param	val	the value to copy
+ *
+ * **Errors**
+ * - ENOMEM: Out of memory; set via `da_reserve()`.
+ */
+#define da_deque_push_back(da, val)                                           \
+do {                                                                          \
+	__typeof__(*(da)) tmp = (val);                                        \
+	da_deque_push_((void**)&(da), &tmp, 0, sizeof(tmp));                  \
+} while (0)
+
+/**
+ * Copies the value to the front of the deque, reallocating if required.
+ *
+ * If `da` == `NULL` the array is initialised.
+ *
+ * @param	da	a valid `data pointer` (MAY be `NULL`)
+ * @param	val	the value to copy
+ *
+ * **Errors**
+ * - ENOMEM: Out of memory; set via `da_reserve()`.
+ */
+#define da_deque_push_front(da, val)                                          \
+do {                                                                          \
+	__typeof__(*(da)) tmp = (val);                                        \
+	da_deque_push_((void**)&(da), &tmp, 1, sizeof(tmp));                  \
+} while (0)
+void da_deque_push_(void** da, const void* val, int front, size_t sz);
+
+/**
+ * Removes the last element of the deque.
+ *
+ * If `da` == `NULL` or empty, does nothing.
+ *
+ * @param	da	a valid `data pointer` (MAY be `NULL`)
+ *
+ * **Errors**
+ * - ENOMEM: Out of memory copying a shared or mapped array; set via
+ *   `da_reserve()`, the array is unchanged.
+ */
+#define da_deque_pop_back(da)                                                 \
+	da_deque_pop_((void**)&(da), 0, sizeof(*(da)))
+
+/**
+ * Removes the first element of the deque.
+ *
+ * If `da` == `NULL` or empty, does nothing. Once the deque is empty, it is a
+ * plain array again.
+ *
+ * @param	da	a valid `data pointer` (MAY be `NULL`)
+ *
+ * **Errors**
+ * - ENOMEM: Out of memory copying a shared or mapped array; set via
+ *   `da_reserve()`, the array is unchanged.
+ */
+#define da_deque_pop_front(da)                                                \
+	da_deque_pop_((void**)&(da), 1, sizeof(*(da)))
+void da_deque_pop_(void** da, int front, size_t sz);
+
+/**
+ * Moves the elements of a deque so that the front is at position 0, making
+ * it a plain array (in place, without allocating).
+ *
+ * If `da` == `NULL`, `NULL` is returned.
+ *
+ * @param	da	a valid `data pointer` (MAY be `NULL`)
+ *
+ * @returns	`da`, now usable as a plain array
+ */
+#define da_deque_linearize(da)                                                \
+	((__typeof__(da))da_deque_linearize_(da, sizeof(*(da))))
+void* da_deque_linearize_(void* da, size_t sz);
+
+/*///////////////////////////////////////////////////////////////////////////*/
+/* Concurrent append                                                         */
+/*///////////////////////////////////////////////////////////////////////////*/
+
+/**
+ * Number of segments of a `da_conc`, enough for `base << DA_CONC_SEGMENTS`
+ * elements.
+ */
+#define DA_CONC_SEGMENTS 48
+
+/**
+ * An append-only array that many threads can append to at once, without
+ * locks.
+ *
+ * Producers claim slots with an atomic compare-and-swap of `claimed`. The
+ * storage is a list of segments that never move: Segment 0 holds `base`
+ * elements (the reservation), each further segment twice as many as the
+ * previous, and is allocated by whichever producer first needs it, before it
+ * claims slots in it. So no producer ever writes to a freed buffer, and every
+ * claimed slot gets written.
+ *
+ * Readers see the published prefix: every element before `da_conc_size()` is
+ * fully written.
+ *
+ * Once the producers are done, `da_conc_to_da()` turns the contents into a
+ * plain array; Without copying if everything fit in the reservation.
+ */
+typedef struct da_conc {
+	/** (internal) segment 0 is a plain array, the rest `malloc`'d */
+	void* segments[DA_CONC_SEGMENTS];
+	/**
+	 * (internal) a flag per element of segment 0, set once written (the
+	 * other segments keep theirs after the elements)
+	 */
+	unsigned char* ready;
+	/** (internal) width of an element */
+	size_t sz;
+	/** (internal) elements in segment 0 */
+	size_t base;
+	/** (internal) slots handed out to producers */
+	size_t claimed;
+	/** (internal) length of the written prefix, as last seen */
+	size_t published;
+	/** (internal) slots whose segments are all allocated */
+	size_t allocated;
+	/** (internal) for every allocation, `NULL` for the default */
+	const da_allocator* allocator;
+} da_conc;
+
+/**
+ * Initialises a concurrent array, allocating the first segment.
+ *
+ * @param	conc	the array to initialise
+ * @param	reserve	elements expected (the size of segment 0, at least 16)
+ *
+ * @returns	on success	`0`
+ * @returns	on failure	`-1`
+ *
+ * **Errors**
+ * - ENOMEM: Out of memory; set via `malloc`.
+ */
+int da_conc_init(da_conc* conc, size_t sz, size_t reserve);
+
+/**
+ * As `da_conc_init()`, allocating the segments (and the array made by
+ * `da_conc_to_da()`) with `allocator`, whose functions MUST be thread safe.
+ *
+ * @param	allocator	the allocator (MAY be `NULL`, for the default)
+ */
+int da_conc_init_with(
+	da_conc* conc, size_t sz, size_t reserve, const da_allocator* allocator
+);
+
+/**
+ * Copies `conc->sz` bytes from `val` to the end of the array. Thread safe.
+ *
+ * On failure no slot is claimed, and the array is unchanged: Later appends
+ * (and those of other producers) carry on publishing.
+ *
+ * @param	conc	an initialised concurrent array
+ * @param	val	pointer to the value to copy
+ *
+ * @returns	on success	`0`
+ * @returns	on failure	`-1`
+ *
+ * **Errors**
+ * - ENOMEM: Out of memory; set via `malloc`.
+ */
+int da_conc_append(da_conc* conc, const void* val);
+
+/**
+ * Copies `cnt` elements from the `src` array to the end of the array, as a
+ * single contiguous run. Thread safe.
+ *
+ * Claims every slot at once, so batching values this way is cheaper than
+ * calling `da_conc_append()` for each. On failure none is claimed.
+ *
+ * @param	conc	an initialised concurrent array
+ * @param	src	pointer to an array of at least `cnt` elements
+ * @param	cnt	number of elements in the `src` array
+ *
+ * @returns	on success	`0`
+ * @returns	on failure	`-1`
+ *
+ * **Errors**
+ * - ENOMEM: Out of memory; set via `malloc`.
+ *
+ * @see	`da_conc_append()`
+ */
+int da_conc_append_n(da_conc* conc, const void* src, size_t cnt);
+
+/**
+ * Returns the number of elements published, i.e. the length of the prefix
+ * written completely. Thread safe.
+ *
+ * The value only ever increases.
+ *
+ * @param	conc	an initialised concurrent array
+ */
+size_t da_conc_size(da_conc* conc);
+
+/**
+ * Returns a pointer to a published element. Thread safe.
+ *
+ * @param	conc	an initialised concurrent array
+ * @param	idx	index into the array
+ *
+ * @returns	on success	a pointer to an element in the array
+ * @returns	on failure	`NULL`, `idx` >= `da_conc_size(conc)`
+ */
+void* da_conc_at(da_conc* conc, size_t idx);
+
+/**
+ * Moves the published elements into a plain array (see `da_init()`) and
+ * frees the concurrent array. Not thread safe; Call once every producer is
+ * done.
+ *
+ * The array is segment 0, to which any further segments are appended.
+ *
+ * @param	conc	an initialised concurrent array
+ *
+ * @returns	on success	a pointer to an array
+ * @returns	on failure	NULL, `conc` MUST still be freed
+ *
+ * **Errors**
+ * - ENOMEM: Out of memory; set via `da_reserve()`.
+ */
+void* da_conc_to_da(da_conc* conc);
+
+/**
+ * Frees the concurrent array. Not thread safe.
+ *
+ * @param	conc	an initialised concurrent array
+ */
+void da_conc_free(da_conc* conc);
+
+/*///////////////////////////////////////////////////////////////////////////*/
+/* Segmented array                                                           */
+/*///////////////////////////////////////////////////////////////////////////*/
+
+/**
+ * A companion to the dynamic array whose elements never move.
+ *
+ * ```c
+ * +------+------+---------+---------+-----+
+ * | cap  | size | chunk 0 | chunk 1 | ... |
+ * +------+------+---------+---------+-----+
+ *                 ^
+ *                 table pointer
+ * ```
+ *
+ * The "array" is a table of pointers to chunks (e.g. `int** seg`), chunk `k`
+ * holding `DA_SEG_FIRST << k` elements. Growing allocates one more chunk and
+ * never copies, so element addresses are stable for the lifetime of the
+ * array. Finding the chunk of an index takes a count of leading zeros, no
+ * division.
+ *
+ * As with the dynamic array, a `NULL` pointer is an empty array.
+ */
+
+/** Number of elements in chunk 0 (a power of two). */
+#define DA_SEG_FIRST 16
+
+/** Maximum number of chunks. */
+#define DA_SEG_CHUNKS 40
+
+/* (internal) index of the highest set bit, `x` MUST NOT be `0` */
+#define da_seg_log2_(x)                                                       \
+	(sizeof(unsigned long) * 8 - 1 - __builtin_clzl((unsigned long)(x)))
+
+/* (internal) chunk holding `idx`, and the offset into it */
+#define da_seg_chunk_(idx)                                                    \
+	(da_seg_log2_((idx) + DA_SEG_FIRST) - da_seg_log2_(DA_SEG_FIRST))
+#define da_seg_offset_(idx)                                                   \
+	((idx) + DA_SEG_FIRST - ((size_t)DA_SEG_FIRST << da_seg_chunk_(idx)))
+
+/**
+ * Initialises an empty segmented array (no chunks are allocated).
+ *
+ * Note: The array can also be "initialised" by setting the pointer to `NULL`
+ *
+ * @returns	on success	a pointer to the chunk table
+ * @returns	on failure	NULL
+ *
+ * **Errors**
+ * - ENOMEM: Out of memory; set via `malloc`.
+ *
+ * @see	`da_seg_free()`
+ */
+void* da_seg_init(size_t sz);
+
+/**
+ * Free's the segmented array (and sets the pointer to `NULL`).
+ *
+ * @param	seg	a valid table pointer (MAY be `NULL`)
+ */
+#define da_seg_free(seg)                                                      \
+do {                                                                          \
+	da_seg_free_(seg);                                                    \
+	(seg) = NULL;                                                         \
+} while (0)
+void da_seg_free_(void* seg);
+
+/**
+ * Element at the given index (lvalue), without bounds checking.
+ *
+ * `idx` is evaluated more than once.
+ *
+ * @param	seg	a valid table pointer (MUST NOT be `NULL`)
+ * @param	idx	index into the array (MUST be < `da_seg_size(seg)`)
+ */
+#define da_seg_get(seg, idx) (seg)[da_seg_chunk_(idx)][da_seg_offset_(idx)]
+
+/**
+ * Returns a pointer to the value at the given index (with bounds checking).
+ *
+ * The pointer stays valid until the array is freed.
+ *
+ * If `seg` == `NULL`, `NULL` is returned.
+ *
+ * @param	seg	a valid table pointer (MAY be `NULL`)
+ *
+ * @returns	on success	a pointer to an element in the array
+ * @returns	on failure	`NULL`
+ */
+#define da_seg_at(seg, idx)                                                   \
+	((__typeof__(*(seg)))da_seg_at_(seg, idx, sizeof(**(seg))))
+void* da_seg_at_(void* seg, size_t idx, size_t sz);
+
+/**
+ * Returns the current number of elements in the array.
+ *
+ * @param	seg	a valid table pointer (MAY be `NULL`)
+ */
+#define da_seg_size(seg) da_size(seg)
+
+/**
+ * Returns the number of elements the allocated chunks can hold.
+ *
+ * @param	seg	a valid table pointer (MAY be `NULL`)
+ */
+#define da_seg_capacity(seg) da_capacity(seg)
+
+/**
+ * Allocates chunks until the array can hold `cnt` elements.
+ *
+ * If `seg` == `NULL` the array is initialised.
+ *
+ * @param	seg	a valid table pointer (MAY be `NULL`)
+ * @param	cnt	number of elements to reserve space for
+ *
+ * **Errors**
+ * - ENOMEM: Out of memory or chunks; set via `malloc`.
+ */
+#define da_seg_reserve(seg, cnt)                                              \
+	da_seg_reserve_((void**)&(seg), cnt, sizeof(**(seg)))
+void da_seg_reserve_(void** seg, size_t cnt, size_t sz);
+
+/**
+ * Copies the value to the end of the array, allocating a chunk if required.
+ *
+ * If `seg` == `NULL` the array is initialised.
+ *
+ * Note: While there is spare capacity the value is stored directly, without a
+ * function call.
+ *
+ * @param	seg	a valid table pointer (MAY be `NULL`)
+ * @param	val	the value to copy
+ *
+ * **Errors**
+ * - ENOMEM: Out of memory; set via `da_seg_reserve()`.
+ */
+#define da_seg_append(seg, val)                                               \
+do {                                                                          \
+	__typeof__(**(seg)) tmp = (val);                                      \
+	if ((seg) != NULL && da_var_size(seg) < da_var_capacity(seg)) {       \
+		size_t len = da_var_size(seg);                                \
+		da_seg_get(seg, len) = tmp;                                   \
+		da_var_size(seg) = len + 1;                                   \
+	} else {                                                              \
+		da_seg_append_((void**)&(seg), &tmp, sizeof(tmp));            \
+	}                                                                     \
+} while (0)
+void da_seg_append_(void** seg, const void* val, size_t sz);
+
+/**
+ * Copies every element into a new dynamic array (see `da_init()`), one
+ * chunk at a time.
+ *
+ * @param	seg	a valid table pointer (MAY be `NULL`)
+ *
+ * @returns	on success	a pointer to an array (`NULL` if `seg` is empty)
+ * @returns	on failure	NULL
+ *
+ * **Errors**
+ * - ENOMEM: Out of memory; set via `da_reserve()`.
+ */
+#define da_seg_to_da(seg)                                                     \
+	((__typeof__(*(seg)))da_seg_to_da_(seg, sizeof(**(seg))))
+void* da_seg_to_da_(void* seg, size_t sz);
+
+/*///////////////////////////////////////////////////////////////////////////*/
+/* Search                                                                    */
+/*///////////////////////////////////////////////////////////////////////////*/
+
+/**
+ * Instruction sets used by `da_find()` and `da_count()`.
+ *
+ * The best one supported by the CPU is detected on first use.
+ */
+enum da_simd {
+	DA_SIMD_NONE,
+	DA_SIMD_SSE2,
+	DA_SIMD_AVX2,
+	DA_SIMD_AVX512
+};
+
+/**
+ * Returns the instruction set used by the search functions.
+ */
+enum da_simd da_simd_level(void);
+
+/**
+ * Limits the instruction set used by the search functions, e.g. to compare
+ * against the scalar code.
+ *
+ * @param	level	the highest level to use; clamped to what the CPU
+ *			supports
+ *
+ * @returns	the level now in use
+ */
+enum da_simd da_set_simd_level(enum da_simd level);
+
+/* how elements are compared: bitwise or as floating point numbers */
+#define DA_KIND_BITS 0
+#define DA_KIND_FLOAT 1
+#define da_kind_(x) (                                                         \
+	__builtin_types_compatible_p(__typeof__(x), float)                    \
+	|| __builtin_types_compatible_p(__typeof__(x), double)                \
+	? DA_KIND_FLOAT : DA_KIND_BITS)
+
+/**
+ * Returns the first element equal to `val`.
+ *
+ * Integers of 1, 2, 4 and 8 bytes, pointers, `float` and `double` are
+ * compared with SIMD instructions (see `da_simd_level()`). Floating point
+ * elements compare with `==`: `-0.0` matches `0.0`, `NaN` matches nothing.
+ * Other types are compared with `memcmp()`, which is wrong for types with
+ * padding (structs, `long double`).
+ *
+ * @param	da	a valid `data pointer` (MAY be `NULL`)
+ * @param	val	the value to look for
+ *
+ * @returns	a pointer to the element
+ * @returns	`NULL` if there is no such element or `da` == `NULL`
+ */
+#define da_find(da, val)                                                      \
+	((__typeof__(da))da_find_(da, &(__typeof__(*(da))){ (val) },          \
+		sizeof(*(da)), da_kind_(*(da))))
+void* da_find_(void* da, const void* val, size_t sz, int kind);
+
+/**
+ * Returns the number of elements equal to `val`.
+ *
+ * @param	da	a valid `data pointer` (MAY be `NULL`)
+ * @param	val	the value to count
+ *
+ * @returns	the number of matching elements (`0` if `da` == `NULL`)
+ *
+ * @see	`da_find()` for how elements are compared
+ */
+#define da_count(da, val)                                                     \
+	da_count_(da, &(__typeof__(*(da))){ (val) }, sizeof(*(da)),           \
+		da_kind_(*(da)))
+size_t da_count_(void* da, const void* val, size_t sz, int kind);
+
+/**
+ * Returns non-zero if an element is equal to `val`.
+ *
+ * @see	`da_find()`
+ */
+#define da_contains(da, val) (da_find(da, val) != NULL)
+
+/*///////////////////////////////////////////////////////////////////////////*/
+/* Reductions and transforms                                                 */
+/*///////////////////////////////////////////////////////////////////////////*/
+
+/*
+ * For arrays of integers (1, 2, 4 or 8 bytes), `float`, `double` and
+ * `long double`. Like the search functions, these use the instruction set
+ * given by `da_simd_level()`. Any other element type sets EINVAL.
+ */
+
+#define DA_KIND_SIGNED 2
+
+/* (internal) how numbers are added and compared */
+#define da_is_float_(x) (                                                     \
+	__builtin_types_compatible_p(__typeof__(x), float)                    \
+	|| __builtin_types_compatible_p(__typeof__(x), double)                \
+	|| __builtin_types_compatible_p(__typeof__(x), long double))
+#define da_is_signed_(x)                                                      \
+	__builtin_choose_expr(da_is_float_(x), 1, (__typeof__(x))-1 < 1)
+#define da_num_kind_(x) (da_is_float_(x) ? DA_KIND_FLOAT                      \
+	: da_is_signed_(x) ? DA_KIND_SIGNED : DA_KIND_BITS)
+
+/**
+ * Returns the sum of the elements.
+ *
+ * Integers are added in 64 bits (`int64_t`, or `uint64_t` if unsigned), so
+ * only arrays of 8 byte integers can overflow, wrapping around. `float` is
+ * added in `double` and `long double` in `long double`; the result is a
+ * `double`. The order of additions is the same at every SIMD level.
+ *
+ * @param	da	a valid `data pointer` (MAY be `NULL`)
+ *
+ * @returns	the sum (`0` if `da` == `NULL`)
+ *
+ * **Errors**
+ * - EINVAL: The elements are not numbers.
+ */
+#define da_sum(da) __builtin_choose_expr(da_is_float_(*(da)),                 \
+	da_sum_f_(da, sizeof(*(da))),                                         \
+	__builtin_choose_expr(da_is_signed_(*(da)),                           \
+		da_sum_i_(da, sizeof(*(da))),                                 \
+		da_sum_u_(da, sizeof(*(da)))))
+int64_t da_sum_i_(void* da, size_t sz);
+uint64_t da_sum_u_(void* da, size_t sz);
+double da_sum_f_(void* da, size_t sz);
+
+/**
+ * Finds the smallest and largest elements in one pass.
+ *
+ * `NaN` elements are skipped, unless every element is `NaN`.
+ *
+ * @param	da	a valid `data pointer` (MAY be `NULL`)
+ * @param	min	receives the smallest element (MAY be `NULL`)
+ * @param	max	receives the largest element (MAY be `NULL`)
+ *
+ * If the array is empty, `*min` and `*max` are unchanged.
+ *
+ * **Errors**
+ * - EINVAL: The elements are not numbers.
+ */
+#define da_minmax(da, min, max)                                               \
+	da_minmax_(da, (1 ? (min) : (da)), (1 ? (max) : (da)), sizeof(*(da)), \
+		da_num_kind_(*(da)))
+void da_minmax_(void* da, void* min, void* max, size_t sz, int kind);
+
+/**
+ * Multiplies every element by `factor`, converted to the element type.
+ *
+ * Integers wrap around on overflow.
+ *
+ * @param	da	a valid `data pointer` (MAY be `NULL`)
+ * @param	factor	the value to multiply by
+ *
+ * **Errors**
+ * - EINVAL: The elements are not numbers.
+ * - ENOMEM: Out of memory copying a shared or mapped array; set via
+ *   `da_reserve()`, the array is unchanged.
+ */
+#define da_scale(da, factor)                                                  \
+	da_scale_((void**)&(da), &(__typeof__(*(da))){ (factor) },            \
+		sizeof(*(da)), da_num_kind_(*(da)))
+void da_scale_(void** da, const void* factor, size_t sz, int kind);
+
+/**
+ * Adds `val`, converted to the element type, to every element.
+ *
+ * Integers wrap around on overflow.
+ *
+ * @param	da	a valid `data pointer` (MAY be `NULL`)
+ * @param	val	the value to add
+ *
+ * **Errors**
+ * - EINVAL: The elements are not numbers.
+ * - ENOMEM: Out of memory copying a shared or mapped array; set via
+ *   `da_reserve()`, the array is unchanged.
+ */
+#define da_add_scalar(da, val)                                                \
+	da_add_scalar_((void**)&(da), &(__typeof__(*(da))){ (val) },          \
+		sizeof(*(da)), da_num_kind_(*(da)))
+void da_add_scalar_(void** da, const void* val, size_t sz, int kind);
+
+/**
+ * Function for `da_map()`.
+ *
+ * @param	elem	pointer to an element of the array, to update in place
+ * @param	ctx	the `ctx` passed to `da_map()`
+ */
+typedef void (*da_mapper)(void* elem, void* ctx);
+
+/**
+ * Calls `fn` on every element, in order, to update it in place.
+ *
+ * If `da` == `NULL`, does nothing.
+ *
+ * @param	da	a valid `data pointer` (MAY be `NULL`)
+ * @param	fn	called once per element
+ * @param	ctx	passed through to `fn` (MAY be `NULL`)
+ *
+ * **Errors**
+ * - ENOMEM: Out of memory copying a shared or mapped array; set via
+ *   `da_reserve()`, the array is unchanged.
+ */
+#define da_map(da, fn, ctx) da_map_((void**)&(da), fn, ctx, sizeof(*(da)))
+void da_map_(void** da, da_mapper fn, void* ctx, size_t sz);
+
+/*///////////////////////////////////////////////////////////////////////////*/
+/* Parallel algorithms                                                       */
+/*///////////////////////////////////////////////////////////////////////////*/
+
+/*
+ * A pool of worker threads, started on first use, runs the functions of this
+ * section over chunks of `DA_PARALLEL_CHUNK` bytes; idle threads steal
+ * chunks from busy ones. Arrays smaller than the threshold (see
+ * `da_parallel_set_threshold()`) are processed on the calling thread, as are
+ * calls made from inside a parallel function. One parallel call runs at a
+ * time, others wait for it.
+ *
+ * Once the pool is running, `da_assign()` also copies large arrays on it.
+ */
+
+/* bytes per chunk, also the unit of `da_parallel_reduce()` */
+#define DA_PARALLEL_CHUNK ((size_t)256 * 1024)
+
+/* default of `da_parallel_set_threshold()` */
+#define DA_PARALLEL_THRESHOLD ((size_t)1024 * 1024)
+
+/**
+ * Sets the number of threads used, including the calling thread. Stops the
+ * current workers, new ones are started on the next parallel call.
+ *
+ * Call with `1` before exiting to join the workers.
+ *
+ * @param	threads	`0` for one per online CPU (the default), `1` to run
+ *			everything on the calling thread
+ */
+void da_parallel_set_threads(size_t threads);
+
+/**
+ * Returns the number of threads used, including the calling thread.
+ *
+ * Starts the pool if it is not running.
+ */
+size_t da_parallel_threads(void);
+
+/**
+ * Sets the size below which arrays are processed on the calling thread.
+ *
+ * @param	bytes	size of an array in bytes (`0` to always use the pool)
+ */
+void da_parallel_set_threshold(size_t bytes);
+
+/**
+ * Function for `da_parallel_for()`.
+ *
+ * @param	first	pointer to the first element of the chunk
+ * @param	cnt	number of elements in the chunk
+ * @param	ctx	the `ctx` passed to `da_parallel_for()`
+ */
+typedef void (*da_range_fn)(void* first, size_t cnt, void* ctx);
+
+/**
+ * Calls `fn` on every chunk of the array, in parallel.
+ *
+ * If `da` == `NULL`, does nothing.
+ *
+ * @param	da	a valid `data pointer` (MAY be `NULL`)
+ * @param	fn	called once per chunk, from any thread
+ * @param	ctx	passed through to `fn` (MAY be `NULL`)
+ */
+#define da_parallel_for(da, fn, ctx)                                          \
+	da_parallel_for_(da, fn, ctx, sizeof(*(da)))
+void da_parallel_for_(void* da, da_range_fn fn, void* ctx, size_t sz);
+
+/**
+ * Function for `da_parallel_reduce()`: Accumulates a chunk of elements into
+ * `acc`, which starts as a copy of the initial value.
+ */
+typedef void (*da_reduce_fn)(
+	const void* first, size_t cnt, void* acc, void* ctx
+);
+
+/**
+ * Function for `da_parallel_reduce()`: Accumulates the result of a chunk
+ * (`partial`) into `acc`.
+ */
+typedef void (*da_combine_fn)(void* acc, const void* partial, void* ctx);
+
+/**
+ * Reduces the array in parallel.
+ *
+ * Every chunk is reduced by `fn` from a copy of `*acc`, which must be the
+ * identity of `combine` (e.g. `0` for a sum). The results are then combined
+ * into `*acc` in the order of the chunks. Chunks only depend on the size of
+ * an element, so the result is the same for any number of threads, even if
+ * `combine` is not associative (floating point addition).
+ *
+ * If `da` == `NULL`, `*acc` is unchanged.
+ *
+ * @param	da	a valid `data pointer` (MAY be `NULL`)
+ * @param	acc	pointer to the initial value, receives the result
+ * @param	fn	called once per chunk, from any thread
+ * @param	combine	called once per chunk, in order, from this thread
+ * @param	ctx	passed through to `fn` and `combine` (MAY be `NULL`)
+ *
+ * **Errors**
+ * - ENOMEM: Out of memory for the results of the chunks, `*acc` is
+ *   unchanged.
+ */
+#define da_parallel_reduce(da, acc, fn, combine, ctx)                         \
+	da_parallel_reduce_(da, acc, sizeof(*(acc)), fn, combine, ctx,        \
+		sizeof(*(da)))
+void da_parallel_reduce_(
+	void* da, void* acc, size_t rsz, da_reduce_fn fn, da_combine_fn combine,
+	void* ctx, size_t sz
+);
+
+/*///////////////////////////////////////////////////////////////////////////*/
+/* Sorting and binary search                                                 */
+/*///////////////////////////////////////////////////////////////////////////*/
+
+/**
+ * Sorts an array of numbers in ascending order: integers (1, 2, 4 or 8
+ * bytes), `float` or `double`.
+ *
+ * Uses an LSD radix sort (stable, one pass per byte of the element, passes
+ * where every element has the same byte are skipped), which allocates a
+ * copy of the array. `-0.0` is sorted before `0.0` and `NaN` at either end,
+ * by its sign bit. For other types, see `DA_DEFINE_SORT()`.
+ *
+ * @param	da	a valid `data pointer` (MAY be `NULL`)
+ *
+ * **Errors**
+ * - EINVAL: The elements are not numbers of a supported size.
+ * - ENOMEM: Out of memory; set via `malloc` or, copying a shared or mapped
+ *   array, `da_reserve()`. The array is unchanged.
+ */
+#define da_sort(da)                                                           \
+	da_sort_((void**)&(da), sizeof(*(da)), da_num_kind_(*(da)))
+void da_sort_(void** da, size_t sz, int kind);
+
+/**
+ * Returns the index of the first element which is not less than `val`, in
+ * an array sorted by `da_sort()`.
+ *
+ * @param	da	a valid `data pointer` (MAY be `NULL`)
+ * @param	val	the value to look for
+ *
+ * @returns	an index between `0` and `da_size(da)`
+ *
+ * **Errors**
+ * - EINVAL: The elements are not numbers of a supported size.
+ */
+#define da_lower_bound(da, val)                                               \
+	da_bound_(da, &(__typeof__(*(da))){ (val) }, sizeof(*(da)),           \
+		da_num_kind_(*(da)), 0)
+
+/**
+ * Returns the index of the first element which is greater than `val`, in
+ * an array sorted by `da_sort()`.
+ *
+ * @see	`da_lower_bound()`
+ */
+#define da_upper_bound(da, val)                                               \
+	da_bound_(da, &(__typeof__(*(da))){ (val) }, sizeof(*(da)),           \
+		da_num_kind_(*(da)), 1)
+size_t da_bound_(void* da, const void* val, size_t sz, int kind, int upper);
+
+/**
+ * Inserts `val` into an array sorted by `da_sort()`, after any equal
+ * elements, keeping it sorted.
+ *
+ * If `da` == `NULL` the array is initialised.
+ *
+ * @param	da	a valid `data pointer` (MAY be `NULL`)
+ * @param	val	the value to insert
+ *
+ * **Errors**
+ * - EINVAL: The elements are not numbers of a supported size.
+ * - ENOMEM: Out of memory; set via `da_insert()`.
+ */
+#define da_insert_sorted(da, val)                                             \
+	da_insert_sorted_((void**)&(da), &(__typeof__(*(da))){ (val) },       \
+		sizeof(*(da)), da_num_kind_(*(da)))
+void da_insert_sorted_(void** da, void* val, size_t sz, int kind);
+
+/**
+ * Defines functions sorting and searching arrays of `type`, ordered by
+ * `less(x, y)`: a macro or function returning non-zero if the element `x`
+ * goes before the element `y`. A macro comparison is inlined, unlike the
+ * comparison function of `qsort`.
+ *
+ * - `void name(type* da)`: Sorts the array in place (introsort: quicksort
+ *   with a median of three pivot, heapsort if the recursion gets too deep,
+ *   insertion sort for short ranges). Not stable.
+ * - `size_t name_lower_bound(const type* da, const type* val)`: Index of
+ *   the first element not less than `*val`.
+ * - `size_t name_upper_bound(const type* da, const type* val)`: Index of
+ *   the first element greater than `*val`.
+ *
+ * For example:
+ *
+ *	#define by_id(x, y) ((x).id < (y).id)
+ *	DA_DEFINE_SORT(sort_by_id, struct item, by_id)
+ *	...
+ *	sort_by_id(items);
+ */
+#define DA_DEFINE_SORT(name, type, less)                                      \
+__attribute__((unused))                                                       \
+static void name##_sift_(type* a, size_t root, size_t n) {                    \
+	type x = a[root];                                                     \
+	size_t child;                                                         \
+                                                                              \
+	while ((child = 2 * root + 1) < n) {                                  \
+		if (child + 1 < n && less(a[child], a[child + 1])) {          \
+			++child;                                              \
+		}                                                             \
+		if (!less(x, a[child])) {                                     \
+			break;                                                \
+		}                                                             \
+		a[root] = a[child];                                           \
+		root = child;                                                 \
+	}                                                                     \
+	a[root] = x;                                                          \
+}                                                                             \
+                                                                              \
+__attribute__((unused))                                                       \
+static void name##_intro_(type* a, size_t n, size_t depth) {                  \
+	type x;                                                               \
+	size_t i, j;                                                          \
+                                                                              \
+	while (n > 16) {                                                      \
+		if (depth-- == 0) {                                           \
+			for (i = n / 2; i-- > 0;) {                           \
+				name##_sift_(a, i, n);                        \
+			}                                                     \
+			for (i = n - 1; i > 0; --i) {                         \
+				x = a[0]; a[0] = a[i]; a[i] = x;              \
+				name##_sift_(a, 0, i);                        \
+			}                                                     \
+			return;                                               \
+		}                                                             \
+                                                                              \
+		/* a[0] <= a[n / 2] <= a[n - 1] stop both scans */            \
+		j = n / 2;                                                    \
+		if (less(a[j], a[0])) { x = a[j]; a[j] = a[0]; a[0] = x; }    \
+		if (less(a[n - 1], a[j])) {                                   \
+			x = a[j]; a[j] = a[n - 1]; a[n - 1] = x;              \
+			if (less(a[j], a[0])) {                               \
+				x = a[j]; a[j] = a[0]; a[0] = x;              \
+			}                                                     \
+		}                                                             \
+                                                                              \
+		{                                                             \
+			type pivot = a[j];                                    \
+			for (i = 0, j = n - 1;; ++i, --j) {                   \
+				while (less(a[i], pivot)) { ++i; }            \
+				while (less(pivot, a[j])) { --j; }            \
+				if (i >= j) { break; }                        \
+				x = a[i]; a[i] = a[j]; a[j] = x;              \
+			}                                                     \
+		}                                                             \
+                                                                              \
+		/* [0, i) and [i, n), recursing into the smaller one */       \
+		if (i < n - i) {                                              \
+			name##_intro_(a, i, depth);                           \
+			a += i;                                               \
+			n -= i;                                               \
+		} else {                                                      \
+			name##_intro_(a + i, n - i, depth);                   \
+			n = i;                                                \
+		}                                                             \
+	}                                                                     \
+                                                                              \
+	for (i = 1; i < n; ++i) {                                             \
+		x = a[i];                                                     \
+		for (j = i; j > 0 && less(x, a[j - 1]); --j) {                \
+			a[j] = a[j - 1];                                      \
+		}                                                             \
+		a[j] = x;                                                     \
+	}                                                                     \
+}                                                                             \
+                                                                              \
+__attribute__((unused))                                                       \
+static void name(type* da) {                                                  \
+	size_t n = da_size((void*)da);                                        \
+	size_t depth = 0;                                                     \
+                                                                              \
+	while (n >>= 1) { depth += 2; }                                       \
+	if (da != NULL) { name##_intro_(da, da_size(da), depth); }            \
+}                                                                             \
+                                                                              \
+__attribute__((unused))                                                       \
+static size_t name##_bound_(const type* da, const type* val, int upper) {     \
+	size_t lo = 0;                                                        \
+	size_t n = da_size((void*)da);                                        \
+	size_t mid;                                                           \
+                                                                              \
+	while (n > 0) {                                                       \
+		mid = lo + n / 2;                                             \
+		if (upper ? !less(*val, da[mid]) : less(da[mid], *val)) {     \
+			lo = mid + 1;                                         \
+			n -= n / 2 + 1;                                       \
+		} else {                                                      \
+			n /= 2;                                               \
+		}                                                             \
+	}                                                                     \
+	return lo;                                                            \
+}                                                                             \
+                                                                              \
+__attribute__((unused))                                                       \
+static size_t name##_lower_bound(const type* da, const type* val) {           \
+	return name##_bound_(da, val, 0);                                     \
+}                                                                             \
+                                                                              \
+__attribute__((unused))                                                       \
+static size_t name##_upper_bound(const type* da, const type* val) {           \
+	return name##_bound_(da, val, 1);                                     \
+}
+
+/*///////////////////////////////////////////////////////////////////////////*/
+/* Streaming I/O                                                             */
+/*///////////////////////////////////////////////////////////////////////////*/
+
+/**
+ * Returns a pointer to the first unused element (at index `da_size(da)`),
+ * after making room for at least `cnt` more elements, so that a producer
+ * (e.g. a decompressor) can write them in place. Follow with `da_commit()`
+ * to add the elements written.
+ *
+ * A deque is made a plain array first, so the spare capacity is contiguous.
+ * The pointer is invalidated by any call which may reallocate.
+ *
+ * If `da` == `NULL` the array is initialised.
+ *
+ * @param	da	a valid `data pointer` (MAY be `NULL`)
+ * @param	cnt	number of elements to make room for
+ *
+ * @returns	on success	a pointer to `da_capacity(da) - da_size(da)`
+ *		(at least `cnt`) unused elements
+ * @returns	on failure	NULL
+ *
+ * **Errors**
+ * - ENOMEM: Out of memory; set via `da_reserve()`.
+ *
+ * @see	`da_commit()`
+ */
+#define da_spare_begin(da, cnt)                                               \
+	((__typeof__(da))da_spare_begin_((void**)&(da), cnt, sizeof(*(da))))
+void* da_spare_begin_(void** da, size_t cnt, size_t sz);
+
+/**
+ * Adds `cnt` elements written past the end of the array (see
+ * `da_spare_begin()`) to its size.
+ *
+ * @param	da	a valid `data pointer` (MAY be `NULL` if `cnt` == `0`)
+ * @param	cnt	number of elements written
+ *
+ * **Errors**
+ * - EINVAL: `cnt` is more than the spare capacity, nothing is added.
+ */
+#define da_commit(da, cnt) da_commit_(da, cnt)
+void da_commit_(void* da, size_t cnt);
+
+/**
+ * `max` for `da_read_fd()`, to read until the end of the file.
+ */
+#define DA_READ_ALL ((size_t)-1)
+
+/**
+ * Bytes of spare capacity `da_read_fd()` reads into at least, when reading
+ * until the end of the file.
+ */
+#define DA_READ_CHUNK ((size_t)64 * 1024)
+
+/**
+ * Reads up to `max` elements from a file descriptor straight into the spare
+ * capacity of the array, appending them; Unlike reading into a buffer and
+ * then `da_append_n()`, the data is copied once.
+ *
+ * Reads until `max` elements have been read or the end of the file, retrying
+ * partial reads (from pipes and sockets) and interrupted calls. For a bounded
+ * `max` the room is reserved once up front; With `DA_READ_ALL` the array
+ * grows as needed, by at least `DA_READ_CHUNK` bytes at a time.
+ *
+ * On failure, the elements read before the error are kept.
+ *
+ * If `da` == `NULL` the array is initialised.
+ *
+ * @param	da	a valid `data pointer` (MAY be `NULL`)
+ * @param	fd	a readable file descriptor, in blocking mode
+ * @param	max	maximum number of elements to read, or `DA_READ_ALL`
+ *
+ * @returns	on success	the number of elements read, `0` at the end of the
+ *		file
+ * @returns	on failure	`-1`
+ *
+ * **Errors**
+ * - Any error of `read`.
+ * - EINVAL: The file ends in the middle of an element (which is dropped).
+ * - ENOMEM: Out of memory; set via `da_reserve()`.
+ */
+#define da_read_fd(da, fd, max)                                               \
+	da_read_fd_((void**)&(da), fd, max, sizeof(*(da)))
+ptrdiff_t da_read_fd_(void** da, int fd, size_t max, size_t sz);
+
+/**
+ * Writes every element, in order, to a file descriptor, retrying partial
+ * writes and interrupted calls.
+ *
+ * @param	da	a valid `data pointer` (MAY be `NULL`)
+ * @param	fd	a writable file descriptor, in blocking mode
+ *
+ * @returns	on success	`0`
+ * @returns	on failure	`-1`
+ *
+ * **Errors**
+ * - Any error of `write`.
+ */
+#define da_write_fd(da, fd) da_write_fd_(da, fd, sizeof(*(da)))
+int da_write_fd_(void* da, int fd, size_t sz);
+
+/*///////////////////////////////////////////////////////////////////////////*/
+/* Persistence                                                               */
+/*///////////////////////////////////////////////////////////////////////////*/
+
+/**
+ * Version of the file format written by `da_save()`.
+ */
+#define DA_FILE_VERSION 1
+
+/**
+ * Writes the array to a file, which `da_mmap()` maps back without copying.
+ *
+ * The file is a header (magic, format version, byte order, element size,
+ * alignment and size) padded to a page, followed by the raw elements in
+ * order. Elements are stored as they are in memory, so the file is only
+ * portable between machines with the same type layouts, and pointers inside
+ * elements are meaningless once reloaded.
+ *
+ * Note: The file is truncated first, which invalidates any mapping of it;
+ * To replace a file which is mapped, save to another path and `rename()`
+ * it over the original.
+ *
+ * @param	da	a valid `data pointer` (MAY be `NULL`)
+ * @param	path	the file to create or overwrite
+ *
+ * @returns	on success	`0`
+ * @returns	on failure	`-1`
+ *
+ * **Errors**
+ * - Any error of `open` or `write`.
+ * - ENOMEM: Out of memory; set via `malloc`.
+ *
+ * @see	`da_mmap()`
+ */
+#define da_save(da, path) da_save_(da, path, sizeof(*(da)))
+int da_save_(void* da, const char* path, size_t sz);
+
+/**
+ * Loads an array saved by `da_save()` by mapping the file read-only, so that
+ * loading takes the same time regardless of its size, and the pages are
+ * read (and shared with other processes mapping the file) on first access.
+ *
+ * The array is used like any other, except that its elements MUST NOT be
+ * written to directly (doing so faults). Functions which would change the
+ * elements in place (`da_erase()`, `da_sort()`, `da_map()`, anything which
+ * grows it, e.g. `da_append()`, ...) copy the array to the heap first, so the
+ * pointer changes; `da_clear()` just drops the mapping for an empty array.
+ * `da_parallel_for()` callbacks and `DA_DEFINE_SORT()` sorts write directly,
+ * see `da_unshare()`. `da_free()` unmaps the file.
+ *
+ * The data pointer is page aligned. Where the file's data is not page aligned
+ * for this system, or there is no `mmap` (non Linux), the file is read into a
+ * regular array instead.
+ *
+ * The file MUST NOT be truncated or modified while mapped.
+ *
+ * @param	path	a file written by `da_save()`
+ * @param	sz	the element size, which must match the saved one
+ *
+ * @returns	on success	a pointer to an array
+ * @returns	on failure	NULL
+ *
+ * **Errors**
+ * - Any error of `open`, `read` or `mmap`.
+ * - EINVAL: Not a saved array, or saved with a different format version,
+ *   byte order or element size, or the file is truncated.
+ * - ENOMEM: Out of memory; set via `malloc`.
+ *
+ * @see	`da_save()`
+ */
+void* da_mmap(const char* path, size_t sz);
+
+/*///////////////////////////////////////////////////////////////////////////*/
+/* Copy-on-write sharing                                                     */
+/*///////////////////////////////////////////////////////////////////////////*/
+
+/**
+ * Adds a holder to the array, without copying it (e.g. a snapshot handed to
+ * reader threads). Returns the same data pointer, which every holder reads
+ * as usual and frees with `da_free()` once done; The last one frees the
+ * array.
+ *
+ * O(1), the first call on an array allocates its reference count (and makes
+ * a deque a plain array).
+ *
+ * While shared the array is read only, and its capacity is its size. Every
+ * function which changes it (`da_append()`, `da_erase()`, `da_reserve()`,
+ * `da_sort()`, `da_map()`, `da_deque_pop_front()`, ...) first gives the
+ * caller a copy of its own, so the pointer changes; `da_clear()` gives it a
+ * new empty array. They work in place once the caller is the last holder.
+ * Elements MUST NOT be written directly (including by `da_parallel_for()`
+ * callbacks and `DA_DEFINE_SORT()` sorts), see `da_unshare()`.
+ *
+ * Holders may read, change and free the array concurrently, from any thread.
+ * The first `da_share()` of an array MUST NOT race with other uses of it.
+ *
+ * @param	da	a valid `data pointer` (MAY be `NULL`)
+ *
+ * @returns	on success	`da`
+ * @returns	on failure	NULL
+ *
+ * **Errors**
+ * - ENOMEM: Out of memory; set via `malloc`.
+ *
+ * @see	`da_unshare()`
+ */
+#define da_share(da) ((__typeof__(da))da_share_(da, sizeof(*(da))))
+void* da_share_(void* da, size_t sz);
+
+/**
+ * Makes the elements writable directly: copies the array if it is shared
+ * with other holders (`da_share()`), or mapped from a file (`da_mmap()`).
+ *
+ * If `da` == `NULL`, does nothing.
+ *
+ * @param	da	a valid `data pointer` (MAY be `NULL`)
+ *
+ * **Errors**
+ * - ENOMEM: Out of memory; set via `da_reserve()`, the array is unchanged.
+ */
+#define da_unshare(da) da_unshare_((void**)&(da), sizeof(*(da)))
+void da_unshare_(void** da, size_t sz);
+
+/*///////////////////////////////////////////////////////////////////////////*/
+/* Struct of arrays                                                          */
+/*///////////////////////////////////////////////////////////////////////////*/
+
+/**
+ * Alignment of every column of a `DA_SOA_DEFINE()` container (a cache line).
+ */
+#define DA_SOA_ALIGN 64
+
+/* (internal) expansions of a field list */
+#define DA_SOA_ROW_(type, field) type field;
+#define DA_SOA_COLUMN_(type, field) type* field;
+#define DA_SOA_SIZE_(type, field) sizeof(type),
+#define DA_SOA_COLS_(type, field) (void*)soa->field,
+#define DA_SOA_UPDATE_(type, field) soa->field = cols_[i_++];
+#define DA_SOA_STORE_(type, field) soa->field[soa->size] = row.field;
+#define DA_SOA_LOAD_(type, field) row.field = soa->field[idx];
+
+/**
+ * Defines a struct of arrays container `name`, from a field list: a macro
+ * taking a macro `X`, and calling it as `X(type, field)` for each field.
+ *
+ * ```c
+ * #define POINT_FIELDS(X) X(float, x) X(float, y) X(int, id)
+ * DA_SOA_DEFINE(points, POINT_FIELDS)
+ * ```
+ *
+ * Defines the types:
+ * - `name_row`: A struct of the fields, i.e. a single row.
+ * - `name`: The container. `size` and `capacity` are in rows, shared by every
+ *   column; And each field is a pointer to the column holding it, aligned to
+ *   `DA_SOA_ALIGN`, which works with any function taking a plain array
+ *   (e.g. `sum(pts.id, pts.size)`). The columns are one allocation, and are
+ *   reallocated together (so the pointers change on growth).
+ *
+ * And the functions:
+ * - `void name_init(name* soa)`: Initialises an empty container (as does
+ *   zero initialisation).
+ * - `void name_free(name* soa)`: Frees the columns (and empties it).
+ * - `int name_reserve(name* soa, size_t cnt)`: Makes room for `cnt` rows.
+ * - `int name_append(name* soa, name_row row)`: Copies the row to the end,
+ *   growing as `da_append()` does.
+ * - `name_row name_get(const name* soa, size_t idx)`: Gathers a row.
+ * - `void name_clear(name* soa)`: Sets the size to `0`.
+ *
+ * `name_reserve()` and `name_append()` return `0` on success, or `-1` with
+ * errno set to ENOMEM (and the container unchanged).
+ */
+#define DA_SOA_DEFINE(name, FIELDS)                                           \
+typedef struct { FIELDS(DA_SOA_ROW_) } name##_row;                            \
+                                                                              \
+typedef struct {                                                              \
+	size_t size;                                                          \
+	size_t capacity;                                                      \
+	void* block_; /* (internal) the allocation holding the columns */     \
+	FIELDS(DA_SOA_COLUMN_)                                                \
+} name;                                                                       \
+                                                                              \
+__attribute__((unused))                                                       \
+static void name##_init(name* soa) {                                          \
+	name empty_ = {0};                                                    \
+	*soa = empty_;                                                        \
+}                                                                             \
+                                                                              \
+__attribute__((unused))                                                       \
+static void name##_free(name* soa) {                                          \
+	da_soa_free_(soa->block_);                                            \
+	name##_init(soa);                                                     \
+}                                                                             \
+                                                                              \
+__attribute__((unused))                                                       \
+static int name##_reserve_(name* soa, size_t cnt, int exact) {                \
+	static const size_t sizes_[] = { FIELDS(DA_SOA_SIZE_) };              \
+	void* cols_[] = { FIELDS(DA_SOA_COLS_) };                             \
+	size_t i_ = 0;                                                        \
+                                                                              \
+	if (da_soa_reserve_(&soa->block_, cols_, sizes_,                      \
+			sizeof(sizes_) / sizeof(*sizes_), soa->size,          \
+			&soa->capacity, cnt, exact) != 0) {                   \
+		return -1;                                                    \
+	}                                                                     \
+	FIELDS(DA_SOA_UPDATE_)                                                \
+	return 0;                                                             \
+}                                                                             \
+                                                                              \
+__attribute__((unused))                                                       \
+static int name##_reserve(name* soa, size_t cnt) {                            \
+	return name##_reserve_(soa, cnt, 1);                                  \
+}                                                                             \
+                                                                              \
+__attribute__((unused))                                                       \
+static int name##_append(name* soa, name##_row row) {                         \
+	if (soa->size == soa->capacity                                        \
+			&& name##_reserve_(soa, soa->size + 1, 0) != 0) {     \
+		return -1;                                                    \
+	}                                                                     \
+	FIELDS(DA_SOA_STORE_)                                                 \
+	++soa->size;                                                          \
+	return 0;                                                             \
+}                                                                             \
+                                                                              \
+__attribute__((unused))                                                       \
+static name##_row name##_get(const name* soa, size_t idx) {                   \
+	name##_row row;                                                       \
+	FIELDS(DA_SOA_LOAD_)                                                  \
+	return row;                                                           \
+}                                                                             \
+                                                                              \
+__attribute__((unused))                                                       \
+static void name##_clear(name* soa) {                                         \
+	soa->size = 0;                                                        \
+}
+
+/**
+ * (internal) Makes room for `cnt` rows of the columns `cols`, whose elements
+ * are `sizes` bytes: exactly, or by the default growth policy. Updates `cols`,
+ * `block` and `capacity`.
+ *
+ * @returns	on success	`0`
+ * @returns	on failure	`-1`, with errno set to ENOMEM
+ */
+int da_soa_reserve_(
+	void** block, void** cols, const size_t* sizes, size_t ncols,
+	size_t size, size_t* capacity, size_t cnt, int exact
+);
+
+/** (internal) Frees the columns of a container (MAY be `NULL`). */
+void da_soa_free_(void* block);
+
+/*///////////////////////////////////////////////////////////////////////////*/
+/* Bit arrays                                                                */
+/*///////////////////////////////////////////////////////////////////////////*/
+
+/*
+ * A `uint64_t` data pointer holds a packed array of bits (flags), 64 to a
+ * word: bit `idx` is bit `idx % 64` of word `idx / 64`. It starts as `NULL`
+ * and is freed with `da_free()`, like any array, but `da_size()` is in bits
+ * (and `da_capacity()` in words). Bits past the size are always `0`, so
+ * whole words can be read up to `DA_BITS_WORDS(da_size(bits))`.
+ *
+ * Only the functions of this section, `da_free()`, `da_size()`,
+ * `da_capacity()` and `da_clear()` may be used on a bit array; It MUST NOT
+ * be shared (`da_share()`) or saved (`da_save()`).
+ */
+
+/** Number of words holding `cnt` bits. */
+#define DA_BITS_WORDS(cnt) (((cnt) + 63) / 64)
+
+/**
+ * Returns bit `idx` of the array, as `0` or `1`.
+ *
+ * @param	bits	a valid `data pointer`
+ * @param	idx	index into the array (MUST be < `da_size(bits)`)
+ */
+#define da_bits_get(bits, idx)                                                \
+	((int)((bits)[(size_t)(idx) / 64] >> ((size_t)(idx) % 64) & 1))
+
+/**
+ * Sets bit `idx` of the array to `val` != `0`.
+ *
+ * @param	bits	a valid `data pointer`
+ * @param	idx	index into the array (MUST be < `da_size(bits)`)
+ * @param	val	the value of the bit
+ */
+#define da_bits_set(bits, idx, val)                                           \
+do {                                                                          \
+	size_t i_ = (idx);                                                    \
+	uint64_t m_ = (uint64_t)1 << (i_ % 64);                               \
+	if (val) {                                                            \
+		(bits)[i_ / 64] |= m_;                                        \
+	} else {                                                              \
+		(bits)[i_ / 64] &= ~m_;                                       \
+	}                                                                     \
+} while (0)
+
+/**
+ * Appends a bit (`val` != `0`) to the end of the array, reallocating a word
+ * at a time by the growth policy.
+ *
+ * If `bits` == `NULL` the array is initialised.
+ *
+ * @param	bits	a valid `data pointer` (MAY be `NULL`)
+ * @param	val	the value of the bit
+ *
+ * **Errors**
+ * - ENOMEM: Out of memory; set via `da_reserve()`.
+ */
+#define da_bits_append(bits, val)                                             \
+do {                                                                          \
+	uint64_t tmp = (val) != 0;                                            \
+	if ((bits) != NULL && da_var_size(bits) % 64 != 0) {                  \
+		size_t len = da_var_size(bits);                               \
+		(bits)[len / 64] |= tmp << (len % 64);                        \
+		da_var_size(bits) = len + 1;                                  \
+	} else {                                                              \
+		da_bits_append_(&(bits), (int)tmp);                           \
+	}                                                                     \
+} while (0)
+void da_bits_append_(uint64_t** bits, int val);
+
+/**
+ * Changes the number of bits to `cnt`: New bits are `0`, reallocating at
+ * most once (exactly, as `da_reserve()`). Shrinking keeps the capacity.
+ *
+ * If `bits` == `NULL` the array is initialised.
+ *
+ * @param	bits	a valid `data pointer` (MAY be `NULL`)
+ * @param	cnt	the new number of bits
+ *
+ * **Errors**
+ * - ENOMEM: Out of memory; set via `da_reserve()`, the array is unchanged.
+ */
+#define da_bits_resize(bits, cnt) da_bits_resize_(&(bits), cnt)
+void da_bits_resize_(uint64_t** bits, size_t cnt);
+
+/**
+ * Sets the bits in the range [`first`, `last`) to `val` != `0`, whole words
+ * at a time.
+ *
+ * If `bits` == `NULL`, does nothing.
+ * If `first` >= `last` or `first` >= `da_size(bits)`, does nothing.
+ * If `last` > `da_size(bits)`, the range ends at `da_size(bits)`.
+ *
+ * @param	bits	a valid `data pointer` (MAY be `NULL`)
+ * @param	first	index of the first bit to set
+ * @param	last	index one past the last bit to set
+ * @param	val	the value of the bits
+ */
+void da_bits_set_range(uint64_t* bits, size_t first, size_t last, int val);
+
+/**
+ * Returns the number of bits set, counted with the instruction set given by
+ * `da_simd_level()`.
+ *
+ * @param	bits	a valid `data pointer` (MAY be `NULL`)
+ */
+size_t da_bits_popcount(const uint64_t* bits);
+
+/**
+ * Returns the index of the first bit set at or after `from`, or
+ * `da_size(bits)` if there is none. Skips `0` words with the instruction set
+ * given by `da_simd_level()`.
+ *
+ * @param	bits	a valid `data pointer` (MAY be `NULL`)
+ * @param	from	index of the first bit to look at
+ */
+size_t da_bits_find(const uint64_t* bits, size_t from);
+
+/**
+ * `dst` = `dst` AND `src`, a word at a time, over the first
+ * `min(da_size(dst), da_size(src))` bits. The rest of `dst` is unchanged.
+ *
+ * If either array is `NULL`, does nothing.
+ *
+ * @param	dst	a valid `data pointer` (MAY be `NULL`)
+ * @param	src	a valid `data pointer` (MAY be `NULL`, or `dst`)
+ */
+void da_bits_and(uint64_t* dst, const uint64_t* src);
+
+/** `dst` = `dst` OR `src`, as `da_bits_and()`. */
+void da_bits_or(uint64_t* dst, const uint64_t* src);
+
+/** `dst` = `dst` XOR `src`, as `da_bits_and()`. */
+void da_bits_xor(uint64_t* dst, const uint64_t* src);
+
 #endif /* DA_H */
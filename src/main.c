@@ -1,8 +1,14 @@
 #include <assert.h>
+#include <errno.h>
 #include <inttypes.h>
+#include <limits.h>
+#include <math.h>
+#include <pthread.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 #include "da.h"
 
@@ -27,17 +33,95 @@ do {                                                                          \
 } while (0)
 
 int64_t sum_array(int* arr, size_t count);
+int is_char_in(const void* elem, void* ctx);
+size_t resident_bytes(void);
+
+void double_and_count(void* elem, void* ctx);
+void fill_index(void* first, size_t cnt, void* ctx);
+void sum_ints(const void* first, size_t cnt, void* acc, void* ctx);
+void sum_reals(const void* first, size_t cnt, void* acc, void* ctx);
+void add_int64(void* acc, const void* partial, void* ctx);
+void add_double(void* acc, const void* partial, void* ctx);
+void nested_reduce(void* first, size_t cnt, void* ctx);
+int compare_keys(const void* a, const void* b);
+void* cache_churn(void* arg);
+void* conc_produce(void* arg);
+void* conc_observe(void* arg);
+void* pipe_write(void* arg);
+void* shared_read(void* arg);
+
+/* `da_allocator` which counts calls, `ctx` points to the counters */
+struct alloc_counts {
+	size_t alloc;
+	size_t resize;
+	size_t release;
+	size_t live_bytes;
+};
+void* counting_alloc(const da_allocator* self, size_t bytes);
+void* counting_resize(const da_allocator* self, void* ptr, size_t old_bytes,
+	size_t new_bytes);
+void counting_release(const da_allocator* self, void* ptr, size_t bytes);
+
+/* `da_allocator` returning blocks `(size_t)ctx` bytes past malloc's */
+void* shifted_alloc(const da_allocator* self, size_t bytes);
+void* shifted_resize(const da_allocator* self, void* ptr, size_t old_bytes,
+	size_t new_bytes);
+void shifted_release(const da_allocator* self, void* ptr, size_t bytes);
+
+/* `da_allocator` failing once `*(size_t*)ctx` allocations have been made */
+void* budget_alloc(const da_allocator* self, size_t bytes);
+void* budget_resize(const da_allocator* self, void* ptr, size_t old_bytes,
+	size_t new_bytes);
+void budget_release(const da_allocator* self, void* ptr, size_t bytes);
 
 void test_1(void);
 void test_2(void);
 void test_3(void);
 void test_4(void);
+void test_5(void);
+void test_6(void);
+void test_7(void);
+void test_8(void);
+void test_9(void);
+void test_10(void);
+void test_11(void);
+void test_12(void);
+void test_13(void);
+void test_14(void);
+void test_15(void);
+void test_16(void);
+void test_17(void);
+void test_18(void);
+void test_19(void);
+void test_20(void);
+void test_21(void);
+void test_22(void);
+void test_23(void);
 
 int main(void) {
 	test_1();
 	test_2();
 	test_3();
 	test_4();
+	test_5();
+	test_6();
+	test_7();
+	test_8();
+	test_9();
+	test_10();
+	test_11();
+	test_12();
+	test_13();
+	test_14();
+	test_15();
+	test_16();
+	test_17();
+	test_18();
+	test_19();
+	test_20();
+	test_21();
+	test_22();
+	test_23();
 
 	return 0;
 }
@@ -50,6 +134,249 @@ int64_t sum_array(int* arr, size_t count) {
 	return sum;
 }
 
+/* `da_predicate`: `ctx` is a string of characters to match */
+int is_char_in(const void* elem, void* ctx) {
+	return strchr(ctx, *(const char*)elem) != NULL;
+}
+
+/* `da_mapper`: doubles an `int`, `ctx` counts the calls */
+void double_and_count(void* elem, void* ctx) {
+	*(int*)elem *= 2;
+	++*(size_t*)ctx;
+}
+
+/* `da_range_fn`: sets `int`s to their index, `ctx` is the array */
+void fill_index(void* first, size_t cnt, void* ctx) {
+	int* p = first;
+	for (size_t i = 0; i < cnt; ++i) {
+		p[i] = (int)(p + i - (int*)ctx);
+	}
+}
+
+/* `da_reduce_fn`: adds `int`s into an `int64_t` */
+void sum_ints(const void* first, size_t cnt, void* acc, void* ctx) {
+	(void)ctx;
+	*(int64_t*)acc += sum_array((int*)first, cnt);
+}
+
+/* `da_reduce_fn`: adds `double`s */
+void sum_reals(const void* first, size_t cnt, void* acc, void* ctx) {
+	const double* p = first;
+	(void)ctx;
+	for (size_t i = 0; i < cnt; ++i) {
+		*(double*)acc += p[i];
+	}
+}
+
+/* `da_combine_fn`s */
+void add_int64(void* acc, const void* partial, void* ctx) {
+	(void)ctx;
+	*(int64_t*)acc += *(const int64_t*)partial;
+}
+
+void add_double(void* acc, const void* partial, void* ctx) {
+	(void)ctx;
+	*(double*)acc += *(const double*)partial;
+}
+
+/* `da_range_fn`: a parallel call from inside one, `ctx` is an `int` array */
+void nested_reduce(void* first, size_t cnt, void* ctx) {
+	int64_t sum = 0;
+	da_parallel_reduce((int*)ctx, &sum, sum_ints, add_int64, NULL);
+	assert(sum == 4950);
+	(void)first;
+	(void)cnt;
+}
+
+/* for `DA_DEFINE_SORT()` */
+struct keyed {
+	int key;
+	int order; /* position before sorting */
+};
+#define by_key(x, y) ((x).key < (y).key)
+DA_DEFINE_SORT(sort_keyed, struct keyed, by_key)
+
+/* for `DA_SOA_DEFINE()` */
+#define PARTICLE_FIELDS(X) X(double, x) X(float, mass) X(int, id) X(char, tag)
+DA_SOA_DEFINE(particles, PARTICLE_FIELDS)
+
+/* `qsort` comparison of `struct keyed` */
+int compare_keys(const void* a, const void* b) {
+	const struct keyed* x = a;
+	const struct keyed* y = b;
+	return (x->key > y->key) - (x->key < y->key);
+}
+
+/* creates and frees arrays, leaving blocks in the thread's cache */
+void* cache_churn(void* arg) {
+	int64_t* sum = arg;
+
+	for (int n = 0; n < 100; ++n) {
+		int* arr = NULL;
+		for (int i = 0; i < 100; ++i) {
+			da_append(arr, i);
+		}
+		*sum += sum_array(arr, da_size(arr));
+		da_free(arr);
+	}
+
+	return NULL;
+}
+
+/* appends `CONC_PER_THREAD` tagged values to a `da_conc` */
+#define CONC_THREADS 8
+#define CONC_PER_THREAD 20000
+
+struct conc_producer {
+	da_conc* conc;
+	uint64_t id;
+};
+
+void* conc_produce(void* arg) {
+	struct conc_producer* p = arg;
+
+	/* odd producers append in batches, spanning segments */
+	for (uint64_t i = 0; i < CONC_PER_THREAD; ) {
+		uint64_t vals[7];
+		uint64_t n = p->id % 2 == 0 ? 1 : 7;
+		if (n > CONC_PER_THREAD - i) { n = CONC_PER_THREAD - i; }
+		for (uint64_t j = 0; j < n; ++j) {
+			vals[j] = (p->id << 32) | (i + j + 1);
+		}
+		if (n == 1) {
+			assert(da_conc_append(p->conc, vals) == 0);
+		} else {
+			assert(da_conc_append_n(p->conc, vals, n) == 0);
+		}
+		i += n;
+	}
+
+	return NULL;
+}
+
+/* checks that the published prefix only grows, and is fully written */
+void* conc_observe(void* arg) {
+	da_conc* conc = arg;
+	size_t total = CONC_THREADS * CONC_PER_THREAD;
+	size_t last = 0;
+
+	while (last < total) {
+		size_t n = da_conc_size(conc);
+		assert(n >= last && n <= total);
+		for (size_t i = last; i < n; ++i) {
+			uint64_t* val = da_conc_at(conc, i);
+			assert(val != NULL && (*val & 0xffffffff) != 0);
+		}
+		assert(da_conc_at(conc, n) == NULL || n < da_conc_size(conc));
+		last = n;
+	}
+
+	return NULL;
+}
+
+/* writes an array to the write end of a pipe, then closes it */
+struct pipe_writer {
+	int fd;
+	int* arr;
+};
+
+void* pipe_write(void* arg) {
+	struct pipe_writer* w = arg;
+	assert(da_write_fd(w->arr, w->fd) == 0);
+	close(w->fd);
+	return NULL;
+}
+
+/* sums a shared `int` array of 0..n-1, then drops the reference */
+void* shared_read(void* arg) {
+	int* arr = arg;
+	int64_t n = (int64_t)da_size(arr);
+	assert(sum_array(arr, da_size(arr)) == n * (n - 1) / 2);
+	da_free(arr);
+	return NULL;
+}
+
+/* resident set size of the process, `0` if unknown */
+size_t resident_bytes(void) {
+	size_t pages = 0;
+	FILE* f = fopen("/proc/self/statm", "r");
+	if (f == NULL) {
+		return 0;
+	}
+	if (fscanf(f, "%*s %zu", &pages) != 1) {
+		pages = 0;
+	}
+	fclose(f);
+	return pages * 4096;
+}
+
+void* counting_alloc(const da_allocator* self, size_t bytes) {
+	struct alloc_counts* counts = self->ctx;
+	++counts->alloc;
+	counts->live_bytes += bytes;
+	return malloc(bytes);
+}
+
+void* counting_resize(const da_allocator* self, void* ptr, size_t old_bytes,
+	size_t new_bytes) {
+	struct alloc_counts* counts = self->ctx;
+	++counts->resize;
+	counts->live_bytes += new_bytes - old_bytes;
+	return realloc(ptr, new_bytes);
+}
+
+void counting_release(const da_allocator* self, void* ptr, size_t bytes) {
+	struct alloc_counts* counts = self->ctx;
+	++counts->release;
+	counts->live_bytes -= bytes;
+	free(ptr);
+}
+
+void* shifted_alloc(const da_allocator* self, size_t bytes) {
+	size_t shift = (size_t)self->ctx;
+	char* ptr = malloc(bytes + shift);
+	return ptr == NULL ? NULL : ptr + shift;
+}
+
+void* shifted_resize(const da_allocator* self, void* ptr, size_t old_bytes,
+	size_t new_bytes) {
+	size_t shift = (size_t)self->ctx;
+	char* tmp = realloc((char*)ptr - shift, new_bytes + shift);
+	(void)old_bytes;
+	return tmp == NULL ? NULL : tmp + shift;
+}
+
+void shifted_release(const da_allocator* self, void* ptr, size_t bytes) {
+	(void)bytes;
+	free((char*)ptr - (size_t)self->ctx);
+}
+
+void* budget_alloc(const da_allocator* self, size_t bytes) {
+	size_t* left = self->ctx;
+	if (*left == 0) {
+		return NULL;
+	}
+	--*left;
+	return malloc(bytes);
+}
+
+void* budget_resize(const da_allocator* self, void* ptr, size_t old_bytes,
+	size_t new_bytes) {
+	size_t* left = self->ctx;
+	(void)old_bytes;
+	if (*left == 0) {
+		return NULL;
+	}
+	--*left;
+	return realloc(ptr, new_bytes);
+}
+
+void budget_release(const da_allocator* self, void* ptr, size_t bytes) {
+	(void)self;
+	(void)bytes;
+	free(ptr);
+}
+
 void test_1(void) {
 	printf("== Test 1 : Demonstration. ===============================\n");
 	int* arr = NULL;
@@ -137,6 +464,18 @@ void test_2(void) {
 	PRINT_ARRAY("'%c'", arr);
 	assert(memcmp(arr, "A12B34C", 7) == 0);
 
+	printf("-- da_insert_n; ------------------------------------------\n");
+	da_insert_n(arr, 1, "xyz", 3);
+	DEBUG_DUMP(arr);
+	PRINT_ARRAY("'%c'", arr);
+	assert(memcmp(arr, "Axyz12B34C", 10) == 0);
+
+	printf("-- da_erase_range; ---------------------------------------\n");
+	da_erase_range(arr, 1, 4);
+	DEBUG_DUMP(arr);
+	PRINT_ARRAY("'%c'", arr);
+	assert(memcmp(arr, "A12B34C", 7) == 0);
+
 	printf("-- da_erase; ---------------------------------------------\n");
 	for (size_t i = 0; i < da_size(arr); /**/) {
 		if (arr[i] == '2' || arr[i] == '3') {
@@ -149,6 +488,39 @@ void test_2(void) {
 	PRINT_ARRAY("'%c'", arr);
 	assert(memcmp(arr, "A1B4C", 5) == 0);
 
+	printf("-- da_append_n; ------------------------------------------\n");
+	da_append_n(arr, "DEFGHIJKLMNOPQRSTUVWXYZ", 23);
+	DEBUG_DUMP(arr);
+	PRINT_ARRAY("'%c'", arr);
+	assert(da_size(arr) == 28);
+	assert(memcmp(arr, "A1B4CDEFGHIJKLMNOPQRSTUVWXYZ", 28) == 0);
+
+	printf("-- da_erase_range; (clamped) -----------------------------\n");
+	da_erase_range(arr, 5, 69);
+	DEBUG_DUMP(arr);
+	PRINT_ARRAY("'%c'", arr);
+	assert(memcmp(arr, "A1B4C", 5) == 0);
+	assert(da_size(arr) == 5);
+
+	printf("-- da_remove_if; -----------------------------------------\n");
+	size_t removed = da_remove_if(arr, is_char_in, "0123456789");
+	DEBUG_DUMP(arr);
+	PRINT_ARRAY("'%c'", arr);
+	assert(removed == 2);
+	assert(da_size(arr) == 3);
+	assert(memcmp(arr, "ABC", 3) == 0);
+
+	printf("-- da_swap_remove; ---------------------------------------\n");
+	da_swap_remove(arr, 0);
+	DEBUG_DUMP(arr);
+	PRINT_ARRAY("'%c'", arr);
+	assert(memcmp(arr, "CB", 2) == 0);
+	da_swap_remove(arr, 1);
+	assert(memcmp(arr, "C", 1) == 0);
+	assert(da_size(arr) == 1);
+
+	da_assign(arr, "A1B4C", 5);
+
 	printf("-- printf; (%%.*s) ---------------------------------------\n");
 	printf("`%.*s`\n", (int)da_size(arr), arr);
 
@@ -207,6 +579,16 @@ void test_3(void) {
 	assert(memcmp(arr, "A", 1) == 0);
 	da_insert(arr, 69, 'A'); /* out of bounds */
 	assert(da_size(arr) == 1);
+	da_free(arr);
+
+	printf("-- da_insert_n; ------------------------------------------\n");
+	assert(arr == NULL);
+	da_insert_n(arr, 0, "AB", 2); /* arr == NULL */
+	assert(memcmp(arr, "AB", 2) == 0);
+	da_insert_n(arr, 69, "AB", 2); /* out of bounds */
+	assert(da_size(arr) == 2);
+	da_erase(arr, 1);
+	assert(da_size(arr) == 1);
 
 	printf("-- da_erase; ---------------------------------------------\n");
 	da_erase(arr, 69); /* out of bounds */
@@ -214,9 +596,35 @@ void test_3(void) {
 	da_free(arr);
 	da_erase(arr, 0); /* arr == NULL */
 
+	printf("-- da_erase_range; ---------------------------------------\n");
+	da_erase_range(arr, 0, 1); /* arr == NULL */
+	assert(arr == NULL);
+	da_append(arr, 'x');
+	da_erase_range(arr, 1, 0); /* empty range */
+	da_erase_range(arr, 69, 70); /* out of bounds */
+	assert(da_size(arr) == 1);
+	da_free(arr);
+
+	printf("-- da_swap_remove; ---------------------------------------\n");
+	da_swap_remove(arr, 0); /* arr == NULL */
+	assert(arr == NULL);
+	da_append(arr, 'x');
+	da_swap_remove(arr, 69); /* out of bounds */
+	assert(da_size(arr) == 1);
+	da_free(arr);
+
+	printf("-- da_remove_if; -----------------------------------------\n");
+	assert(da_remove_if(arr, is_char_in, "x") == 0); /* arr == NULL */
+	assert(arr == NULL);
+
 	printf("-- da_append; --------------------------------------------\n");
 	da_append(arr, 'x');
 	assert(memcmp(arr, "x", 1) == 0);
+	da_free(arr);
+
+	printf("-- da_append_n; ------------------------------------------\n");
+	da_append_n(arr, "xyz", 3); /* arr == NULL */
+	assert(memcmp(arr, "xyz", 3) == 0);
 
 	printf("\n");
 	da_free(arr);
@@ -231,6 +639,22 @@ do {                                                                          \
 	da_free(arr);                                                         \
 } while (0)
 
+#define align_test_over(type, align)                                          \
+do {                                                                          \
+	type* arr = da_init_aligned(sizeof(type), align);                     \
+	assert(arr != NULL);                                                  \
+	for (int i = 0; i < 1000; ++i) {                                      \
+		da_append(arr, i);                                            \
+		assert((uintptr_t)arr % (align) == 0);                        \
+	}                                                                     \
+	da_reserve(arr, 10000);                                               \
+	assert((uintptr_t)arr % (align) == 0);                                \
+	for (int i = 0; i < 1000; ++i) {                                      \
+		assert(arr[i] == (type)i);                                    \
+	}                                                                     \
+	da_free(arr);                                                         \
+} while (0)
+
 void test_4(void) {
 	printf("== Test 4 : Alignment. ===================================\n");
 	printf("\n");
@@ -249,4 +673,1585 @@ void test_4(void) {
 	align_test(long long);
 	printf("-- long double; ------------------------------------------\n");
 	align_test(long double);
+
+	printf("-- da_init_aligned; --------------------------------------\n");
+	for (size_t align = 1; align <= DA_ALIGN_MAX; align *= 2) {
+		align_test_over(char, align);
+		align_test_over(int, align);
+		align_test_over(double, align);
+		align_test_over(long double, align);
+	}
+	assert(da_init_aligned(sizeof(int), 0) == NULL);
+	assert(da_init_aligned(sizeof(int), 48) == NULL);
+	assert(da_init_aligned(sizeof(int), DA_ALIGN_MAX * 2) == NULL);
+}
+
+void test_5(void) {
+	printf("== Test 5 : Allocators. ==================================\n");
+
+	printf("-- da_init_with; (counting) ------------------------------\n");
+	struct alloc_counts counts = {0};
+	da_allocator counting = {
+		counting_alloc, counting_resize, counting_release, &counts, NULL
+	};
+	int* arr = da_init_with(sizeof(*arr), &counting);
+	assert(counts.alloc == 1);
+	for (int i = 0; i < 1000; ++i) {
+		da_append(arr, i);
+	}
+	da_insert_n(arr, 0, ((int[]){-1, -2, -3}), 3);
+	assert(da_size(arr) == 1003);
+	assert(arr[0] == -1 && arr[3] == 0 && arr[1002] == 999);
+	assert(counts.alloc == 1);
+	assert(counts.resize > 0);
+	DEBUG_DUMP(arr);
+	printf("resizes  == %zu\n", counts.resize);
+	da_free(arr);
+	assert(counts.release == 1);
+	assert(counts.live_bytes == 0);
+
+	printf("-- da_init_with; (default) -------------------------------\n");
+	arr = da_init_with(sizeof(*arr), &da_malloc_allocator);
+	da_append(arr, 69);
+	da_reserve(arr, 100);
+	assert(arr[0] == 69);
+	da_free(arr);
+	arr = da_init_with(sizeof(*arr), NULL);
+	da_append(arr, 69);
+	assert(arr[0] == 69);
+	da_free(arr);
+
+	printf("-- da_arena; ---------------------------------------------\n");
+	da_arena arena;
+	da_arena_init(&arena, 256);
+	int* a = da_init_with(sizeof(*a), &arena.allocator);
+	long double* b = da_init_with(sizeof(*b), &arena.allocator);
+	for (int i = 0; i < 100; ++i) {
+		da_append(a, i);
+		da_append(b, i);
+	}
+	DEBUG_DUMP(a);
+	DEBUG_DUMP(b);
+	assert(((uintptr_t)b & (__alignof__(long double) - 1)) == 0);
+	assert(sum_array(a, da_size(a)) == 4950);
+	assert(b[99] == 99);
+	da_free(b); /* most recent, given back */
+	da_free(a);
+
+	da_arena_reset(&arena);
+	a = da_init_with(sizeof(*a), &arena.allocator);
+	da_assign(a, ((int[]){1, 2, 3}), 3);
+	assert(sum_array(a, da_size(a)) == 6);
+	da_arena_release(&arena);
+	assert(arena.head == NULL);
+}
+
+void test_6(void) {
+	printf("== Test 6 : Growth policy. ===============================\n");
+
+	printf("-- da_set_growth; ----------------------------------------\n");
+	da_growth doubling = { 2, 2, 1, 0, DA_ROUND_NONE, 0, 0 };
+	int* arr = da_init(sizeof(*arr));
+	da_set_growth(arr, &doubling);
+	for (int i = 0; i < 100; ++i) {
+		da_append(arr, i);
+		size_t cap = da_capacity(arr);
+		assert((cap & (cap - 1)) == 0); /* 2, 4, 8, ... */
+	}
+	DEBUG_DUMP(arr);
+	assert(sum_array(arr, da_size(arr)) == 4950);
+	da_set_growth(arr, NULL);
+	assert(da_capacity(arr) == 128);
+	while (da_size(arr) <= 128) {
+		da_append(arr, 0);
+	}
+	assert(da_capacity(arr) == 128 * 3 / 2 + 8);
+	da_free(arr);
+	da_set_growth(arr, &doubling); /* arr == NULL */
+
+	printf("-- da_set_default_growth; --------------------------------\n");
+	da_growth big_start = { 64, 3, 2, 8, DA_ROUND_NONE, 0, 0 };
+	da_set_default_growth(&big_start);
+	da_append(arr, 69);
+	assert(da_capacity(arr) == 64);
+	da_free(arr);
+	da_set_default_growth(NULL);
+	da_append(arr, 69);
+	assert(da_capacity(arr) == 2);
+	da_free(arr);
+
+	printf("-- DA_ROUND_PAGE; ----------------------------------------\n");
+	da_growth paged = { 2, 3, 2, 8, DA_ROUND_PAGE, 0, 0 };
+	arr = da_init(sizeof(*arr));
+	da_set_growth(arr, &paged);
+	for (int i = 0; i < 10000; ++i) {
+		da_append(arr, i);
+	}
+	DEBUG_DUMP(arr);
+	/* capacity fills whole pages (less the header) */
+	assert(da_capacity(arr) % 1024 > 1000);
+	assert(arr[9999] == 9999);
+	da_free(arr);
+
+	printf("-- DA_ROUND_SIZE_CLASS; ----------------------------------\n");
+	da_growth classes = { 2, 3, 2, 8, DA_ROUND_SIZE_CLASS, 0, 0 };
+	char* str = da_init(sizeof(*str));
+	da_set_growth(str, &classes);
+	for (int i = 0; i < 10000; ++i) {
+		da_append(str, 'x');
+	}
+	DEBUG_DUMP(str);
+	assert(da_size(str) == 10000);
+	da_free(str);
+
+	printf("-- usable_size; ------------------------------------------\n");
+	da_growth slack = { 2, 3, 2, 8, DA_ROUND_NONE, 1, 0 };
+	da_set_default_growth(&slack);
+	str = da_init(sizeof(*str));
+	DEBUG_DUMP(str);
+	assert(da_capacity(str) >= 2);
+	da_reserve(str, 1000);
+	assert(da_capacity(str) >= 1000);
+	for (int i = 0; i < 5000; ++i) {
+		da_append(str, 'x');
+	}
+	memset(str, 'y', da_capacity(str)); /* all of it must be usable */
+	da_free(str);
+	da_set_default_growth(NULL);
+}
+
+void test_7(void) {
+	printf("== Test 7 : Large arrays. ================================\n");
+
+	printf("-- da_mmap_allocator; ------------------------------------\n");
+	double* arr = da_init_with(sizeof(*arr), &da_mmap_allocator);
+	for (int i = 0; i < 1000 * 1000; ++i) {
+		da_append(arr, i);
+	}
+	DEBUG_DUMP(arr);
+	assert(arr[0] == 0 && arr[999999] == 999999);
+	da_reserve(arr, 16); /* never below the size */
+	assert(da_capacity(arr) == 1000 * 1000 && arr[999999] == 999999);
+	da_erase_range(arr, 16, da_size(arr));
+	da_reserve(arr, 16);
+	assert(da_capacity(arr) == 16 && arr[15] == 15);
+	da_free(arr);
+
+	printf("-- da_set_mmap_threshold; --------------------------------\n");
+	da_set_mmap_threshold(1024 * 1024, 0);
+	char* str = NULL;
+	for (int i = 0; i < 4 * 1024 * 1024; ++i) {
+		da_append(str, 'a' + i % 26);
+	}
+	DEBUG_DUMP(str);
+	for (int i = 0; i < 4 * 1024 * 1024; ++i) {
+		assert(str[i] == 'a' + i % 26);
+	}
+	da_free(str);
+
+	/* alignment survives the move */
+	int* ints = da_init_aligned(sizeof(*ints), 64);
+	for (int i = 0; i < 1024 * 1024; ++i) {
+		da_append(ints, i);
+		assert((uintptr_t)ints % 64 == 0);
+	}
+	assert(ints[1024 * 1024 - 1] == 1024 * 1024 - 1);
+	da_free(ints);
+
+	printf("-- da_set_mmap_threshold; (huge pages) -------------------\n");
+	da_set_mmap_threshold(1024 * 1024, 1);
+	da_reserve(str, 8 * 1024 * 1024);
+	memset(str, 'x', da_capacity(str));
+	da_append(str, 'y');
+	DEBUG_DUMP(str);
+	assert(str[0] == 'y');
+	da_free(str);
+
+	da_set_mmap_threshold(64 * 1024 * 1024, 0);
+}
+
+void test_8(void) {
+	printf("== Test 8 : Shrinking. ===================================\n");
+
+	printf("-- da_shrink_to_fit; -------------------------------------\n");
+	int* arr = NULL;
+	da_shrink_to_fit(arr); /* arr == NULL */
+	assert(arr == NULL);
+	da_assign(arr, ((int[]){1, 2, 3}), 3);
+	da_reserve(arr, 1000);
+	da_shrink_to_fit(arr);
+	DEBUG_DUMP(arr);
+	assert(da_capacity(arr) == 3);
+	assert(sum_array(arr, da_size(arr)) == 6);
+	da_clear(arr);
+	da_shrink_to_fit(arr);
+	assert(da_capacity(arr) == 0);
+	da_append(arr, 69);
+	assert(arr[0] == 69);
+	da_free(arr);
+
+	printf("-- da_erase; (not growing) -------------------------------\n");
+	da_assign(arr, ((int[]){1, 2, 3}), 3);
+	da_shrink_to_fit(arr);
+	da_erase(arr, 0);
+	assert(da_capacity(arr) == 3);
+	da_free(arr);
+
+	printf("-- da_growth.shrink; -------------------------------------\n");
+	da_growth shrinking = { 2, 3, 2, 8, DA_ROUND_NONE, 0, 4 };
+	da_set_growth(arr, &shrinking); /* arr == NULL */
+	arr = da_init(sizeof(*arr));
+	da_set_growth(arr, &shrinking);
+	for (int i = 0; i < 10000; ++i) {
+		da_append(arr, i);
+	}
+	size_t cap = da_capacity(arr);
+	da_erase_range(arr, cap / 4, da_size(arr));
+	assert(da_capacity(arr) == cap); /* exactly 1/4 full */
+	da_erase(arr, 0);
+	DEBUG_DUMP(arr);
+	size_t shrunk = da_capacity(arr);
+	assert(shrunk < cap);
+	assert(shrunk == da_size(arr) * 3 / 2 + 8);
+	assert(arr[0] == 1 && arr[da_size(arr) - 1] == (int)(cap / 4 - 1));
+
+	/* hysteresis; appending to capacity and erasing again doesn't shrink */
+	while (da_size(arr) < shrunk) {
+		da_append(arr, 0);
+	}
+	while (da_size(arr) > shrunk / 4) {
+		da_swap_remove(arr, 0);
+	}
+	assert(da_capacity(arr) == shrunk);
+	da_free(arr);
+
+	printf("-- da_growth.shrink; (resident memory) -------------------\n");
+	da_set_mmap_threshold(1024 * 1024, 0);
+	char* burst = da_init(sizeof(*burst));
+	da_set_growth(burst, &shrinking);
+	size_t before = resident_bytes();
+	for (int i = 0; i < 64 * 1024 * 1024; ++i) {
+		da_append(burst, 'x');
+	}
+	size_t peak = resident_bytes();
+	da_erase_range(burst, 1024, da_size(burst));
+	size_t after = resident_bytes();
+	printf("resident == %zu KiB -> %zu KiB -> %zu KiB\n",
+		before / 1024, peak / 1024, after / 1024);
+	assert(da_capacity(burst) < 2048);
+	if (before != 0) {
+		assert(peak >= before + 48 * 1024 * 1024);
+		assert(after <= peak - 48 * 1024 * 1024);
+	}
+	da_free(burst);
+	da_set_mmap_threshold(64 * 1024 * 1024, 0);
+}
+
+void test_9(void) {
+	printf("== Test 9 : Instrumentation. =============================\n");
+
+	da_stats total;
+	da_stats local = {0};
+	da_stats_reset();
+
+#ifdef DA_STATS
+	printf("-- da_stats_snapshot; ------------------------------------\n");
+	int* arr = da_init(sizeof(*arr));
+	da_stats_snapshot(&total);
+	assert(total.allocs == 1 && total.bytes_allocated > 0);
+	assert(total.grows == 0 && total.failed == 0);
+
+	printf("-- da_set_stats; -----------------------------------------\n");
+	da_set_stats(arr, &local);
+	da_reserve(arr, 100);
+	assert(local.grows == 1 && local.allocs == 0);
+	assert(local.peak_capacity_bytes == 100 * sizeof(*arr));
+	for (int i = 0; i < 10; ++i) {
+		da_append(arr, i);
+	}
+	da_insert(arr, 0, -1);
+	assert(local.bytes_moved == 10 * sizeof(*arr));
+	da_erase(arr, 0);
+	assert(local.bytes_moved == 20 * sizeof(*arr));
+	da_erase_range(arr, 0, 5);
+	da_remove_if(arr, is_char_in, "\x05");
+	assert(local.bytes_moved == 20 * sizeof(*arr) + 9 * sizeof(*arr));
+	da_shrink_to_fit(arr);
+	assert(local.shrinks == 1 && da_capacity(arr) == 4);
+	da_reserve(arr, SIZE_MAX / 2);
+	assert(local.failed == 1 && da_capacity(arr) == 4);
+	da_stats_snapshot(&total);
+	assert(total.grows == local.grows && total.failed == local.failed);
+	assert(total.bytes_moved == local.bytes_moved);
+	da_set_stats(arr, NULL);
+	da_reserve(arr, 200);
+	assert(local.grows == 1);
+	da_free(arr);
+
+	printf("-- bytes_copied; -----------------------------------------\n");
+	/* arena blocks that are not the last allocation always move */
+	da_arena arena;
+	da_arena_init(&arena, 4096);
+	memset(&local, 0, sizeof(local));
+	arr = da_init_with(sizeof(*arr), &arena.allocator);
+	int* other = da_init_with(sizeof(*other), &arena.allocator);
+	da_set_stats(arr, &local);
+	da_append_n(arr, ((int[]){1, 2}), 2);
+	da_reserve(arr, 64);
+	assert(local.bytes_copied >= 2 * sizeof(*arr));
+	assert(arr[0] == 1 && arr[1] == 2);
+	da_free(other);
+	da_free(arr);
+	da_arena_release(&arena);
+
+	/* a mapping grows without copying */
+	double* big = da_init_with(sizeof(*big), &da_mmap_allocator);
+	memset(&local, 0, sizeof(local));
+	da_set_stats(big, &local);
+	for (int i = 0; i < 100 * 1000; ++i) {
+		da_append(big, i);
+	}
+	assert(local.grows > 0 && local.bytes_copied == 0);
+	da_free(big);
+#else
+	printf("-- da_stats_snapshot; (disabled) -------------------------\n");
+	int* arr = NULL;
+	da_append(arr, 1);
+	da_set_stats(arr, &local);
+	da_reserve(arr, 100);
+	da_stats_snapshot(&total);
+	assert(total.allocs == 0 && total.grows == 0);
+	assert(local.grows == 0);
+	da_free(arr);
+#endif
+}
+
+void test_10(void) {
+	printf("== Test 10 : Inline storage. =============================\n");
+
+	printf("-- da_init_inline; ---------------------------------------\n");
+	DA_INLINE_STORAGE(int, 16) buf;
+	char* lo = (char*)&buf;
+	char* hi = lo + sizeof(buf);
+	int* arr = da_init_inline(&buf, sizeof(buf), sizeof(*arr));
+	DEBUG_DUMP(arr);
+	assert((char*)arr > lo && (char*)arr < hi);
+	assert(da_size(arr) == 0 && da_capacity(arr) >= 16);
+	for (int i = 0; i < 16; ++i) {
+		da_append(arr, i);
+	}
+	assert((char*)arr > lo && (char*)arr < hi);
+	assert(sum_array(arr, da_size(arr)) == 120);
+	da_free(arr); /* must not free `buf` */
+	assert(arr == NULL);
+
+	printf("-- da_init_inline; (moving to the heap) ------------------\n");
+	arr = da_init_inline(&buf, sizeof(buf), sizeof(*arr));
+	da_erase(arr, 0); /* arr is empty */
+	size_t inline_cap = da_capacity(arr);
+	for (int i = 0; i < 1000; ++i) {
+		da_append(arr, i);
+	}
+	DEBUG_DUMP(arr);
+	assert((char*)arr < lo || (char*)arr >= hi);
+	assert(da_capacity(arr) > inline_cap);
+	assert(arr[0] == 0 && arr[999] == 999);
+	da_shrink_to_fit(arr);
+	assert(arr[999] == 999);
+	da_free(arr);
+
+	arr = da_init_inline(&buf, sizeof(buf), sizeof(*arr));
+	da_assign(arr, ((int[]){1, 2, 3}), 3);
+	da_shrink_to_fit(arr); /* stays in `buf` */
+	assert((char*)arr > lo && (char*)arr < hi);
+	assert(da_capacity(arr) == 3 && arr[2] == 3);
+	da_append(arr, 4);
+	assert((char*)arr < lo || (char*)arr >= hi);
+	assert(sum_array(arr, da_size(arr)) == 10);
+	da_free(arr);
+
+	printf("-- da_init_inline; (struct member) -----------------------\n");
+	struct {
+		int id;
+		DA_INLINE_STORAGE(long double, 4) storage;
+	} owner;
+	long double* lds = da_init_inline(
+		&owner.storage, sizeof(owner.storage), sizeof(*lds)
+	);
+	for (int i = 0; i < 4; ++i) {
+		da_append(lds, i);
+	}
+	assert(((uintptr_t)lds % __alignof__(long double)) == 0);
+	assert(lds[3] == 3.0L);
+	da_free(lds);
+
+	printf("-- da_init_inline; (invalid) -----------------------------\n");
+	errno = 0;
+	arr = da_init_inline(lo + 1, sizeof(buf) - 1, sizeof(*arr));
+	assert(arr == NULL && errno == EINVAL);
+	errno = 0;
+	arr = da_init_inline(&buf, 16, sizeof(*arr));
+	assert(arr == NULL && errno == EINVAL);
+	arr = da_init_inline(&buf, sizeof(buf), 0);
+	assert(arr == NULL);
+}
+
+void test_11(void) {
+	printf("== Test 11 : Thread cache. ===============================\n");
+
+	printf("-- da_set_thread_cache; ----------------------------------\n");
+	da_stats before;
+	da_stats after;
+	da_set_thread_cache(64 * 1024);
+	int* arr = da_init(sizeof(*arr));
+	void* block = arr;
+	da_free(arr);
+	da_stats_snapshot(&before);
+	arr = da_init(sizeof(*arr));
+	da_stats_snapshot(&after);
+	assert((void*)arr == block); /* the same block, from the cache */
+#ifdef DA_STATS
+	assert(after.cache_hits == before.cache_hits + 1);
+#endif
+	for (int i = 0; i < 1000; ++i) {
+		da_append(arr, i);
+	}
+	da_erase_range(arr, 10, 1000);
+	da_shrink_to_fit(arr);
+	assert(da_capacity(arr) == 10 && sum_array(arr, 10) == 45);
+	da_free(arr);
+
+	/* the same sequence again is served from the cache */
+	da_stats_snapshot(&before);
+	for (int i = 0; i < 1000; ++i) {
+		da_append(arr, i);
+	}
+	da_stats_snapshot(&after);
+	assert(sum_array(arr, da_size(arr)) == 999 * 1000 / 2);
+#ifdef DA_STATS
+	assert(after.cache_hits > before.cache_hits);
+#endif
+	da_free(arr);
+
+	printf("-- da_set_thread_cache; (threads) ------------------------\n");
+	/* leaked blocks are reported by the leak sanitizer */
+	pthread_t threads[4];
+	int64_t sums[4] = {0};
+	for (int t = 0; t < 4; ++t) {
+		assert(pthread_create(&threads[t], NULL, cache_churn, &sums[t]) == 0);
+	}
+	for (int t = 0; t < 4; ++t) {
+		pthread_join(threads[t], NULL);
+		assert(sums[t] == 100 * (99 * 100 / 2));
+	}
+
+	printf("-- da_set_thread_cache; (bounded) ------------------------\n");
+	/* 600 byte blocks (header + 2 elements), one fits in a 1 KiB cache */
+	struct big { char bytes[200]; };
+	da_thread_cache_drain();
+	da_set_thread_cache(1024);
+	struct big* one = da_init(sizeof(*one));
+	struct big* two = da_init(sizeof(*two));
+	da_free(one);
+	da_free(two); /* over the bound, freed */
+	da_stats_snapshot(&before);
+	one = da_init(sizeof(*one));
+	two = da_init(sizeof(*two));
+	da_stats_snapshot(&after);
+#ifdef DA_STATS
+	assert(after.cache_hits == before.cache_hits + 1);
+#endif
+	da_free(one);
+	da_free(two);
+
+	da_thread_cache_drain();
+	da_set_thread_cache(0);
+}
+
+void test_12(void) {
+	printf("== Test 12 : Concurrent append. ==========================\n");
+
+	printf("-- da_conc_append; ---------------------------------------\n");
+	da_conc conc;
+	assert(da_conc_init(&conc, sizeof(uint64_t), 0) == 0);
+	assert(da_conc_size(&conc) == 0 && da_conc_at(&conc, 0) == NULL);
+	for (uint64_t i = 0; i < 100; ++i) {
+		assert(da_conc_append(&conc, &i) == 0);
+	}
+	assert(da_conc_size(&conc) == 100);
+	assert(*(uint64_t*)da_conc_at(&conc, 99) == 99);
+	uint64_t* arr = da_conc_to_da(&conc);
+	DEBUG_DUMP(arr);
+	assert(da_size(arr) == 100 && arr[0] == 0 && arr[99] == 99);
+	da_free(arr);
+
+	printf("-- da_conc_to_da; (reserved) -----------------------------\n");
+	assert(da_conc_init(&conc, sizeof(uint64_t), 1000) == 0);
+	void* seg = conc.segments[0];
+	for (uint64_t i = 0; i < 1000; ++i) {
+		assert(da_conc_append(&conc, &i) == 0);
+	}
+	arr = da_conc_to_da(&conc);
+	assert((void*)arr == seg); /* no copy */
+	assert(da_size(arr) == 1000 && arr[999] == 999);
+	da_free(arr);
+
+	printf("-- da_conc_append; (out of memory) -----------------------\n");
+	size_t budget = SIZE_MAX;
+	da_allocator failing = {
+		budget_alloc, budget_resize, budget_release, &budget, NULL
+	};
+	assert(da_conc_init_with(&conc, sizeof(uint64_t), 16, &failing) == 0);
+	for (uint64_t i = 0; i < 16; ++i) {
+		assert(da_conc_append(&conc, &i) == 0);
+	}
+	budget = 0; /* segment 1 can't be allocated */
+	uint64_t val = 16;
+	errno = 0;
+	assert(da_conc_append(&conc, &val) == -1 && errno == ENOMEM);
+	uint64_t vals[40] = {0};
+	assert(da_conc_append_n(&conc, vals, 40) == -1 && errno == ENOMEM);
+	assert(da_conc_size(&conc) == 16 && da_conc_at(&conc, 16) == NULL);
+	/* nothing was claimed, so the array carries on once memory is back */
+	budget = SIZE_MAX;
+	assert(da_conc_append(&conc, &val) == 0);
+	for (uint64_t i = 0; i < 40; ++i) {
+		vals[i] = 17 + i;
+	}
+	assert(da_conc_append_n(&conc, vals, 40) == 0);
+	assert(da_conc_size(&conc) == 57);
+	assert(*(uint64_t*)da_conc_at(&conc, 16) == 16);
+	arr = da_conc_to_da(&conc);
+	assert(da_size(arr) == 57);
+	for (uint64_t i = 0; i < 57; ++i) {
+		assert(arr[i] == i);
+	}
+	da_free(arr);
+
+	printf("-- da_conc_append; (threads) -----------------------------\n");
+	pthread_t threads[CONC_THREADS + 1];
+	struct conc_producer producers[CONC_THREADS];
+	assert(da_conc_init(&conc, sizeof(uint64_t), 0) == 0);
+	pthread_create(&threads[CONC_THREADS], NULL, conc_observe, &conc);
+	for (int t = 0; t < CONC_THREADS; ++t) {
+		producers[t].conc = &conc;
+		producers[t].id = t;
+		pthread_create(&threads[t], NULL, conc_produce, &producers[t]);
+	}
+	for (int t = 0; t <= CONC_THREADS; ++t) {
+		pthread_join(threads[t], NULL);
+	}
+
+	/* every value exactly once, in order per producer */
+	arr = da_conc_to_da(&conc);
+	assert(da_size(arr) == CONC_THREADS * CONC_PER_THREAD);
+	uint64_t next[CONC_THREADS] = {0};
+	for (size_t i = 0; i < da_size(arr); ++i) {
+		uint64_t id = arr[i] >> 32;
+		assert(id < CONC_THREADS);
+		assert((arr[i] & 0xffffffff) == ++next[id]);
+	}
+	da_free(arr);
+}
+
+void test_13(void) {
+	printf("== Test 13 : Segmented array. ============================\n");
+
+	printf("-- da_seg_append; ----------------------------------------\n");
+	int** seg = NULL;
+	assert(da_seg_size(seg) == 0 && da_seg_at(seg, 0) == NULL);
+	da_seg_append(seg, 0);
+	int* first = da_seg_at(seg, 0);
+	for (int i = 1; i < 10000; ++i) {
+		da_seg_append(seg, i);
+	}
+	assert(da_seg_size(seg) == 10000);
+	assert(da_seg_capacity(seg) >= 10000);
+	assert(da_seg_at(seg, 0) == first); /* never moved */
+	assert(da_seg_at(seg, 10000) == NULL);
+	for (int i = 0; i < 10000; ++i) {
+		assert(da_seg_get(seg, i) == i && *da_seg_at(seg, i) == i);
+	}
+
+	/* chunk boundaries */
+	assert(da_seg_at(seg, DA_SEG_FIRST - 1) == seg[0] + DA_SEG_FIRST - 1);
+	assert(da_seg_at(seg, DA_SEG_FIRST) == seg[1]);
+	assert(da_seg_at(seg, 3 * DA_SEG_FIRST) == seg[2]);
+
+	printf("-- da_seg_to_da; -----------------------------------------\n");
+	int* arr = da_seg_to_da(seg);
+	DEBUG_DUMP(arr);
+	assert(da_size(arr) == 10000);
+	for (int i = 0; i < 10000; ++i) {
+		assert(arr[i] == i);
+	}
+	da_free(arr);
+	da_seg_free(seg);
+	assert(seg == NULL && da_seg_to_da(seg) == NULL);
+
+	printf("-- da_seg_reserve; ---------------------------------------\n");
+	long double** lds = NULL;
+	da_seg_reserve(lds, 100);
+	assert(da_seg_size(lds) == 0 && da_seg_capacity(lds) >= 100);
+	size_t cap = da_seg_capacity(lds);
+	for (int i = 0; i < 100; ++i) {
+		da_seg_append(lds, i);
+	}
+	assert(da_seg_capacity(lds) == cap && da_seg_get(lds, 99) == 99.0L);
+	errno = 0;
+	da_seg_reserve(lds, SIZE_MAX);
+	assert(errno == ENOMEM && da_seg_get(lds, 99) == 99.0L);
+	da_seg_free(lds);
+}
+
+void test_14(void) {
+	printf("== Test 14 : Deque. ======================================\n");
+
+	printf("-- da_deque_push_front; ----------------------------------\n");
+	int* arr = NULL;
+	da_reserve(arr, 8);
+	for (int i = 1; i <= 5; ++i) {
+		da_deque_push_back(arr, i);
+	}
+	da_deque_push_front(arr, 0);
+	da_deque_push_front(arr, -1);
+	assert(da_size(arr) == 7 && da_capacity(arr) == 8);
+	assert(da_deque_front(arr) == -1 && da_deque_back(arr) == 5);
+	for (int i = 0; i < 7; ++i) {
+		assert(da_deque_get(arr, i) == i - 1);
+		assert(*da_deque_at(arr, i) == i - 1);
+	}
+	assert(da_deque_at(arr, 7) == NULL);
+
+	printf("-- da_deque_linearize; -----------------------------------\n");
+	int* plain = da_deque_linearize(arr);
+	assert(plain == arr);
+	PRINT_ARRAY("%d", arr);
+	for (int i = 0; i < 7; ++i) {
+		assert(arr[i] == i - 1);
+	}
+	da_deque_pop_front(arr);
+	da_deque_pop_front(arr);
+	da_deque_linearize(arr); /* not wrapped, moved down */
+	assert(arr[0] == 1 && arr[4] == 5 && da_size(arr) == 5);
+
+	printf("-- da_deque_push_front; (growing) ------------------------\n");
+	for (int i = 0; i > -100; --i) {
+		da_deque_push_front(arr, i);
+	}
+	da_deque_push_back(arr, 6);
+	assert(da_size(arr) == 106);
+	for (int i = 0; i < 106; ++i) {
+		assert(da_deque_get(arr, i) == i - 99);
+	}
+	da_deque_push_front(arr, -100);
+	da_reserve(arr, 1000); /* linearizes */
+	for (int i = 0; i < 107; ++i) {
+		assert(arr[i] == i - 100);
+	}
+	da_free(arr);
+
+	printf("-- da_deque_pop_front; (queue) ---------------------------\n");
+	int next_in = 0;
+	int next_out = 0;
+	for (int round = 0; round < 1000; ++round) {
+		for (int i = 0; i < round % 7; ++i) {
+			da_deque_push_back(arr, next_in++);
+		}
+		for (int i = 0; i < round % 5 && da_size(arr) > 0; ++i) {
+			assert(da_deque_front(arr) == next_out++);
+			da_deque_pop_front(arr);
+		}
+	}
+	assert((int)da_size(arr) == next_in - next_out);
+	DEBUG_DUMP(arr);
+	while (da_size(arr) > 0) {
+		assert(da_deque_back(arr) == --next_in);
+		da_deque_pop_back(arr);
+	}
+	da_deque_pop_back(arr); /* empty */
+	da_append(arr, 69); /* plain again */
+	assert(arr[0] == 69 && da_size(arr) == 1);
+	da_free(arr);
+	da_deque_pop_front(arr); /* arr == NULL */
+	assert(da_deque_at(arr, 0) == NULL && da_deque_linearize(arr) == NULL);
+}
+
+/*
+ * Fills arrays of every length up to 300 (at data addresses 8 bytes apart)
+ * with `vals`, then compares `da_find()` and `da_count()` at every SIMD level
+ * with a plain loop, for every value of `vals` and `missing`.
+ */
+#define SEARCH_CHECK(type, missing, ...)                                      \
+do {                                                                          \
+	type vals[] = { __VA_ARGS__, missing };                               \
+	size_t nvals = sizeof(vals) / sizeof(*vals) - 1;                      \
+	for (size_t shift = 0; shift < 64; shift += 8) {                      \
+		da_allocator shifted = {                                      \
+			shifted_alloc, shifted_resize, shifted_release,       \
+			(void*)shift, NULL                                    \
+		};                                                            \
+		for (size_t n = 0; n < 300; n += 1 + n / 16) {                \
+			type* arr = da_init_with(sizeof(type), &shifted);     \
+			for (size_t i = 0; i < n; ++i) {                      \
+				da_append(arr, vals[rand() % (n % 3 + 1)      \
+					% nvals]);                            \
+			}                                                     \
+			for (size_t v = 0; v <= nvals; ++v) {                 \
+				size_t first = n;                             \
+				size_t count = 0;                             \
+				for (size_t i = n; i-- > 0;) {                \
+					if (arr[i] == vals[v]) {              \
+						first = i;                    \
+						++count;                      \
+					}                                     \
+				}                                             \
+				for (int l = 0; l <= (int)best; ++l) {        \
+					da_set_simd_level(l);                 \
+					type* found = da_find(arr, vals[v]);  \
+					assert(first == n ? found == NULL     \
+						: found == arr + first);      \
+					assert(da_count(arr, vals[v])         \
+						== count);                    \
+					assert(da_contains(arr, vals[v])      \
+						== (first < n));              \
+				}                                             \
+			}                                                     \
+			da_free(arr);                                         \
+		}                                                             \
+	}                                                                     \
+	da_set_simd_level(best);                                              \
+} while (0)
+
+void test_15(void) {
+	printf("== Test 15 : Search. =====================================\n");
+	enum da_simd best = da_simd_level();
+	printf("da_simd_level() == %d\n", (int)best);
+	assert(da_set_simd_level(DA_SIMD_NONE) == DA_SIMD_NONE);
+	assert(da_simd_level() == DA_SIMD_NONE);
+	assert(da_set_simd_level(DA_SIMD_AVX512) == best); /* clamped */
+
+	printf("-- da_find; integers -------------------------------------\n");
+	SEARCH_CHECK(int8_t, 5, 1, -1, 0, INT8_MIN);
+	SEARCH_CHECK(uint8_t, 5, 1, 0xff, 0x7f);
+	SEARCH_CHECK(int16_t, 0x100, 1, -1, 0, INT16_MIN);
+	SEARCH_CHECK(int32_t, 0x10000, 1, -1, 0, INT32_MIN);
+	/* equal in one half only */
+	SEARCH_CHECK(int64_t, (int64_t)1 << 32, 1, ((int64_t)1 << 32) + 1,
+		-1, INT64_MIN);
+	SEARCH_CHECK(uint64_t, 0xffffffff, 0xffffffff00000000, 0, 7);
+
+	printf("-- da_find; floating point -------------------------------\n");
+	/* `-0.0` is found as `0.0` and `NAN` never, compared as a plain loop */
+	SEARCH_CHECK(float, 2.5f, 0.0f, -0.0f, 1.5f, NAN);
+	SEARCH_CHECK(double, 2.5, 0.0, -0.0, 1.5, NAN, INFINITY);
+
+	printf("-- da_find; other types ----------------------------------\n");
+	struct triple { int64_t v[3]; }* triples = NULL;
+	da_append(triples, ((struct triple){{1, 2, 3}}));
+	da_append(triples, ((struct triple){{4, 5, 6}}));
+	da_append(triples, ((struct triple){{1, 2, 3}}));
+	assert(da_find_(triples, &(struct triple){{4, 5, 6}}, sizeof(*triples),
+		DA_KIND_BITS) == triples + 1);
+	assert(da_count_(triples, &(struct triple){{1, 2, 3}}, sizeof(*triples),
+		DA_KIND_BITS) == 2);
+	assert(da_find_(triples, &(struct triple){{1, 2, 4}}, sizeof(*triples),
+		DA_KIND_BITS) == NULL);
+	da_free(triples);
+
+	int* arr = NULL;
+	assert(da_find(arr, 1) == NULL && da_count(arr, 1) == 0);
+	assert(!da_contains(arr, 1));
+	da_append(arr, 1);
+	assert(da_find(arr, 1) == arr && da_count(arr, 1) == 1);
+	da_free(arr);
+}
+
+/*
+ * Compares `da_sum()`, `da_minmax()`, `da_scale()` and `da_add_scalar()` at
+ * every SIMD level with plain loops, for arrays of up to 300 small values
+ * (so that floating point sums are exact). `wide` is the type of the sum.
+ */
+#define REDUCE_CHECK(type, wide, lo, hi)                                      \
+do {                                                                          \
+	enum da_simd best = da_simd_level();                                  \
+	for (size_t n = 0; n < 300; n += 1 + n / 16) {                        \
+		type* arr = NULL;                                             \
+		wide sum = 0;                                                 \
+		type min = hi;                                                \
+		type max = lo;                                                \
+		for (size_t i = 0; i < n; ++i) {                              \
+			type x = (type)(lo + rand() % (int)(hi - lo + 1));    \
+			da_append(arr, x);                                    \
+			sum += x;                                             \
+			min = x < min ? x : min;                              \
+			max = x > max ? x : max;                              \
+		}                                                             \
+		for (int l = 0; l <= (int)best; ++l) {                        \
+			type* copy = NULL;                                    \
+			type got_min = 0;                                     \
+			type got_max = 0;                                     \
+			da_set_simd_level(l);                                 \
+			assert(da_sum(arr) == sum);                           \
+			da_minmax(arr, &got_min, &got_max);                   \
+			assert(n == 0 || (got_min == min && got_max == max)); \
+			da_reserve(copy, n);                                  \
+			for (size_t i = 0; i < n; ++i) {                      \
+				da_append(copy, arr[i]);                      \
+			}                                                     \
+			da_scale(copy, 3);                                    \
+			da_add_scalar(copy, -1);                              \
+			for (size_t i = 0; i < n; ++i) {                      \
+				assert(copy[i] == (type)(arr[i] * 3 - 1));    \
+			}                                                     \
+			da_free(copy);                                        \
+		}                                                             \
+		da_free(arr);                                                 \
+	}                                                                     \
+	da_set_simd_level(best);                                              \
+} while (0)
+
+void test_16(void) {
+	printf("== Test 16 : Reductions and transforms. ==================\n");
+
+	printf("-- da_sum; -----------------------------------------------\n");
+	REDUCE_CHECK(char, int64_t, 0, 100);
+	REDUCE_CHECK(signed char, int64_t, -100, 100);
+	REDUCE_CHECK(unsigned char, uint64_t, 0, 200);
+	REDUCE_CHECK(short, int64_t, -1000, 1000);
+	REDUCE_CHECK(unsigned short, uint64_t, 0, 2000);
+	REDUCE_CHECK(int, int64_t, -1000, 1000);
+	REDUCE_CHECK(unsigned, uint64_t, 0, 2000);
+	REDUCE_CHECK(long, int64_t, -1000, 1000);
+	REDUCE_CHECK(long long, int64_t, -1000, 1000);
+	REDUCE_CHECK(float, double, -1000, 1000);
+	REDUCE_CHECK(double, double, -1000, 1000);
+	REDUCE_CHECK(long double, double, -1000, 1000);
+
+	/* no overflow before 64 bits */
+	signed char* bytes = NULL;
+	int* ints = NULL;
+	for (int i = 0; i < 1000; ++i) {
+		da_append(bytes, 127);
+		da_append(ints, INT32_MAX);
+	}
+	assert(da_sum(bytes) == 127000);
+	assert(da_sum(ints) == (int64_t)INT32_MAX * 1000);
+	da_free(bytes);
+	da_free(ints);
+
+	printf("-- da_minmax; --------------------------------------------\n");
+	double* reals = NULL;
+	double lo = 0;
+	double hi = 0;
+	da_minmax(reals, &lo, &hi); /* reals == NULL */
+	assert(lo == 0 && hi == 0);
+	for (int i = 0; i < 40; ++i) {
+		da_append(reals, i % 2 ? -i : NAN);
+	}
+	enum da_simd best = da_simd_level();
+	for (int l = 0; l <= (int)best; ++l) {
+		da_set_simd_level(l);
+		da_minmax(reals, &lo, &hi);
+		assert(lo == -39.0 && hi == -1.0);
+		da_minmax(reals, NULL, &hi);
+		assert(hi == -1.0);
+	}
+	da_set_simd_level(best);
+	for (int i = 0; i < 40; ++i) {
+		reals[i] = NAN;
+	}
+	da_minmax(reals, &lo, &hi);
+	assert(isnan(lo) && isnan(hi));
+	da_free(reals);
+
+	printf("-- da_scale; ---------------------------------------------\n");
+	unsigned char* small = NULL;
+	da_append_n(small, ((unsigned char[]){1, 100, 200}), 3);
+	da_scale(small, 2); /* wraps */
+	assert(small[0] == 2 && small[1] == 200 && small[2] == 144);
+	da_add_scalar(small, 100);
+	assert(small[0] == 102 && small[1] == 44 && small[2] == 244);
+	da_free(small);
+
+	printf("-- da_map; -----------------------------------------------\n");
+	size_t calls = 0;
+	for (int i = 0; i < 1000; ++i) {
+		da_append(ints, i);
+	}
+	da_map(ints, double_and_count, &calls);
+	assert(calls == 1000 && ints[999] == 1998);
+	assert(da_sum(ints) == 999 * 1000);
+	da_free(ints);
+	da_map(ints, double_and_count, &calls); /* ints == NULL */
+	assert(calls == 1000 && da_sum(ints) == 0);
+
+	errno = 0;
+	assert(da_sum_i_(NULL, 3) == 0 && errno == EINVAL);
+}
+
+void test_17(void) {
+	printf("== Test 17 : Parallel algorithms. ========================\n");
+	da_parallel_set_threads(4);
+	assert(da_parallel_threads() == 4);
+	da_parallel_set_threshold(0); /* always on the pool */
+
+	printf("-- da_parallel_for; --------------------------------------\n");
+	size_t n = 3 * 1000 * 1000; /* 46 chunks */
+	int* arr = NULL;
+	da_reserve(arr, n);
+	for (size_t i = 0; i < n; ++i) {
+		da_append(arr, -1);
+	}
+	da_parallel_for(arr, fill_index, arr);
+	for (size_t i = 0; i < n; ++i) {
+		assert(arr[i] == (int)i);
+	}
+
+	printf("-- da_parallel_reduce; -----------------------------------\n");
+	double* reals = NULL;
+	da_reserve(reals, n);
+	for (size_t i = 0; i < n; ++i) {
+		da_append(reals, 1.0 / (double)(i + 1));
+	}
+	int64_t sum = 0;
+	double real_sum = 0;
+	da_parallel_reduce(arr, &sum, sum_ints, add_int64, NULL);
+	da_parallel_reduce(reals, &real_sum, sum_reals, add_double, NULL);
+	assert(sum == (int64_t)n * (int64_t)(n - 1) / 2);
+	/* the same chunks, combined in the same order */
+	for (size_t threads = 1; threads <= 8; threads *= 2) {
+		int64_t other_sum = 0;
+		double other_real_sum = 0;
+		da_parallel_set_threads(threads);
+		da_parallel_reduce(arr, &other_sum, sum_ints, add_int64, NULL);
+		da_parallel_reduce(reals, &other_real_sum, sum_reals,
+			add_double, NULL);
+		assert(other_sum == sum);
+		assert(memcmp(&other_real_sum, &real_sum, sizeof(double)) == 0);
+	}
+	da_free(reals);
+
+	printf("-- da_parallel_for; (nested) -----------------------------\n");
+	int* small = NULL;
+	for (int i = 0; i < 100; ++i) {
+		da_append(small, i);
+	}
+	da_parallel_for(arr, nested_reduce, small); /* runs serially inside */
+	da_free(small);
+
+	printf("-- da_assign; (parallel copy) ----------------------------\n");
+	int* copy = NULL;
+	da_assign(copy, arr, n);
+	assert(da_size(copy) == n && memcmp(copy, arr, n * sizeof(int)) == 0);
+	da_free(copy);
+	da_free(arr);
+
+	da_parallel_for(arr, fill_index, arr); /* arr == NULL */
+	sum = 7;
+	da_parallel_reduce(arr, &sum, sum_ints, add_int64, NULL);
+	assert(sum == 7);
+
+	da_parallel_set_threshold(DA_PARALLEL_THRESHOLD);
+	da_parallel_set_threads(1); /* joins the workers */
+	assert(da_parallel_threads() == 1);
+	da_parallel_set_threads(0);
+}
+
+/*
+ * Sorts arrays of up to 1000 elements drawn from `vals` (in ascending order)
+ * with `da_sort()`, then checks the order, that nothing was lost (by
+ * counting) and the bounds of every value.
+ */
+#define SORT_CHECK(type, ...)                                                 \
+do {                                                                          \
+	type vals[] = { __VA_ARGS__ };                                        \
+	size_t nvals = sizeof(vals) / sizeof(*vals);                          \
+	for (size_t n = 0; n < 1000; n += 1 + n / 4) {                        \
+		type* arr = NULL;                                             \
+		size_t counts[sizeof(vals) / sizeof(*vals)] = {0};            \
+		for (size_t i = 0; i < n; ++i) {                              \
+			size_t v = (size_t)rand() % nvals;                    \
+			da_append(arr, vals[v]);                              \
+			++counts[v];                                          \
+		}                                                             \
+		da_sort(arr);                                                 \
+		size_t at = 0;                                                \
+		for (size_t v = 0; v < nvals; ++v) {                          \
+			assert(da_lower_bound(arr, vals[v]) == at);           \
+			for (size_t i = 0; i < counts[v]; ++i, ++at) {        \
+				assert(memcmp(&arr[at], &vals[v],             \
+					sizeof(type)) == 0);                  \
+			}                                                     \
+			assert(da_upper_bound(arr, vals[v]) == at);           \
+		}                                                             \
+		assert(at == n);                                              \
+		da_free(arr);                                                 \
+	}                                                                     \
+} while (0)
+
+void test_18(void) {
+	printf("== Test 18 : Sorting and binary search. ==================\n");
+
+	printf("-- da_sort; integers -------------------------------------\n");
+	SORT_CHECK(int8_t, INT8_MIN, -1, 0, 1, 5, INT8_MAX);
+	SORT_CHECK(uint8_t, 0, 1, 0x7f, 0x80, 0xff);
+	SORT_CHECK(int16_t, INT16_MIN, -300, -1, 0, 256, INT16_MAX);
+	SORT_CHECK(uint16_t, 0, 1, 0x100, 0x8000, 0xffff);
+	SORT_CHECK(int, INT_MIN, -70000, -1, 0, 1, 65536, INT_MAX);
+	SORT_CHECK(unsigned, 0, 1, 0x10000, 0x80000000u, UINT_MAX);
+	SORT_CHECK(int64_t, INT64_MIN, -((int64_t)1 << 40), -1, 0,
+		(int64_t)1 << 33, INT64_MAX);
+	SORT_CHECK(uint64_t, 0, 0xff, (uint64_t)1 << 63, UINT64_MAX);
+
+	printf("-- da_sort; floating point -------------------------------\n");
+	SORT_CHECK(float, -INFINITY, -1e30f, -1.5f, -0.0f, 0.0f, 1e-40f,
+		2.5f, INFINITY, NAN);
+	SORT_CHECK(double, -INFINITY, -1e300, -1.5, -0.0, 0.0, 1e-310, 2.5,
+		INFINITY, NAN);
+
+	int* arr = NULL;
+	for (int i = 0; i < 100000; ++i) {
+		da_append(arr, (rand() % 2 ? 1 : -1) * rand());
+	}
+	da_sort(arr);
+	for (size_t i = 1; i < da_size(arr); ++i) {
+		assert(arr[i - 1] <= arr[i]);
+	}
+	da_free(arr);
+	da_sort(arr); /* arr == NULL */
+	assert(da_lower_bound(arr, 1) == 0 && da_upper_bound(arr, 1) == 0);
+
+	printf("-- da_insert_sorted; -------------------------------------\n");
+	for (int i = 0; i < 200; ++i) {
+		da_insert_sorted(arr, (i * 37) % 101 - 50);
+	}
+	assert(da_size(arr) == 200);
+	for (size_t i = 1; i < da_size(arr); ++i) {
+		assert(arr[i - 1] <= arr[i]);
+	}
+	assert(arr[0] == -50 && arr[199] == 50);
+	da_free(arr);
+
+	printf("-- DA_DEFINE_SORT; ---------------------------------------\n");
+	for (size_t n = 0; n < 3000; n += 1 + n / 2) {
+		for (int shape = 0; shape < 5; ++shape) {
+			struct keyed* items = NULL;
+			struct keyed* expect = NULL;
+			for (size_t i = 0; i < n; ++i) {
+				int key = shape == 0 ? rand() % 50 /* few keys */
+					: shape == 1 ? (int)i /* sorted */
+					: shape == 2 ? -(int)i /* reversed */
+					: shape == 3 ? 7 /* equal */
+					: rand();
+				da_append(items, ((struct keyed){key, (int)i}));
+			}
+			da_assign(expect, items, n);
+			if (n > 0) {
+				qsort(expect, n, sizeof(*expect), compare_keys);
+			}
+			if (shape == 4) {
+				/* straight to heapsort */
+				sort_keyed_intro_(items, n, 0);
+			} else {
+				sort_keyed(items);
+			}
+			for (size_t i = 0; i < n; ++i) {
+				assert(items[i].key == expect[i].key);
+			}
+			if (n > 0) {
+				struct keyed probe = { items[n / 2].key, 0 };
+				size_t lo = sort_keyed_lower_bound(items, &probe);
+				size_t hi = sort_keyed_upper_bound(items, &probe);
+				assert(lo <= n / 2 && n / 2 < hi);
+				assert(lo == 0 || items[lo - 1].key < probe.key);
+				assert(hi == n || items[hi].key > probe.key);
+			}
+			da_free(items);
+			da_free(expect);
+		}
+	}
+}
+
+void test_19(void) {
+	printf("== Test 19 : Persistence. ================================\n");
+	const char* path = "/tmp/da_test_19.bin";
+
+	printf("-- da_save; da_mmap; -------------------------------------\n");
+	int* arr = NULL;
+	for (int i = 0; i < 100000; ++i) {
+		da_append(arr, i * 3);
+	}
+	assert(da_save(arr, path) == 0);
+
+	int* mapped = da_mmap(path, sizeof(*mapped));
+	assert(mapped != NULL);
+	assert((uintptr_t)mapped % 4096 == 0);
+	assert(da_size(mapped) == da_size(arr));
+	assert(da_capacity(mapped) == da_size(arr));
+	assert(memcmp(mapped, arr, da_size(arr) * sizeof(*arr)) == 0);
+	assert(da_find(mapped, 2997) == &mapped[999]);
+	assert(da_sum(mapped) == da_sum(arr));
+
+	printf("-- mutators copy -----------------------------------------\n");
+	int* sorted = da_mmap(path, sizeof(*sorted));
+	da_scale(sorted, -1);
+	da_sort(sorted); /* on the heap now */
+	assert(sorted[0] == -299997 && da_size(sorted) == da_size(arr));
+	da_free(sorted);
+	da_clear(mapped); /* unmapped, for an empty array */
+	assert(da_size(mapped) == 0);
+	da_append(mapped, 7);
+	assert(da_size(mapped) == 1 && mapped[0] == 7);
+	da_free(mapped);
+	mapped = da_mmap(path, sizeof(*mapped));
+	assert(mapped != NULL && mapped[1] == 3);
+
+	int* copy = da_mmap(path, sizeof(*copy));
+	int* before = copy;
+	da_erase(copy, 0);
+	assert(copy != before && copy[0] == 3);
+	assert(da_size(copy) == da_size(arr) - 1);
+	da_scale(copy, 2); /* on the heap now */
+	assert(copy[0] == 6);
+	da_free(copy);
+
+	da_append(mapped, -1);
+	assert(da_size(mapped) == da_size(arr) + 1);
+	assert(mapped[0] == 0 && mapped[da_size(arr)] == -1);
+	da_free(mapped);
+
+	/* the file is unchanged */
+	mapped = da_mmap(path, sizeof(*mapped));
+	assert(da_size(mapped) == da_size(arr) && mapped[0] == 0);
+	da_free(mapped);
+	da_free(arr);
+
+	printf("-- empty, deque and aligned arrays -----------------------\n");
+	assert(da_save(arr, path) == 0); /* arr == NULL */
+	arr = da_mmap(path, sizeof(*arr));
+	assert(arr != NULL && da_size(arr) == 0);
+	da_append(arr, 7);
+	assert(da_size(arr) == 1 && arr[0] == 7);
+	da_free(arr);
+
+	for (int i = 0; i < 10; ++i) {
+		da_deque_push_front(arr, i);
+	}
+	assert(da_save(arr, path) == 0);
+	int* ring = da_mmap(path, sizeof(*ring));
+	for (int i = 0; i < 10; ++i) {
+		assert(ring[i] == da_deque_get(arr, i));
+	}
+	da_free(ring);
+	da_free(arr);
+
+	double* wide = da_init_aligned(sizeof(*wide), 64);
+	for (int i = 0; i < 100; ++i) {
+		da_append(wide, i * 0.5);
+	}
+	assert(da_save(wide, path) == 0);
+	da_free(wide);
+	wide = da_mmap(path, sizeof(*wide));
+	da_append(wide, 50.0);
+	assert((uintptr_t)wide % 64 == 0);
+	assert(da_size(wide) == 101 && wide[99] == 49.5 && wide[100] == 50.0);
+	da_free(wide);
+
+	printf("-- invalid files -----------------------------------------\n");
+	errno = 0;
+	assert(da_mmap(path, sizeof(int)) == NULL && errno == EINVAL);
+	errno = 0;
+	assert(da_mmap("/nonexistent/da.bin", 1) == NULL && errno == ENOENT);
+
+	FILE* file = fopen(path, "wb");
+	fputs("not an array", file);
+	fclose(file);
+	errno = 0;
+	assert(da_mmap(path, sizeof(double)) == NULL && errno == EINVAL);
+
+	/* truncated */
+	for (int i = 0; i < 1000; ++i) {
+		da_append(arr, i);
+	}
+	assert(da_save(arr, path) == 0);
+	char* bytes = malloc(8192);
+	file = fopen(path, "rb");
+	size_t got = fread(bytes, 1, 8192, file);
+	fclose(file);
+	file = fopen(path, "wb");
+	fwrite(bytes, 1, got - 100, file);
+	fclose(file);
+	free(bytes);
+	errno = 0;
+	assert(da_mmap(path, sizeof(*arr)) == NULL && errno == EINVAL);
+	da_free(arr);
+
+	remove(path);
+}
+
+void test_20(void) {
+	printf("== Test 20 : Streaming I/O. ==============================\n");
+
+	printf("-- da_spare_begin; da_commit; ----------------------------\n");
+	int* arr = NULL;
+	int* spare = da_spare_begin(arr, 100);
+	assert(spare == arr && da_capacity(arr) >= 100 && da_size(arr) == 0);
+	for (int i = 0; i < 100; ++i) {
+		spare[i] = i;
+	}
+	da_commit(arr, 100);
+	assert(da_size(arr) == 100 && arr[99] == 99);
+	errno = 0;
+	da_commit(arr, da_capacity(arr) - da_size(arr) + 1);
+	assert(errno == EINVAL && da_size(arr) == 100);
+	da_commit(arr, 0);
+	da_free(arr);
+
+	/* the spare capacity of a deque is made contiguous */
+	for (int i = 0; i < 5; ++i) {
+		da_deque_push_front(arr, i);
+	}
+	spare = da_spare_begin(arr, 1);
+	*spare = -1;
+	da_commit(arr, 1);
+	assert(arr[0] == 4 && arr[4] == 0 && arr[5] == -1);
+	da_free(arr);
+
+	printf("-- da_read_fd; -------------------------------------------\n");
+	int fds[2];
+	assert(pipe(fds) == 0);
+	for (int i = 0; i < 10; ++i) {
+		da_append(arr, i);
+	}
+	assert(da_write_fd(arr, fds[1]) == 0);
+	close(fds[1]);
+
+	int* got = NULL;
+	assert(da_read_fd(got, fds[0], 4) == 4);
+	assert(da_read_fd(got, fds[0], 100) == 6);
+	assert(da_read_fd(got, fds[0], DA_READ_ALL) == 0);
+	assert(da_size(got) == 10 && memcmp(got, arr, sizeof(*arr) * 10) == 0);
+	close(fds[0]);
+	da_free(got);
+
+	/* ends mid element */
+	assert(pipe(fds) == 0);
+	assert(write(fds[1], arr, sizeof(*arr) + 2) == sizeof(*arr) + 2);
+	close(fds[1]);
+	errno = 0;
+	assert(da_read_fd(got, fds[0], DA_READ_ALL) == -1 && errno == EINVAL);
+	assert(da_size(got) == 1 && got[0] == 0);
+	close(fds[0]);
+	da_free(got);
+	da_free(arr);
+
+	printf("-- da_write_fd; da_read_fd; through a pipe ---------------\n");
+	for (int i = 0; i < 1000000; ++i) {
+		da_append(arr, i ^ 0x5555);
+	}
+	assert(pipe(fds) == 0);
+	pthread_t writer;
+	struct pipe_writer w = { fds[1], arr };
+	pthread_create(&writer, NULL, pipe_write, &w);
+	assert(da_read_fd(got, fds[0], DA_READ_ALL) == 1000000);
+	pthread_join(writer, NULL);
+	close(fds[0]);
+	assert(memcmp(got, arr, sizeof(*arr) * 1000000) == 0);
+	da_free(got);
+	da_free(arr);
+
+	/* a deque is written in order */
+	for (int i = 0; i < 100; ++i) {
+		da_deque_push_front(arr, i);
+	}
+	assert(pipe(fds) == 0);
+	assert(da_write_fd(arr, fds[1]) == 0);
+	close(fds[1]);
+	assert(da_read_fd(got, fds[0], 100) == 100);
+	for (int i = 0; i < 100; ++i) {
+		assert(got[i] == 99 - i);
+	}
+	close(fds[0]);
+	da_free(got);
+	da_free(arr);
+}
+
+void test_21(void) {
+	printf("== Test 21 : Copy-on-write sharing. ======================\n");
+
+	printf("-- da_share; ---------------------------------------------\n");
+	int* arr = NULL;
+	for (int i = 0; i < 100; ++i) {
+		da_append(arr, i);
+	}
+	size_t cap = da_capacity(arr);
+	int* snap = da_share(arr);
+	assert(snap == arr && da_capacity(arr) == 100);
+
+	/* the writer gets a copy, the snapshot is untouched */
+	da_append(arr, 100);
+	assert(arr != snap && da_size(arr) == 101 && arr[100] == 100);
+	assert(da_size(snap) == 100 && snap[99] == 99);
+
+	/* the last holder changes it in place */
+	int* before = snap;
+	da_erase(snap, 0);
+	assert(snap == before && da_size(snap) == 99 && snap[0] == 1);
+	assert(da_capacity(snap) == cap);
+	da_free(snap);
+
+	printf("-- in place mutators; unshared ---------------------------\n");
+	snap = da_share(arr);
+	da_clear(snap); /* a new empty array, then refilled */
+	assert(snap != arr && da_size(snap) == 0);
+	for (int i = 0; i < 50; ++i) {
+		da_append(snap, -i);
+	}
+	assert(da_size(snap) == 50 && snap[49] == -49);
+	assert(da_size(arr) == 101 && arr[0] == 0 && arr[100] == 100);
+	da_free(snap);
+
+	snap = da_share(arr);
+	da_scale(snap, 2);
+	da_sort(snap);
+	da_map(snap, double_and_count, &(size_t){0});
+	assert(snap != arr && snap[100] == 400 && arr[100] == 100);
+	da_free(snap);
+
+	snap = da_share(arr);
+	da_deque_pop_front(snap);
+	da_deque_pop_back(snap);
+	assert(da_size(snap) == 99 && da_deque_front(snap) == 1);
+	assert(da_size(arr) == 101 && arr[0] == 0);
+	da_free(snap);
+
+	/* reserving below the size keeps the elements, shared or not */
+	snap = da_share(arr);
+	da_reserve(snap, 0);
+	assert(snap != arr && da_size(snap) == 101 && snap[100] == 100);
+	da_reserve(snap, 0);
+	assert(da_size(snap) == 101 && da_capacity(snap) == 101);
+	da_free(snap);
+
+	snap = da_share(arr);
+	da_unshare(snap);
+	assert(snap != arr && memcmp(snap, arr, sizeof(*arr) * 101) == 0);
+	snap[0] = -1;
+	assert(arr[0] == 0);
+	da_clear(arr);
+	assert(da_size(arr) == 0);
+	da_free(snap);
+	da_free(arr);
+
+	/* freed by the original holder first */
+	for (int i = 0; i < 10; ++i) {
+		da_deque_push_front(arr, i);
+	}
+	snap = da_share(arr);
+	assert(snap[0] == 9 && snap[9] == 0); /* made a plain array */
+	da_free(arr);
+	assert(snap[0] == 9);
+	da_append(snap, 42);
+	assert(da_size(snap) == 11 && snap[10] == 42);
+	da_free(snap);
+
+	/* the other reference dropped before growing: reallocated in place */
+	for (int i = 0; i < 10; ++i) {
+		da_append(arr, i);
+	}
+	cap = da_capacity(arr);
+	snap = da_share(arr);
+	da_free(snap);
+	da_reserve(arr, cap + 100);
+	assert(da_capacity(arr) >= cap + 100 && da_size(arr) == 10);
+	assert(arr[9] == 9);
+	da_free(arr);
+
+	/* inserting at the end of a shared array, as with spare capacity */
+	for (int i = 0; i < 10; ++i) {
+		da_append(arr, i);
+	}
+	snap = da_share(arr);
+	da_insert(snap, da_size(snap), 10);
+	assert(snap != arr && da_size(snap) == 11 && snap[10] == 10);
+	assert(da_size(arr) == 10);
+	da_free(snap);
+	da_free(arr);
+
+	printf("-- da_share; concurrent readers --------------------------\n");
+	for (int i = 0; i < 100000; ++i) {
+		da_append(arr, i);
+	}
+	pthread_t readers[8];
+	for (int i = 0; i < 8; ++i) {
+		pthread_create(&readers[i], NULL, shared_read, da_share(arr));
+	}
+	da_append(arr, 100000); /* copies, unless the readers are done */
+	assert(da_size(arr) == 100001 && arr[100000] == 100000);
+	for (int i = 0; i < 8; ++i) {
+		pthread_join(readers[i], NULL);
+	}
+	da_free(arr);
+}
+
+void test_22(void) {
+	printf("== Test 22 : Struct of arrays. ===========================\n");
+
+	printf("-- append; columns ---------------------------------------\n");
+	particles p = {0};
+	for (int i = 0; i < 10000; ++i) {
+		particles_row row = { i * 0.5, (float)i, i, (char)('a' + i % 26) };
+		assert(particles_append(&p, row) == 0);
+	}
+	assert(p.size == 10000 && p.capacity >= p.size);
+	assert((uintptr_t)p.x % DA_SOA_ALIGN == 0);
+	assert((uintptr_t)p.mass % DA_SOA_ALIGN == 0);
+	assert((uintptr_t)p.id % DA_SOA_ALIGN == 0);
+	assert((uintptr_t)p.tag % DA_SOA_ALIGN == 0);
+
+	/* a column is a plain array */
+	assert(sum_array(p.id, p.size) == (int64_t)9999 * 10000 / 2);
+	assert(p.x[9999] == 4999.5 && p.mass[1234] == 1234.0f);
+	assert(p.tag[27] == 'b');
+
+	particles_row row = particles_get(&p, 42);
+	assert(row.x == 21.0 && row.mass == 42.0f && row.id == 42);
+	assert(row.tag == 'a' + 42 % 26);
+
+	printf("-- reserve; clear; free ----------------------------------\n");
+	assert(particles_reserve(&p, 20000) == 0);
+	assert(p.capacity == 20000 && p.size == 10000 && p.id[9999] == 9999);
+	assert(particles_reserve(&p, 10) == 0 && p.capacity == 20000);
+	particles_clear(&p);
+	assert(p.size == 0 && p.capacity == 20000);
+	assert(particles_append(&p, row) == 0 && p.id[0] == 42);
+	particles_free(&p);
+	assert(p.size == 0 && p.capacity == 0 && p.id == NULL);
+	particles_free(&p);
+
+	errno = 0;
+	assert(particles_reserve(&p, SIZE_MAX / 2) == -1 && errno == ENOMEM);
+	assert(p.capacity == 0 && p.id == NULL);
+}
+
+void test_23(void) {
+	printf("== Test 23 : Bit arrays. =================================\n");
+
+	printf("-- append; get; set --------------------------------------\n");
+	uint64_t* bits = NULL;
+	for (int i = 0; i < 1000; ++i) {
+		da_bits_append(bits, i % 3 == 0);
+	}
+	assert(da_size(bits) == 1000);
+	assert(da_capacity(bits) >= DA_BITS_WORDS(1000));
+	assert(da_bits_get(bits, 0) == 1 && da_bits_get(bits, 999) == 1);
+	assert(da_bits_get(bits, 1) == 0 && da_bits_get(bits, 64) == 0);
+	assert(da_bits_popcount(bits) == 334);
+	/* bits past the size are 0 */
+	assert(bits[999 / 64] >> (1000 % 64) == 0);
+
+	da_bits_set(bits, 1, 1);
+	da_bits_set(bits, 999, 0);
+	assert(da_bits_get(bits, 1) == 1 && da_bits_get(bits, 999) == 0);
+	assert(da_bits_popcount(bits) == 334);
+
+	printf("-- find --------------------------------------------------\n");
+	assert(da_bits_find(bits, 0) == 0 && da_bits_find(bits, 2) == 3);
+	assert(da_bits_find(bits, 997) == 1000); /* 999 was cleared */
+	assert(da_bits_find(bits, 5000) == 1000);
+	assert(da_bits_find(NULL, 0) == 0 && da_bits_popcount(NULL) == 0);
+
+	printf("-- set_range ---------------------------------------------\n");
+	da_bits_set_range(bits, 0, 1000, 0);
+	assert(da_bits_popcount(bits) == 0 && da_bits_find(bits, 0) == 1000);
+	da_bits_set_range(bits, 10, 20, 1); /* within a word */
+	assert(da_bits_popcount(bits) == 10 && da_bits_find(bits, 0) == 10);
+	da_bits_set_range(bits, 60, 5000, 1); /* clamped */
+	assert(da_bits_popcount(bits) == 10 + 940);
+	assert(bits[999 / 64] >> (1000 % 64) == 0);
+	da_bits_set_range(bits, 63, 129, 0); /* across words */
+	assert(da_bits_get(bits, 62) == 1 && da_bits_get(bits, 63) == 0);
+	assert(da_bits_get(bits, 128) == 0 && da_bits_get(bits, 129) == 1);
+	assert(da_bits_find(bits, 63) == 129);
+	da_bits_set_range(bits, 20, 10, 1);
+	assert(da_bits_popcount(bits) == 10 + 940 - 66);
+
+	printf("-- resize; clear -----------------------------------------\n");
+	da_bits_resize(bits, 70);
+	assert(da_size(bits) == 70 && da_bits_popcount(bits) == 10 + 3);
+	assert(bits[1] >> 6 == 0);
+	da_bits_resize(bits, 200);
+	assert(da_size(bits) == 200 && da_bits_popcount(bits) == 13);
+	assert(da_bits_find(bits, 70) == 200);
+	da_clear(bits);
+	da_bits_append(bits, 0);
+	assert(bits[0] == 0 && da_bits_popcount(bits) == 0);
+	da_free(bits);
+
+	uint64_t* fresh = NULL;
+	da_bits_resize(fresh, 130);
+	assert(da_size(fresh) == 130 && da_capacity(fresh) == 3);
+	assert(da_bits_popcount(fresh) == 0);
+	da_free(fresh);
+
+	printf("-- and; or; xor ------------------------------------------\n");
+	uint64_t* a = NULL;
+	uint64_t* b = NULL;
+	for (int i = 0; i < 300; ++i) {
+		da_bits_append(a, i % 2 == 0);
+	}
+	for (int i = 0; i < 200; ++i) {
+		da_bits_append(b, i % 3 == 0);
+	}
+	da_bits_and(a, b); /* only the first 200 bits */
+	for (int i = 0; i < 300; ++i) {
+		assert(da_bits_get(a, i) == (i < 200 ? i % 6 == 0 : i % 2 == 0));
+	}
+	da_bits_or(b, a); /* b is shorter: bits past 200 stay 0 */
+	assert(da_size(b) == 200 && da_bits_popcount(b) == 67);
+	assert(b[3] >> (200 % 64) == 0);
+	da_bits_xor(a, a);
+	assert(da_bits_popcount(a) == 0 && da_size(a) == 300);
+	da_bits_or(a, NULL);
+	da_free(a);
+	da_free(b);
+
+	printf("-- every instruction set ---------------------------------\n");
+	enum da_simd best = da_simd_level();
+	uint64_t* big = NULL;
+	uint64_t* mask = NULL;
+	size_t set = 0;
+	da_bits_resize(big, 100003);
+	da_bits_resize(mask, 100003);
+	for (size_t i = 0; i < 100003; i += 1 + i % 37) {
+		da_bits_set(big, i, 1);
+		++set;
+	}
+	da_bits_set_range(mask, 50000, 100003, 1);
+	for (int l = DA_SIMD_NONE; l <= (int)best; ++l) {
+		da_set_simd_level(l);
+		assert(da_bits_popcount(big) == set);
+		assert(da_bits_find(big, 0) == 0);
+		assert(da_bits_find(mask, 1) == 50000);
+		assert(da_bits_find(mask, 99999) == 99999);
+		for (size_t i = 0; i < 100003; i += 997) {
+			size_t j = i;
+			while (j < 100003 && !da_bits_get(big, j)) { ++j; }
+			assert(da_bits_find(big, i) == j);
+		}
+	}
+	da_set_simd_level(best);
+	da_bits_and(big, mask);
+	size_t upper = 0;
+	for (size_t i = 50000; i < 100003; ++i) { upper += da_bits_get(big, i); }
+	assert(da_bits_popcount(big) == upper);
+	da_free(big);
+	da_free(mask);
+
+	errno = 0;
+	uint64_t* huge = NULL;
+	da_bits_resize(huge, SIZE_MAX - 63);
+	assert(errno == ENOMEM && da_size(huge) == 0);
+	da_free(huge);
 }